@@ -0,0 +1,204 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "BindlessHeap.h"
+#include "VulkanContext.h"
+
+#include <array>
+
+namespace VulkanAbstractionLayer
+{
+    void BindlessHeap::Init(size_t virtualFrameCount, uint32_t imageCount, uint32_t samplerCount, uint32_t bufferCount)
+    {
+        auto& vulkan = GetCurrentVulkanContext();
+
+        std::array layoutBindings = {
+            vk::DescriptorSetLayoutBinding{ ImageBinding,   vk::DescriptorType::eSampledImage,  imageCount,   vk::ShaderStageFlagBits::eAll },
+            vk::DescriptorSetLayoutBinding{ SamplerBinding, vk::DescriptorType::eSampler,       samplerCount, vk::ShaderStageFlagBits::eAll },
+            vk::DescriptorSetLayoutBinding{ BufferBinding,  vk::DescriptorType::eStorageBuffer, bufferCount,  vk::ShaderStageFlagBits::eAll },
+        };
+
+        // descriptors are written while set can be bound by frames in flight, unregistered ones are never accessed
+        std::vector<vk::DescriptorBindingFlags> bindingFlags(layoutBindings.size(),
+            vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::ePartiallyBound);
+
+        vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo;
+        bindingFlagsCreateInfo.setBindingFlags(bindingFlags);
+
+        vk::DescriptorSetLayoutCreateInfo layoutCreateInfo;
+        layoutCreateInfo
+            .setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool)
+            .setBindings(layoutBindings)
+            .setPNext(&bindingFlagsCreateInfo);
+
+        this->descriptorSetLayout = vulkan.GetDevice().createDescriptorSetLayout(layoutCreateInfo);
+
+        std::array descriptorPoolSizes = {
+            vk::DescriptorPoolSize{ vk::DescriptorType::eSampledImage,  imageCount   },
+            vk::DescriptorPoolSize{ vk::DescriptorType::eSampler,       samplerCount },
+            vk::DescriptorPoolSize{ vk::DescriptorType::eStorageBuffer, bufferCount  },
+        };
+
+        vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo;
+        descriptorPoolCreateInfo
+            .setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind)
+            .setPoolSizes(descriptorPoolSizes)
+            .setMaxSets(1);
+
+        this->descriptorPool = vulkan.GetDevice().createDescriptorPool(descriptorPoolCreateInfo);
+
+        vk::DescriptorSetAllocateInfo descriptorAllocateInfo;
+        descriptorAllocateInfo
+            .setDescriptorPool(this->descriptorPool)
+            .setSetLayouts(this->descriptorSetLayout);
+
+        this->descriptorSet = vulkan.GetDevice().allocateDescriptorSets(descriptorAllocateInfo).front();
+
+        this->images = Slots{ { }, std::vector<std::vector<uint32_t>>(virtualFrameCount), 0, imageCount };
+        this->samplers = Slots{ { }, std::vector<std::vector<uint32_t>>(virtualFrameCount), 0, samplerCount };
+        this->buffers = Slots{ { }, std::vector<std::vector<uint32_t>>(virtualFrameCount), 0, bufferCount };
+    }
+
+    void BindlessHeap::Destroy()
+    {
+        auto& vulkan = GetCurrentVulkanContext();
+
+        // descriptor set is freed with pool
+        if ((bool)this->descriptorPool) vulkan.GetDevice().destroyDescriptorPool(this->descriptorPool);
+        if ((bool)this->descriptorSetLayout) vulkan.GetDevice().destroyDescriptorSetLayout(this->descriptorSetLayout);
+        this->descriptorPool = vk::DescriptorPool{ };
+        this->descriptorSetLayout = vk::DescriptorSetLayout{ };
+        this->descriptorSet = vk::DescriptorSet{ };
+        this->images = Slots{ };
+        this->samplers = Slots{ };
+        this->buffers = Slots{ };
+    }
+
+    void BindlessHeap::StartFrame(size_t frameIndex)
+    {
+        // frame fence is already waited, so indices released during this frame are no longer accessed
+        for (Slots* slots : { &this->images, &this->samplers, &this->buffers })
+        {
+            auto& releasedIndices = slots->ReleasedIndices[frameIndex];
+            slots->FreeIndices.insert(slots->FreeIndices.end(), releasedIndices.begin(), releasedIndices.end());
+            releasedIndices.clear();
+        }
+    }
+
+    uint32_t BindlessHeap::AllocateIndex(Slots& slots)
+    {
+        if (!slots.FreeIndices.empty())
+        {
+            uint32_t index = slots.FreeIndices.back();
+            slots.FreeIndices.pop_back();
+            return index;
+        }
+
+        assert(slots.NextIndex < slots.Capacity);
+        return slots.NextIndex++;
+    }
+
+    void BindlessHeap::ReleaseIndex(Slots& slots, uint32_t index)
+    {
+        assert(index < slots.NextIndex);
+        slots.ReleasedIndices[GetCurrentVulkanContext().GetCurrentVirtualFrameIndex()].push_back(index);
+    }
+
+    uint32_t BindlessHeap::RegisterImage(const Image& image, ImageView view)
+    {
+        uint32_t index = this->AllocateIndex(this->images);
+
+        vk::DescriptorImageInfo descriptorImageInfo;
+        descriptorImageInfo
+            .setImageView(image.GetNativeView(view))
+            .setImageLayout(ImageUsageToImageLayout(ImageUsage::SHADER_READ));
+
+        vk::WriteDescriptorSet writeDescriptorSet;
+        writeDescriptorSet
+            .setDstSet(this->descriptorSet)
+            .setDstBinding(ImageBinding)
+            .setDstArrayElement(index)
+            .setDescriptorType(vk::DescriptorType::eSampledImage)
+            .setImageInfo(descriptorImageInfo);
+
+        GetCurrentVulkanContext().GetDevice().updateDescriptorSets(writeDescriptorSet, { });
+        return index;
+    }
+
+    uint32_t BindlessHeap::RegisterSampler(const Sampler& sampler)
+    {
+        uint32_t index = this->AllocateIndex(this->samplers);
+
+        vk::DescriptorImageInfo descriptorImageInfo;
+        descriptorImageInfo.setSampler(sampler.GetNativeHandle());
+
+        vk::WriteDescriptorSet writeDescriptorSet;
+        writeDescriptorSet
+            .setDstSet(this->descriptorSet)
+            .setDstBinding(SamplerBinding)
+            .setDstArrayElement(index)
+            .setDescriptorType(vk::DescriptorType::eSampler)
+            .setImageInfo(descriptorImageInfo);
+
+        GetCurrentVulkanContext().GetDevice().updateDescriptorSets(writeDescriptorSet, { });
+        return index;
+    }
+
+    uint32_t BindlessHeap::RegisterBuffer(const Buffer& buffer)
+    {
+        uint32_t index = this->AllocateIndex(this->buffers);
+
+        vk::DescriptorBufferInfo descriptorBufferInfo{ buffer.GetNativeHandle(), 0, buffer.GetByteSize() };
+
+        vk::WriteDescriptorSet writeDescriptorSet;
+        writeDescriptorSet
+            .setDstSet(this->descriptorSet)
+            .setDstBinding(BufferBinding)
+            .setDstArrayElement(index)
+            .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+            .setBufferInfo(descriptorBufferInfo);
+
+        GetCurrentVulkanContext().GetDevice().updateDescriptorSets(writeDescriptorSet, { });
+        return index;
+    }
+
+    void BindlessHeap::UnregisterImage(uint32_t index)
+    {
+        this->ReleaseIndex(this->images, index);
+    }
+
+    void BindlessHeap::UnregisterSampler(uint32_t index)
+    {
+        this->ReleaseIndex(this->samplers, index);
+    }
+
+    void BindlessHeap::UnregisterBuffer(uint32_t index)
+    {
+        this->ReleaseIndex(this->buffers, index);
+    }
+}
\ No newline at end of file
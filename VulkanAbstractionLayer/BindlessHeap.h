@@ -0,0 +1,87 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+
+#include "Image.h"
+#include "Sampler.h"
+#include "Buffer.h"
+#include "DescriptorCache.h"
+
+namespace VulkanAbstractionLayer
+{
+    // one update-after-bind descriptor set shared by all pipelines. Resources are registered once and referenced in shaders by index:
+    // layout(set = 1, binding = 0) uniform texture2D uImages[];
+    // layout(set = 1, binding = 1) uniform sampler uSamplers[];
+    // layout(set = 1, binding = 2) buffer uBuffers { ... } uBufferArray[];
+    class BindlessHeap
+    {
+    public:
+        constexpr static uint32_t SetIndex = DescriptorSetIndex::BINDLESS;
+        constexpr static uint32_t ImageBinding = 0;
+        constexpr static uint32_t SamplerBinding = 1;
+        constexpr static uint32_t BufferBinding = 2;
+
+    private:
+        struct Slots
+        {
+            std::vector<uint32_t> FreeIndices;
+            std::vector<std::vector<uint32_t>> ReleasedIndices; // per virtual frame, reused when frame is started again
+            uint32_t NextIndex = 0;
+            uint32_t Capacity = 0;
+        };
+
+        vk::DescriptorPool descriptorPool;
+        vk::DescriptorSetLayout descriptorSetLayout;
+        vk::DescriptorSet descriptorSet;
+        Slots images;
+        Slots samplers;
+        Slots buffers;
+
+        uint32_t AllocateIndex(Slots& slots);
+        void ReleaseIndex(Slots& slots, uint32_t index);
+    public:
+        void Init(size_t virtualFrameCount, uint32_t imageCount, uint32_t samplerCount, uint32_t bufferCount);
+        void Destroy();
+        void StartFrame(size_t frameIndex);
+
+        uint32_t RegisterImage(const Image& image, ImageView view = ImageView::NATIVE);
+        uint32_t RegisterSampler(const Sampler& sampler);
+        uint32_t RegisterBuffer(const Buffer& buffer);
+        // index can be returned by next registration only after GPU finished using it
+        void UnregisterImage(uint32_t index);
+        void UnregisterSampler(uint32_t index);
+        void UnregisterBuffer(uint32_t index);
+
+        const vk::DescriptorSetLayout& GetDescriptorSetLayout() const { return this->descriptorSetLayout; }
+        const vk::DescriptorSet& GetDescriptorSet() const { return this->descriptorSet; }
+    };
+}
\ No newline at end of file
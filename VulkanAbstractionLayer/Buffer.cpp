@@ -32,6 +32,94 @@
 
 namespace VulkanAbstractionLayer
 {
+    vk::PipelineStageFlags BufferUsageToPipelineStage(BufferUsage::Bits layout)
+    {
+        switch (layout)
+        {
+        case BufferUsage::UNKNOWN:
+            return vk::PipelineStageFlagBits::eTopOfPipe;
+        case BufferUsage::TRANSFER_SOURCE:
+            return vk::PipelineStageFlagBits::eTransfer;
+        case BufferUsage::TRANSFER_DESTINATION:
+            return vk::PipelineStageFlagBits::eTransfer;
+        case BufferUsage::UNIFORM_TEXEL_BUFFER:
+            return vk::PipelineStageFlagBits::eVertexShader; // TODO: from other shader stages?
+        case BufferUsage::STORAGE_TEXEL_BUFFER:
+            return vk::PipelineStageFlagBits::eComputeShader;
+        case BufferUsage::UNIFORM_BUFFER:
+            return vk::PipelineStageFlagBits::eVertexShader;
+        case BufferUsage::STORAGE_BUFFER:
+            return vk::PipelineStageFlagBits::eComputeShader;
+        case BufferUsage::INDEX_BUFFER:
+            return vk::PipelineStageFlagBits::eVertexInput;
+        case BufferUsage::VERTEX_BUFFER:
+            return vk::PipelineStageFlagBits::eVertexInput;
+        case BufferUsage::INDIRECT_BUFFER:
+            return vk::PipelineStageFlagBits::eDrawIndirect;
+        case BufferUsage::SHADER_DEVICE_ADDRESS:
+            return vk::PipelineStageFlagBits::eFragmentShader; // TODO: what should be here?
+        case BufferUsage::TRANSFORM_FEEDBACK_BUFFER:
+            return vk::PipelineStageFlagBits::eTransformFeedbackEXT;
+        case BufferUsage::TRANSFORM_FEEDBACK_COUNTER_BUFFER:
+            return vk::PipelineStageFlagBits::eTransformFeedbackEXT;
+        case BufferUsage::CONDITIONAL_RENDERING:
+            return vk::PipelineStageFlagBits::eConditionalRenderingEXT;
+        case BufferUsage::ACCELERATION_STRUCTURE_BUILD_INPUT_READONLY:
+            return vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR;
+        case BufferUsage::ACCELERATION_STRUCTURE_STORAGE:
+            return vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR; // TODO: what should be here?
+        case BufferUsage::SHADER_BINDING_TABLE:
+            return vk::PipelineStageFlagBits::eFragmentShader; // TODO: what should be here?
+        default:
+            assert(false);
+            return vk::PipelineStageFlags{ };
+        }
+    }
+
+    vk::AccessFlags BufferUsageToAccessFlags(BufferUsage::Bits layout)
+    {
+        switch (layout)
+        {
+        case BufferUsage::UNKNOWN:
+            return vk::AccessFlags{ };
+        case BufferUsage::TRANSFER_SOURCE:
+            return vk::AccessFlagBits::eTransferRead;
+        case BufferUsage::TRANSFER_DESTINATION:
+            return vk::AccessFlagBits::eTransferWrite;
+        case BufferUsage::UNIFORM_TEXEL_BUFFER:
+            return vk::AccessFlagBits::eShaderRead;
+        case BufferUsage::STORAGE_TEXEL_BUFFER:
+            return vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead;
+        case BufferUsage::UNIFORM_BUFFER:
+            return vk::AccessFlagBits::eShaderRead;
+        case BufferUsage::STORAGE_BUFFER:
+            return vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead;
+        case BufferUsage::INDEX_BUFFER:
+            return vk::AccessFlagBits::eIndexRead;
+        case BufferUsage::VERTEX_BUFFER:
+            return vk::AccessFlagBits::eVertexAttributeRead;
+        case BufferUsage::INDIRECT_BUFFER:
+            return vk::AccessFlagBits::eIndirectCommandRead;
+        case BufferUsage::SHADER_DEVICE_ADDRESS:
+            return vk::AccessFlagBits::eShaderRead;
+        case BufferUsage::TRANSFORM_FEEDBACK_BUFFER:
+            return vk::AccessFlagBits::eTransformFeedbackWriteEXT;
+        case BufferUsage::TRANSFORM_FEEDBACK_COUNTER_BUFFER:
+            return vk::AccessFlagBits::eTransformFeedbackCounterWriteEXT;
+        case BufferUsage::CONDITIONAL_RENDERING:
+            return vk::AccessFlagBits::eConditionalRenderingReadEXT;
+        case BufferUsage::ACCELERATION_STRUCTURE_BUILD_INPUT_READONLY:
+            return vk::AccessFlagBits::eAccelerationStructureReadKHR;
+        case BufferUsage::ACCELERATION_STRUCTURE_STORAGE:
+            return vk::AccessFlagBits::eAccelerationStructureReadKHR;
+        case BufferUsage::SHADER_BINDING_TABLE:
+            return vk::AccessFlagBits::eShaderRead;
+        default:
+            assert(false);
+            return vk::AccessFlags{ };
+        }
+    }
+
     Buffer::Buffer(size_t byteSize, BufferUsage::Value usage, MemoryUsage memoryUsage)
     {
         this->Init(byteSize, usage, memoryUsage);
@@ -52,6 +140,7 @@ namespace VulkanAbstractionLayer
             .setQueueFamilyIndices(BufferQueueFamiliyIndicies);
 
         this->allocation = AllocateBuffer(bufferCreateInfo, memoryUsage, &this->handle);
+        this->generation = NextResourceGeneration();
     }
 
     bool Buffer::IsMemoryMapped() const
@@ -123,11 +212,13 @@ namespace VulkanAbstractionLayer
         this->byteSize = other.byteSize;
         this->allocation = other.allocation;
         this->mappedMemory = other.mappedMemory;
+        this->generation = other.generation;
 
         other.handle = vk::Buffer{ };
         other.byteSize = 0;
         other.allocation = { };
         other.mappedMemory = nullptr;
+        other.generation = 0;
     }
 
     Buffer& Buffer::operator=(Buffer&& other) noexcept
@@ -138,11 +229,13 @@ namespace VulkanAbstractionLayer
         this->byteSize = other.byteSize;
         this->allocation = other.allocation;
         this->mappedMemory = other.mappedMemory;
+        this->generation = other.generation;
 
         other.handle = vk::Buffer{ };
         other.byteSize = 0;
         other.allocation = { };
         other.mappedMemory = nullptr;
+        other.generation = 0;
         
         return *this;
     }
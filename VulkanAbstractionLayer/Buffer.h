@@ -63,12 +63,16 @@ namespace VulkanAbstractionLayer
         };
     };
 
+    vk::PipelineStageFlags BufferUsageToPipelineStage(BufferUsage::Bits usage);
+    vk::AccessFlags BufferUsageToAccessFlags(BufferUsage::Bits usage);
+
     class Buffer
     {
         vk::Buffer handle;
         size_t byteSize = 0;
         VmaAllocation allocation = { };
         uint8_t* mappedMemory = nullptr;
+        uint64_t generation = 0;
 
         void Destroy();
     public:
@@ -84,6 +88,7 @@ namespace VulkanAbstractionLayer
 
         vk::Buffer GetNativeHandle() const { return this->handle; }
         size_t GetByteSize() const { return this->byteSize; }
+        uint64_t GetGeneration() const { return this->generation; }
 
         bool IsMemoryMapped() const;
         uint8_t* MapMemory();
@@ -30,6 +30,7 @@
 #include "RenderPass.h"
 #include "Image.h"
 #include "Buffer.h"
+#include "VulkanContext.h"
 
 namespace VulkanAbstractionLayer
 {
@@ -49,8 +50,6 @@ namespace VulkanAbstractionLayer
         }
     }
 
-    vk::ShaderStageFlags PipelineTypeToShaderStages(vk::PipelineBindPoint pipelineType);
-
     void CommandBuffer::Begin()
     {
         vk::CommandBufferBeginInfo commandBufferBeginInfo;
@@ -58,14 +57,36 @@ namespace VulkanAbstractionLayer
         this->handle.begin(commandBufferBeginInfo);
     }
 
+    void CommandBuffer::BeginSecondary(const PassNative& pass)
+    {
+        vk::CommandBufferInheritanceInfo inheritanceInfo;
+        inheritanceInfo
+            .setRenderPass(pass.RenderPassHandle)
+            .setSubpass(pass.SubpassIndex)
+            .setFramebuffer(pass.Framebuffer);
+
+        vk::CommandBufferUsageFlags usageFlags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+        if ((bool)pass.RenderPassHandle) usageFlags |= vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+
+        vk::CommandBufferBeginInfo commandBufferBeginInfo;
+        commandBufferBeginInfo
+            .setFlags(usageFlags)
+            .setPInheritanceInfo(&inheritanceInfo);
+        this->handle.begin(commandBufferBeginInfo);
+    }
+
     void CommandBuffer::End()
     {
         this->handle.end();
     }
 
-    void CommandBuffer::BeginPass(const PassNative& pass)
+    static void BeginRenderPass(const vk::CommandBuffer& commandBuffer, const PassNative& pass, vk::SubpassContents contents)
     {
-        if ((bool)pass.RenderPassHandle)
+        if ((bool)pass.RenderPassHandle && pass.SubpassIndex != 0)
+        {
+            commandBuffer.nextSubpass(contents);
+        }
+        else if ((bool)pass.RenderPassHandle)
         {
             vk::RenderPassBeginInfo renderPassBeginInfo;
             renderPassBeginInfo
@@ -74,26 +95,68 @@ namespace VulkanAbstractionLayer
                 .setFramebuffer(pass.Framebuffer)
                 .setClearValues(pass.ClearValues);
 
-            this->handle.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+            commandBuffer.beginRenderPass(renderPassBeginInfo, contents);
         }
+    }
+
+    void CommandBuffer::BeginPass(const PassNative& pass)
+    {
+        BeginRenderPass(this->handle, pass, vk::SubpassContents::eInline);
+        this->BindPass(pass);
+    }
 
+    void CommandBuffer::BeginPassWithSecondaryCommands(const PassNative& pass)
+    {
+        // pipeline and descriptors are bound inside of secondary command buffers
+        BeginRenderPass(this->handle, pass, vk::SubpassContents::eSecondaryCommandBuffers);
+    }
+
+    void CommandBuffer::BindPass(const PassNative& pass)
+    {
         vk::Pipeline pipeline = pass.Pipeline;
         vk::PipelineLayout pipelineLayout = pass.PipelineLayout;
         vk::PipelineBindPoint pipelineType = pass.PipelineType;
         vk::DescriptorSet descriptorSet = pass.DescriptorSet;
 
         if ((bool)pipeline) this->handle.bindPipeline(pipelineType, pipeline);
-        if ((bool)descriptorSet) this->handle.bindDescriptorSets(pipelineType, pipelineLayout, 0, descriptorSet, { });
+        if ((bool)descriptorSet)
+        {
+            // frame and bindless sets are bound again, as pass can follow foreign pipeline or be recorded to secondary command buffer.
+            // Material set is left to the pass, see DescriptorSetIndex
+            std::array descriptorSets = { pass.FrameDescriptorSet, GetCurrentVulkanContext().GetBindlessHeap().GetDescriptorSet(), descriptorSet };
+            static_assert(DescriptorSetIndex::FRAME == 0 && DescriptorSetIndex::BINDLESS == 1 && DescriptorSetIndex::PASS == 2);
+            // dynamic buffers point to the start of their buffers until pass provides own offsets
+            constexpr uint32_t MaxDynamicOffsetCount = 32;
+            std::array<uint32_t, MaxDynamicOffsetCount> dynamicOffsets = { };
+            assert(pass.DynamicOffsetCount <= MaxDynamicOffsetCount);
+            this->handle.bindDescriptorSets(pipelineType, pipelineLayout, 0, (uint32_t)descriptorSets.size(), descriptorSets.data(), pass.DynamicOffsetCount, dynamicOffsets.data());
+        }
+    }
+
+    void CommandBuffer::BindDynamicOffsets(const PassNative& pass, ArrayView<const uint32_t> dynamicOffsets)
+    {
+        assert(dynamicOffsets.size() == pass.DynamicOffsetCount);
+        this->handle.bindDescriptorSets(pass.PipelineType, pass.PipelineLayout, DescriptorSetIndex::PASS, 1, &pass.DescriptorSet, (uint32_t)dynamicOffsets.size(), dynamicOffsets.data());
+    }
+
+    void CommandBuffer::BindMaterial(const PassNative& pass, const vk::DescriptorSet& materialSet)
+    {
+        this->handle.bindDescriptorSets(pass.PipelineType, pass.PipelineLayout, DescriptorSetIndex::MATERIAL, 1, &materialSet, 0, nullptr);
     }
 
     void CommandBuffer::EndPass(const PassNative& pass)
     {
-        if ((bool)pass.RenderPassHandle)
+        if ((bool)pass.RenderPassHandle && pass.SubpassIndex + 1 == pass.SubpassCount)
         {
             this->handle.endRenderPass();
         }
     }
 
+    void CommandBuffer::ExecuteCommands(const CommandBuffer& secondaryCommands)
+    {
+        this->handle.executeCommands(secondaryCommands.GetNativeHandle());
+    }
+
     void CommandBuffer::Draw(uint32_t vertexCount, uint32_t instanceCount)
     {
         this->handle.draw(vertexCount, instanceCount, 0, 0);
@@ -158,16 +221,20 @@ namespace VulkanAbstractionLayer
 
     void CommandBuffer::PushConstants(const PassNative& pass, const uint8_t* data, size_t size)
     {
-        constexpr size_t MaxPushConstantByteSize = 128;
+        // range is reflected from shaders, bytes which no shader stage declares are not pushed
+        if (pass.PushConstantRange.size == 0) return;
+
+        constexpr size_t MaxPushConstantByteSize = 256;
         std::array<uint8_t, MaxPushConstantByteSize> pushConstants = { };
+        assert(pass.PushConstantRange.size <= pushConstants.size());
 
-        std::memcpy(pushConstants.data(), data, size);
+        std::memcpy(pushConstants.data(), data, std::min(size, (size_t)pass.PushConstantRange.size));
 
         this->handle.pushConstants(
             pass.PipelineLayout,
-            PipelineTypeToShaderStages(pass.PipelineType),
-            0,
-            pushConstants.size(),
+            pass.PushConstantRange.stageFlags,
+            pass.PushConstantRange.offset,
+            pass.PushConstantRange.size,
             pushConstants.data()
         );
     }
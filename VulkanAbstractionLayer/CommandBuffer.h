@@ -100,9 +100,16 @@ namespace VulkanAbstractionLayer
 
         const vk::CommandBuffer& GetNativeHandle() const { return this->handle; }
         void Begin();
+        void BeginSecondary(const PassNative& renderPass);
         void End();
         void BeginPass(const PassNative& renderPass);
+        void BeginPassWithSecondaryCommands(const PassNative& renderPass);
+        void BindPass(const PassNative& renderPass);
+        // rebinds pass descriptor set, offsets of dynamic buffers are given in binding order
+        void BindDynamicOffsets(const PassNative& renderPass, ArrayView<const uint32_t> dynamicOffsets);
+        void BindMaterial(const PassNative& renderPass, const vk::DescriptorSet& materialSet);
         void EndPass(const PassNative& renderPass);
+        void ExecuteCommands(const CommandBuffer& secondaryCommands);
         void Draw(uint32_t vertexCount, uint32_t instanceCount);
         void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
         void DrawIndexed(uint32_t indexCount, uint32_t instanceCount);
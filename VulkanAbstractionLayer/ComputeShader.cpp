@@ -38,7 +38,17 @@ namespace VulkanAbstractionLayer
 
     ArrayView<const ShaderUniforms> ComputeShader::GetShaderUniforms() const
     {
-        return this->shaderUniforms;
+        return this->GetSetUniforms(DescriptorSetIndex::PASS);
+    }
+
+    ArrayView<const ShaderUniforms> ComputeShader::GetSetUniforms(uint32_t setIndex) const
+    {
+        return this->setUniforms[setIndex];
+    }
+
+    ArrayView<const ShaderPushConstants> ComputeShader::GetPushConstants() const
+    {
+        return this->pushConstants;
     }
 
     const vk::ShaderModule& ComputeShader::GetNativeShader(ShaderType type) const
@@ -47,6 +57,12 @@ namespace VulkanAbstractionLayer
         return this->computeShader;
     }
 
+    uint64_t ComputeShader::GetBytecodeHash(ShaderType type) const
+    {
+        assert(type == ShaderType::COMPUTE);
+        return this->computeBytecodeHash;
+    }
+
     void ComputeShader::Destroy()
     {
         auto& vulkan = GetCurrentVulkanContext();
@@ -73,18 +89,29 @@ namespace VulkanAbstractionLayer
         vk::ShaderModuleCreateInfo computeShaderInfo;
         computeShaderInfo.setCode(computeData.Bytecode);
         this->computeShader = vulkan.GetDevice().createShaderModule(computeShaderInfo);
-
-        // TODO: support multiple descriptor sets
-        assert(computeData.DescriptorSets.size() < 2);
-        this->shaderUniforms = std::vector{
-            ShaderUniforms{ computeData.DescriptorSets[0], ShaderType::COMPUTE }
+        this->computeBytecodeHash = HashShaderBytecode(computeData.Bytecode);
+
+        // bindless set is reflected too, but its layout is owned by context
+        assert(computeData.DescriptorSets.size() <= DescriptorSetIndex::COUNT);
+        this->setUniforms.resize(DescriptorSetIndex::COUNT);
+        for (uint32_t setIndex = 0; setIndex < DescriptorSetIndex::COUNT; setIndex++)
+        {
+            if (setIndex == DescriptorSetIndex::BINDLESS) continue;
+            this->setUniforms[setIndex] = std::vector{
+                ShaderUniforms{ setIndex < computeData.DescriptorSets.size() ? computeData.DescriptorSets[setIndex] : ShaderData::UniformBlock{ }, ShaderType::COMPUTE }
+            };
+        }
+        this->pushConstants = std::vector{
+            ShaderPushConstants{ computeData.PushConstantByteSize, ShaderType::COMPUTE }
         };
     }
 
     ComputeShader::ComputeShader(ComputeShader&& other) noexcept
     {
         this->computeShader = other.computeShader;
-        this->shaderUniforms = std::move(other.shaderUniforms);
+        this->computeBytecodeHash = other.computeBytecodeHash;
+        this->setUniforms = std::move(other.setUniforms);
+        this->pushConstants = std::move(other.pushConstants);
 
         other.computeShader = vk::ShaderModule{ };
     }
@@ -94,7 +121,9 @@ namespace VulkanAbstractionLayer
         this->Destroy();
 
         this->computeShader = other.computeShader;
-        this->shaderUniforms = std::move(other.shaderUniforms);
+        this->computeBytecodeHash = other.computeBytecodeHash;
+        this->setUniforms = std::move(other.setUniforms);
+        this->pushConstants = std::move(other.pushConstants);
 
         other.computeShader = vk::ShaderModule{ };
 
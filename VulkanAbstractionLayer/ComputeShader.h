@@ -35,7 +35,9 @@ namespace VulkanAbstractionLayer
     class ComputeShader : public Shader
     {
         vk::ShaderModule computeShader;
-        std::vector<ShaderUniforms> shaderUniforms;
+        uint64_t computeBytecodeHash = 0;
+        std::vector<std::vector<ShaderUniforms>> setUniforms; // indexed by DescriptorSetIndex
+        std::vector<ShaderPushConstants> pushConstants;
 
         void Destroy();
     public:
@@ -52,6 +54,9 @@ namespace VulkanAbstractionLayer
 
         ArrayView<const TypeSPIRV> GetInputAttributes() const override;
         ArrayView<const ShaderUniforms> GetShaderUniforms() const override;
+        ArrayView<const ShaderUniforms> GetSetUniforms(uint32_t setIndex) const override;
+        ArrayView<const ShaderPushConstants> GetPushConstants() const override;
         virtual const vk::ShaderModule& GetNativeShader(ShaderType type) const override;
+        virtual uint64_t GetBytecodeHash(ShaderType type) const override;
     };
 }
\ No newline at end of file
@@ -29,6 +29,8 @@
 #include "DescriptorBinding.h"
 #include "VulkanContext.h"
 
+#include <cstring>
+
 namespace VulkanAbstractionLayer
 {
 	Sampler EmptySampler;
@@ -103,59 +105,136 @@ namespace VulkanAbstractionLayer
 		}
 	}
 
-	void ResolveInfo::Resolve(const std::string& name, const Buffer& buffer)
+	std::vector<BufferReference>& ResolveInfo::GetBufferResolve(ResourceHandle handle)
 	{
-		assert(this->bufferResolves.find(name) == this->bufferResolves.end());
-		this->bufferResolves[name] = { buffer };
+		assert(handle != InvalidResourceHandle);
+		if (handle >= this->bufferResolves.size())
+			this->bufferResolves.resize(handle + 1);
+		assert(this->bufferResolves[handle].empty());
+		return this->bufferResolves[handle];
 	}
 
-	void ResolveInfo::Resolve(const std::string& name, ArrayView<const Buffer> buffers)
+	std::vector<ImageReference>& ResolveInfo::GetImageResolve(ResourceHandle handle)
+	{
+		assert(handle != InvalidResourceHandle);
+		if (handle >= this->imageResolves.size())
+			this->imageResolves.resize(handle + 1);
+		assert(this->imageResolves[handle].empty());
+		return this->imageResolves[handle];
+	}
+
+	void ResolveInfo::Reset()
+	{
+		// keep storage, so resolving same resources next frame does not allocate
+		for (auto& buffers : this->bufferResolves)
+			buffers.clear();
+		for (auto& images : this->imageResolves)
+			images.clear();
+	}
+
+	void ResolveInfo::Resolve(ResourceHandle handle, const Buffer& buffer)
+	{
+		this->GetBufferResolve(handle).push_back(buffer);
+	}
+
+	void ResolveInfo::Resolve(ResourceHandle handle, ArrayView<const Buffer> buffers)
 	{
-		assert(this->bufferResolves.find(name) == this->bufferResolves.end());
+		auto& bufferResolve = this->GetBufferResolve(handle);
 		for (const auto& buffer : buffers)
 		{
-			this->bufferResolves[name].push_back(buffer);
+			bufferResolve.push_back(buffer);
 		}
 	}
 
-	void ResolveInfo::Resolve(const std::string& name, ArrayView<const BufferReference> buffers)
+	void ResolveInfo::Resolve(ResourceHandle handle, ArrayView<const BufferReference> buffers)
 	{
-		assert(this->bufferResolves.find(name) == this->bufferResolves.end());
+		auto& bufferResolve = this->GetBufferResolve(handle);
 		for (const auto& buffer : buffers)
 		{
-			this->bufferResolves[name].push_back(buffer);
+			bufferResolve.push_back(buffer);
 		}
 	}
 
-	void ResolveInfo::Resolve(const std::string& name, const Image& image)
+	void ResolveInfo::Resolve(ResourceHandle handle, const Image& image)
 	{
-		assert(this->imageResolves.find(name) == this->imageResolves.end());
-		this->imageResolves[name] = { image };
+		this->GetImageResolve(handle).push_back(image);
 	}
 
-	void ResolveInfo::Resolve(const std::string& name, ArrayView<const Image> images)
+	void ResolveInfo::Resolve(ResourceHandle handle, ArrayView<const Image> images)
 	{
-		assert(this->imageResolves.find(name) == this->imageResolves.end());
+		auto& imageResolve = this->GetImageResolve(handle);
 		for (const auto& image : images)
 		{
-			this->imageResolves[name].push_back(image);
+			imageResolve.push_back(image);
 		}
 	}
 
-	void ResolveInfo::Resolve(const std::string& name, ArrayView<const ImageReference> images)
+	void ResolveInfo::Resolve(ResourceHandle handle, ArrayView<const ImageReference> images)
 	{
-		assert(this->imageResolves.find(name) == this->imageResolves.end());
+		auto& imageResolve = this->GetImageResolve(handle);
 		for (const auto& image : images)
 		{
-			this->imageResolves[name].push_back(image);
+			imageResolve.push_back(image);
 		}
 	}
 
-	size_t DescriptorBinding::AllocateBinding(const Buffer& buffer, UniformType type)
+	void ResolveInfo::Resolve(const std::string& name, const Buffer& buffer)
+	{
+		this->Resolve(InternResourceName(name), buffer);
+	}
+
+	void ResolveInfo::Resolve(const std::string& name, ArrayView<const Buffer> buffers)
+	{
+		this->Resolve(InternResourceName(name), buffers);
+	}
+
+	void ResolveInfo::Resolve(const std::string& name, ArrayView<const BufferReference> buffers)
+	{
+		this->Resolve(InternResourceName(name), buffers);
+	}
+
+	void ResolveInfo::Resolve(const std::string& name, const Image& image)
+	{
+		this->Resolve(InternResourceName(name), image);
+	}
+
+	void ResolveInfo::Resolve(const std::string& name, ArrayView<const Image> images)
+	{
+		this->Resolve(InternResourceName(name), images);
+	}
+
+	void ResolveInfo::Resolve(const std::string& name, ArrayView<const ImageReference> images)
+	{
+		this->Resolve(InternResourceName(name), images);
+	}
+
+	const std::vector<BufferReference>& ResolveInfo::GetBuffers(ResourceHandle handle) const
+	{
+		// unresolved handles are reported in release builds too, as for lookups by name
+		return this->bufferResolves.at(handle);
+	}
+
+	const std::vector<ImageReference>& ResolveInfo::GetImages(ResourceHandle handle) const
+	{
+		return this->imageResolves.at(handle);
+	}
+
+	const std::vector<BufferReference>& ResolveInfo::GetBuffers(const std::string& name) const
+	{
+		return this->bufferResolves.at(GetResourceRegistry().Get(name));
+	}
+
+	const std::vector<ImageReference>& ResolveInfo::GetImages(const std::string& name) const
+	{
+		return this->imageResolves.at(GetResourceRegistry().Get(name));
+	}
+
+	size_t DescriptorBinding::AllocateBinding(const Buffer& buffer, UniformType type, uint32_t byteSize)
 	{
 		this->bufferWriteInfos.push_back(BufferWriteInfo{
 			std::addressof(buffer),
 			UniformTypeToBufferUsage(type),
+			byteSize,
 		});
 		return this->bufferWriteInfos.size() - 1;
 	}
@@ -203,10 +282,10 @@ namespace VulkanAbstractionLayer
 		return *this;
 	}
 
-	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, const std::string& name, const Sampler& sampler, UniformType type, ImageView view)
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, ResourceHandle handle, const Sampler& sampler, UniformType type, ImageView view)
 	{
 		this->imagesToResolve.push_back(ImageToResolve{
-			name,
+			handle,
 			binding,
 			type,
 			UniformTypeToImageUsage(type),
@@ -216,30 +295,63 @@ namespace VulkanAbstractionLayer
 		return *this;
 	}
 	
-	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, const std::string& name, UniformType type, ImageView view)
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, ResourceHandle handle, UniformType type, ImageView view)
 	{
-		return this->Bind(binding, name, EmptySampler, type, view);
+		return this->Bind(binding, handle, EmptySampler, type, view);
 	}
 
-	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, const std::string& name, const Sampler& sampler, UniformType type)
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, ResourceHandle handle, const Sampler& sampler, UniformType type)
 	{
-		return this->Bind(binding, name, sampler, type, ImageView::NATIVE);
+		return this->Bind(binding, handle, sampler, type, ImageView::NATIVE);
 	}
 
-	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, const std::string& name, UniformType type)
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, ResourceHandle handle, UniformType type)
 	{
 		if (UniformTypeToBufferUsage(type) == BufferUsage::UNKNOWN) // fall back to image
-			return this->Bind(binding, name, EmptySampler, type, ImageView::NATIVE);
+			return this->Bind(binding, handle, EmptySampler, type, ImageView::NATIVE);
 		
+		return this->Bind(binding, handle, type, 0);
+	}
+
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, ResourceHandle handle, UniformType type, uint32_t byteSize)
+	{
+		assert(UniformTypeToBufferUsage(type) != BufferUsage::UNKNOWN);
+
 		this->buffersToResolve.push_back(BufferToResolve{
-			name,
+			handle,
 			binding,
 			type,
 			UniformTypeToBufferUsage(type),
+			byteSize,
 		});
 		return *this;
 	}
 
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, const std::string& name, const Sampler& sampler, UniformType type, ImageView view)
+	{
+		return this->Bind(binding, InternResourceName(name), sampler, type, view);
+	}
+
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, const std::string& name, UniformType type, ImageView view)
+	{
+		return this->Bind(binding, InternResourceName(name), type, view);
+	}
+
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, const std::string& name, const Sampler& sampler, UniformType type)
+	{
+		return this->Bind(binding, InternResourceName(name), sampler, type);
+	}
+
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, const std::string& name, UniformType type)
+	{
+		return this->Bind(binding, InternResourceName(name), type);
+	}
+
+	DescriptorBinding& DescriptorBinding::Bind(uint32_t binding, const std::string& name, UniformType type, uint32_t byteSize)
+	{
+		return this->Bind(binding, InternResourceName(name), type, byteSize);
+	}
+
 	void DescriptorBinding::Resolve(const ResolveInfo& resolve)
 	{
 		this->imageWriteInfos.clear();
@@ -248,7 +360,7 @@ namespace VulkanAbstractionLayer
 
 		for (const auto& imageToResolve : this->imagesToResolve)
 		{
-			auto& images = resolve.GetImages().at(imageToResolve.Name);
+			auto& images = resolve.GetImages(imageToResolve.Handle);
 			size_t index = 0;
 			if ((bool)imageToResolve.SamplerHandle->GetNativeHandle())
 			{
@@ -271,10 +383,10 @@ namespace VulkanAbstractionLayer
 
 		for (const auto& bufferToResolve : this->buffersToResolve)
 		{
-			auto& buffers = resolve.GetBuffers().at(bufferToResolve.Name);
+			auto& buffers = resolve.GetBuffers(bufferToResolve.Handle);
 			size_t index = 0;
 			for (const auto& buffer : buffers)
-				index = this->AllocateBinding(buffer.get(), bufferToResolve.Type);
+				index = this->AllocateBinding(buffer.get(), bufferToResolve.Type, bufferToResolve.ByteSize);
 
 			this->descriptorWrites.push_back({
 				bufferToResolve.Type,
@@ -295,6 +407,29 @@ namespace VulkanAbstractionLayer
 				uint32_t(1)
 			});
 		}
+
+		this->InvalidateRecreatedResources();
+	}
+
+	void DescriptorBinding::InvalidateRecreatedResources()
+	{
+		bool isResourceRecreated = this->resolvedGenerations.size() != this->bufferWriteInfos.size() + this->imageWriteInfos.size();
+		this->resolvedGenerations.resize(this->bufferWriteInfos.size() + this->imageWriteInfos.size());
+
+		auto generation = this->resolvedGenerations.begin();
+		auto updateGeneration = [&generation, &isResourceRecreated](uint64_t resourceGeneration)
+		{
+			isResourceRecreated |= *generation != resourceGeneration;
+			*generation++ = resourceGeneration;
+		};
+		for (const auto& bufferWriteInfo : this->bufferWriteInfos)
+			updateGeneration(bufferWriteInfo.Handle->GetGeneration());
+		for (const auto& imageWriteInfo : this->imageWriteInfos)
+			updateGeneration(imageWriteInfo.Handle != nullptr ? imageWriteInfo.Handle->GetGeneration() : 0);
+
+		// handles compared by Write can not tell recreated resources apart, so all sets are written again
+		if (isResourceRecreated)
+			this->writtenDescriptorSets.clear();
 	}
 
 	bool IsBufferType(UniformType type)
@@ -314,57 +449,161 @@ namespace VulkanAbstractionLayer
 		}
 	}
 
-	void DescriptorBinding::Write(const vk::DescriptorSet& descriptorSet)
+	template<typename T>
+	static bool IsEveryElementChanged(const std::vector<T>& writtenInfos, const std::vector<T>& infos)
+	{
+		assert(writtenInfos.size() == infos.size());
+		for (size_t i = 0; i < infos.size(); i++)
+		{
+			if (writtenInfos[i] == infos[i])
+				return false;
+		}
+		return true;
+	}
+
+	void DescriptorBinding::WriteChangedDescriptors(const vk::DescriptorSet& descriptorSet, const WrittenDescriptorSet* writtenDescriptorSet)
+	{
+		this->writesDescriptorSet.clear();
+
+		for (const auto& write : this->descriptorWrites)
+		{
+			bool isBuffer = IsBufferType(write.Type);
+			auto isElementChanged = [&](uint32_t element)
+			{
+				if (writtenDescriptorSet == nullptr) return true;
+				size_t index = (size_t)write.FirstIndex + element;
+				return isBuffer
+					? this->descriptorBufferInfos[index] != writtenDescriptorSet->BufferInfos[index]
+					: this->descriptorImageInfos[index] != writtenDescriptorSet->ImageInfos[index];
+			};
+
+			// split write into ranges of changed array elements
+			for (uint32_t element = 0; element < write.Count;)
+			{
+				if (!isElementChanged(element))
+				{
+					element++;
+					continue;
+				}
+
+				uint32_t firstElement = element;
+				for (element++; element < write.Count && isElementChanged(element); element++);
+
+				auto& writeDescriptorSet = this->writesDescriptorSet.emplace_back();
+				writeDescriptorSet
+					.setDstSet(descriptorSet)
+					.setDstBinding(write.Binding)
+					.setDstArrayElement(firstElement)
+					.setDescriptorType(ToNative(write.Type))
+					.setDescriptorCount(element - firstElement);
+
+				if (isBuffer)
+				{
+					writeDescriptorSet.setPBufferInfo(this->descriptorBufferInfos.data() + write.FirstIndex + firstElement);
+				}
+				else
+				{
+					writeDescriptorSet.setPImageInfo(this->descriptorImageInfos.data() + write.FirstIndex + firstElement);
+				}
+			}
+		}
+
+		if (!this->writesDescriptorSet.empty())
+			GetCurrentVulkanContext().GetDevice().updateDescriptorSets(this->writesDescriptorSet, { });
+	}
+
+	void DescriptorBinding::WriteWithTemplate(const vk::DescriptorSet& descriptorSet, vk::DescriptorSetLayout descriptorSetLayout)
+	{
+		auto& vulkan = GetCurrentVulkanContext();
+		// image infos are packed first, buffer infos follow them
+		size_t imageInfosByteSize = this->descriptorImageInfos.size() * sizeof(vk::DescriptorImageInfo);
+		size_t bufferInfosByteSize = this->descriptorBufferInfos.size() * sizeof(vk::DescriptorBufferInfo);
+
+		if (this->descriptorUpdateTemplateLayout != descriptorSetLayout || !(this->descriptorUpdateTemplateWrites == this->descriptorWrites))
+		{
+			std::vector<vk::DescriptorUpdateTemplateEntry> updateTemplateEntries;
+			updateTemplateEntries.reserve(this->descriptorWrites.size());
+			for (const auto& write : this->descriptorWrites)
+			{
+				if (write.Count == 0) continue;
+
+				bool isBuffer = IsBufferType(write.Type);
+				updateTemplateEntries.push_back(vk::DescriptorUpdateTemplateEntry{
+					write.Binding,
+					0,
+					write.Count,
+					ToNative(write.Type),
+					isBuffer
+						? imageInfosByteSize + write.FirstIndex * sizeof(vk::DescriptorBufferInfo)
+						: write.FirstIndex * sizeof(vk::DescriptorImageInfo),
+					isBuffer ? sizeof(vk::DescriptorBufferInfo) : sizeof(vk::DescriptorImageInfo),
+				});
+			}
+
+			this->descriptorUpdateTemplate = vulkan.GetDescriptorCache().GetDescriptorUpdateTemplate(descriptorSetLayout, updateTemplateEntries);
+			this->descriptorUpdateTemplateLayout = descriptorSetLayout;
+			this->descriptorUpdateTemplateWrites = this->descriptorWrites;
+		}
+
+		this->descriptorUpdateTemplateData.resize(imageInfosByteSize + bufferInfosByteSize);
+		if (imageInfosByteSize > 0)
+			std::memcpy(this->descriptorUpdateTemplateData.data(), this->descriptorImageInfos.data(), imageInfosByteSize);
+		if (bufferInfosByteSize > 0)
+			std::memcpy(this->descriptorUpdateTemplateData.data() + imageInfosByteSize, this->descriptorBufferInfos.data(), bufferInfosByteSize);
+
+		vulkan.GetDevice().updateDescriptorSetWithTemplate(descriptorSet, this->descriptorUpdateTemplate, this->descriptorUpdateTemplateData.data());
+	}
+
+	void DescriptorBinding::Write(const vk::DescriptorSet& descriptorSet, vk::DescriptorSetLayout descriptorSetLayout)
 	{
 		if (this->options == ResolveOptions::ALREADY_RESOLVED)
 			return;
-		if (this->options == ResolveOptions::RESOLVE_ONCE)
-			this->options = ResolveOptions::ALREADY_RESOLVED;
 
-		std::vector<vk::WriteDescriptorSet> writesDescriptorSet;
-		std::vector<vk::DescriptorBufferInfo> descriptorBufferInfos;
-		std::vector<vk::DescriptorImageInfo> descriptorImageInfos;
-		writesDescriptorSet.reserve(this->descriptorWrites.size());
-		descriptorBufferInfos.reserve(this->bufferWriteInfos.size());
-		descriptorImageInfos.reserve(this->imageWriteInfos.size());
+		auto writtenDescriptorSet = this->writtenDescriptorSets.find((VkDescriptorSet)descriptorSet);
+		bool isWrittenBefore = writtenDescriptorSet != this->writtenDescriptorSets.end();
+		// each virtual frame has its own descriptor set, every one of them is written once
+		if (this->options == ResolveOptions::RESOLVE_ONCE && isWrittenBefore)
+			return;
+
+		this->descriptorBufferInfos.clear();
+		this->descriptorImageInfos.clear();
 
 		for (const auto& bufferInfo : this->bufferWriteInfos)
 		{
-			descriptorBufferInfos.push_back(vk::DescriptorBufferInfo{
+			this->descriptorBufferInfos.push_back(vk::DescriptorBufferInfo{
 				bufferInfo.Handle->GetNativeHandle(),
 				0,
-				bufferInfo.Handle->GetByteSize(),
+				bufferInfo.ByteSize != 0 ? bufferInfo.ByteSize : bufferInfo.Handle->GetByteSize(),
 			});
 		}
 
 		for (const auto& imageInfo : this->imageWriteInfos)
 		{
-			descriptorImageInfos.push_back(vk::DescriptorImageInfo{
+			this->descriptorImageInfos.push_back(vk::DescriptorImageInfo{
 				imageInfo.SamplerHandle != nullptr ? imageInfo.SamplerHandle->GetNativeHandle() : nullptr,
 				imageInfo.Handle != nullptr ? imageInfo.Handle->GetNativeView(imageInfo.View) : nullptr,
 				ImageUsageToImageLayout(imageInfo.Usage),
 			});
 		}
 
-		for (const auto& write : this->descriptorWrites)
-		{
-			auto& writeDescriptorSet = writesDescriptorSet.emplace_back();
-			writeDescriptorSet
-				.setDstSet(descriptorSet)
-				.setDstBinding(write.Binding)
-				.setDescriptorType(ToNative(write.Type))
-				.setDescriptorCount(write.Count);
-
-			if (IsBufferType(write.Type))
-			{
-				writeDescriptorSet.setPBufferInfo(descriptorBufferInfos.data() + write.FirstIndex);
-			}
-			else
-			{
-				writeDescriptorSet.setPImageInfo(descriptorImageInfos.data() + write.FirstIndex);
-			}
-		}
-
-		GetCurrentVulkanContext().GetDevice().updateDescriptorSets(writesDescriptorSet, { });
+		// if bindings layout changed, whole set is rewritten
+		bool isSameLayout = isWrittenBefore && writtenDescriptorSet->second.Writes == this->descriptorWrites;
+
+		// template always rewrites whole set, so it is only used when every element is dirty. Otherwise plain writes
+		// of changed elements are cheaper. Update templates are core since Vulkan 1.1 and need set layout
+		bool isUpdateTemplateSupported = GetCurrentVulkanContext().GetAPIVersion() >= VK_API_VERSION_1_1 && (bool)descriptorSetLayout;
+		bool hasElements = !this->descriptorBufferInfos.empty() || !this->descriptorImageInfos.empty();
+		bool isWholeSetDirty = !isSameLayout || (IsEveryElementChanged(writtenDescriptorSet->second.BufferInfos, this->descriptorBufferInfos) &&
+			IsEveryElementChanged(writtenDescriptorSet->second.ImageInfos, this->descriptorImageInfos));
+
+		if (isUpdateTemplateSupported && hasElements && isWholeSetDirty)
+			this->WriteWithTemplate(descriptorSet, descriptorSetLayout);
+		else
+			this->WriteChangedDescriptors(descriptorSet, isSameLayout ? &writtenDescriptorSet->second : nullptr);
+
+		auto& written = this->writtenDescriptorSets[(VkDescriptorSet)descriptorSet];
+		if (!isSameLayout) written.Writes = this->descriptorWrites;
+		written.BufferInfos = this->descriptorBufferInfos;
+		written.ImageInfos = this->descriptorImageInfos;
 	}
 }
\ No newline at end of file
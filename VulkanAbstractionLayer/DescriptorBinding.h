@@ -37,15 +37,26 @@
 #include "Sampler.h"
 #include "ShaderReflection.h"
 #include "ArrayUtils.h"
+#include "ResourceHandle.h"
 
 namespace VulkanAbstractionLayer
 {
 	class ResolveInfo
 	{
-		std::unordered_map<std::string, std::vector<BufferReference>> bufferResolves;
-		std::unordered_map<std::string, std::vector<ImageReference>> imageResolves;
+		std::vector<std::vector<BufferReference>> bufferResolves;
+		std::vector<std::vector<ImageReference>> imageResolves;
 
+		std::vector<BufferReference>& GetBufferResolve(ResourceHandle handle);
+		std::vector<ImageReference>& GetImageResolve(ResourceHandle handle);
 	public:
+		void Resolve(ResourceHandle handle, const Buffer& buffer);
+		void Resolve(ResourceHandle handle, ArrayView<const Buffer> buffers);
+		void Resolve(ResourceHandle handle, ArrayView<const BufferReference> buffers);
+
+		void Resolve(ResourceHandle handle, const Image& image);
+		void Resolve(ResourceHandle handle, ArrayView<const Image> images);
+		void Resolve(ResourceHandle handle, ArrayView<const ImageReference> images);
+
 		void Resolve(const std::string& name, const Buffer& buffer);
 		void Resolve(const std::string& name, ArrayView<const Buffer> buffers);
 		void Resolve(const std::string& name, ArrayView<const BufferReference> buffers);
@@ -54,8 +65,12 @@ namespace VulkanAbstractionLayer
 		void Resolve(const std::string& name, ArrayView<const Image> images);
 		void Resolve(const std::string& name, ArrayView<const ImageReference> images);
 
-		const auto& GetBuffers() const { return this->bufferResolves; }
-		const auto& GetImages() const { return this->imageResolves; }
+		void Reset();
+
+		const std::vector<BufferReference>& GetBuffers(ResourceHandle handle) const;
+		const std::vector<ImageReference>& GetImages(ResourceHandle handle) const;
+		const std::vector<BufferReference>& GetBuffers(const std::string& name) const;
+		const std::vector<ImageReference>& GetImages(const std::string& name) const;
 	};
 
 	enum class ResolveOptions
@@ -73,12 +88,22 @@ namespace VulkanAbstractionLayer
 			uint32_t Binding;
 			uint32_t FirstIndex;
 			uint32_t Count;
+
+			bool operator==(const DescriptorWriteInfo& other) const { return this->Type == other.Type && this->Binding == other.Binding && this->FirstIndex == other.FirstIndex && this->Count == other.Count; }
+		};
+
+		struct WrittenDescriptorSet
+		{
+			std::vector<DescriptorWriteInfo> Writes;
+			std::vector<vk::DescriptorBufferInfo> BufferInfos;
+			std::vector<vk::DescriptorImageInfo> ImageInfos;
 		};
 
 		struct BufferWriteInfo
 		{
 			const Buffer* Handle;
 			BufferUsage::Bits Usage;
+			uint32_t ByteSize;
 		};
 
 		struct ImageWriteInfo
@@ -91,7 +116,7 @@ namespace VulkanAbstractionLayer
 
 		struct ImageToResolve
 		{
-			std::string Name;
+			ResourceHandle Handle;
 			uint32_t Binding;
 			UniformType Type;
 			ImageUsage::Bits Usage;
@@ -101,10 +126,11 @@ namespace VulkanAbstractionLayer
 
 		struct BufferToResolve
 		{
-			std::string Name;
+			ResourceHandle Handle;
 			uint32_t Binding;
 			UniformType Type;
 			BufferUsage::Bits Usage;
+			uint32_t ByteSize; // whole buffer if zero
 		};
 
 		struct SamplerToResolve
@@ -123,12 +149,38 @@ namespace VulkanAbstractionLayer
 
 		ResolveOptions options = ResolveOptions::RESOLVE_EACH_FRAME;
 
-		size_t AllocateBinding(const Buffer& buffer, UniformType type);
+		// native handles last written to each descriptor set, only changed array elements are updated
+		std::unordered_map<VkDescriptorSet, WrittenDescriptorSet> writtenDescriptorSets;
+		// generations of resolved resources, recreated resource can get the same native handles as destroyed one
+		std::vector<uint64_t> resolvedGenerations;
+		// kept between frames to avoid reallocations
+		std::vector<vk::WriteDescriptorSet> writesDescriptorSet;
+		std::vector<vk::DescriptorBufferInfo> descriptorBufferInfos;
+		std::vector<vk::DescriptorImageInfo> descriptorImageInfos;
+
+		// template is rebuilt only when bindings layout or descriptor set layout change
+		vk::DescriptorUpdateTemplate descriptorUpdateTemplate;
+		vk::DescriptorSetLayout descriptorUpdateTemplateLayout;
+		std::vector<DescriptorWriteInfo> descriptorUpdateTemplateWrites;
+		std::vector<uint8_t> descriptorUpdateTemplateData;
+
+		size_t AllocateBinding(const Buffer& buffer, UniformType type, uint32_t byteSize);
 		size_t AllocateBinding(const Image& image, ImageView view, UniformType type);
 		size_t AllocateBinding(const Image& image, const Sampler& sampler, ImageView view, UniformType type);
 		size_t AllocateBinding(const Sampler& sampler);
+		void InvalidateRecreatedResources();
+		void WriteChangedDescriptors(const vk::DescriptorSet& descriptorSet, const WrittenDescriptorSet* writtenDescriptorSet);
+		void WriteWithTemplate(const vk::DescriptorSet& descriptorSet, vk::DescriptorSetLayout descriptorSetLayout);
 	public:
+		DescriptorBinding& Bind(uint32_t binding, ResourceHandle handle, UniformType type);
+		// binds only byteSize bytes of buffer, used by dynamic buffers where offset is provided when descriptor set is bound
+		DescriptorBinding& Bind(uint32_t binding, ResourceHandle handle, UniformType type, uint32_t byteSize);
+		DescriptorBinding& Bind(uint32_t binding, ResourceHandle handle, UniformType type, ImageView view);
+		DescriptorBinding& Bind(uint32_t binding, ResourceHandle handle, const Sampler& sampler, UniformType type);
+		DescriptorBinding& Bind(uint32_t binding, ResourceHandle handle, const Sampler& sampler, UniformType type, ImageView view);
+
 		DescriptorBinding& Bind(uint32_t binding, const std::string& name, UniformType type);
+		DescriptorBinding& Bind(uint32_t binding, const std::string& name, UniformType type, uint32_t byteSize);
 		DescriptorBinding& Bind(uint32_t binding, const std::string& name, UniformType type, ImageView view);
 		DescriptorBinding& Bind(uint32_t binding, const std::string& name, const Sampler& sampler, UniformType type);
 		DescriptorBinding& Bind(uint32_t binding, const std::string& name, const Sampler& sampler, UniformType type, ImageView view);
@@ -139,7 +191,7 @@ namespace VulkanAbstractionLayer
 
 		void Resolve(const ResolveInfo& resolveInfo);
 
-		void Write(const vk::DescriptorSet& descriptorSet);
+		void Write(const vk::DescriptorSet& descriptorSet, vk::DescriptorSetLayout descriptorSetLayout = { });
 		const auto& GetBoundBuffers() const { return this->buffersToResolve; }
 		const auto& GetBoundImages() const { return this->imagesToResolve; }
 	};
@@ -29,58 +29,66 @@
 #include "DescriptorCache.h"
 #include "VulkanContext.h"
 
+#include <algorithm>
+
 namespace VulkanAbstractionLayer
 {
+    constexpr uint32_t MinPoolDescriptorCount = 32;
+    constexpr uint32_t MinPoolSetCount = 32;
+
+    // dynamic buffers and input attachments must not be update-after-bind (VUID-VkDescriptorSetLayoutBindingFlagsCreateInfo-pBindingFlags-03011 and 03015),
+    // layouts which contain them are created without the flag and allocated from separate pools
+    static bool IsUpdateAfterBindAllowed(VkDescriptorType descriptorType)
+    {
+        return descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC &&
+            descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC &&
+            descriptorType != VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    }
+
 	void DescriptorCache::Init()
 	{
-        auto& vulkan = GetCurrentVulkanContext();
-        // TODO: rework
-        std::array descriptorPoolSizes = {
-            vk::DescriptorPoolSize { vk::DescriptorType::eSampler,              1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eCombinedImageSampler, 1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eSampledImage,         1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eStorageImage,         1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eUniformTexelBuffer,   1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eStorageTexelBuffer,   1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eUniformBuffer,        1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eStorageBuffer,        1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eUniformBufferDynamic, 1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eStorageBufferDynamic, 1024 },
-            vk::DescriptorPoolSize { vk::DescriptorType::eInputAttachment,      1024 },
-        };
-        vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo;
-        descriptorPoolCreateInfo
-            .setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet | vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind)
-            .setPoolSizes(descriptorPoolSizes)
-            .setMaxSets(2048 * (uint32_t)descriptorPoolSizes.size());
-
-        this->descriptorPool = vulkan.GetDevice().createDescriptorPool(descriptorPoolCreateInfo);
+        // pools are created on demand, sized by what was actually allocated
 	}
 
     void DescriptorCache::Destroy()
     {
         auto& vulkan = GetCurrentVulkanContext();
-        if ((bool)this->descriptorPool) vulkan.GetDevice().destroyDescriptorPool(this->descriptorPool);
 
-        for (const auto& descriptor : this->cache)
-        {
-            this->DestroyDescriptorSetLayout(descriptor.SetLayout);
-            // descriptor sets are already freed when pool is destroyed
-        }
-        this->cache.clear();
+        // descriptor sets are already freed when pool is destroyed
+        for (const auto& descriptorPool : this->descriptorPools)
+            vulkan.GetDevice().destroyDescriptorPool(descriptorPool.Handle);
+        this->descriptorPools.clear();
+        this->allocatedSets.clear();
+        this->updateAfterBindDemand = PoolDemand{ };
+        this->bindTimeDemand = PoolDemand{ };
+
+        for (const auto& [key, updateTemplate] : this->updateTemplates)
+            vulkan.GetDevice().destroyDescriptorUpdateTemplate(updateTemplate);
+        this->updateTemplates.clear();
+
+        for (const auto& [key, layout] : this->layouts)
+            this->DestroyDescriptorSetLayout(layout);
+        this->layouts.clear();
+        this->layoutDescriptorCounts.clear();
+        this->layoutHitCount = 0;
+        this->layoutMissCount = 0;
     }
 
-    vk::DescriptorSetLayout DescriptorCache::CreateDescriptorSetLayout(ArrayView<const ShaderUniforms> specification)
+    size_t DescriptorCache::LayoutKeyHasher::operator()(const LayoutKey& key) const
     {
-        auto& vulkan = GetCurrentVulkanContext();
+        size_t hash = 14695981039346656037ull; // FNV-1a
+        for (uint32_t value : key)
+            hash = (hash ^ value) * 1099511628211ull;
+        return hash;
+    }
 
+    std::vector<vk::DescriptorSetLayoutBinding> DescriptorCache::MergeLayoutBindings(ArrayView<const ShaderUniforms> specification)
+    {
         std::vector<vk::DescriptorSetLayoutBinding> layoutBindings;
-        std::vector<vk::DescriptorBindingFlags> bindingFlags;
         size_t totalUniformCount = 0;
         for (const auto& uniformsPerStage : specification)
             totalUniformCount += uniformsPerStage.Uniforms.size();
         layoutBindings.reserve(totalUniformCount);
-        bindingFlags.reserve(totalUniformCount);
 
         for (const auto& uniformsPerStage : specification)
         {
@@ -103,36 +111,187 @@ namespace VulkanAbstractionLayer
                     uniform.Count,
                     ToNative(uniformsPerStage.ShaderStage)
                 });
+            }
+        }
+
+        // canonical order, so the same bindings declared in different order map to the same layout
+        std::sort(layoutBindings.begin(), layoutBindings.end(),
+            [](const auto& layout1, const auto& layout2) { return layout1.binding < layout2.binding; });
+        return layoutBindings;
+    }
+
+    vk::DescriptorSetLayout DescriptorCache::CreateDescriptorSetLayout(ArrayView<const vk::DescriptorSetLayoutBinding> layoutBindings)
+    {
+        auto& vulkan = GetCurrentVulkanContext();
 
-                vk::DescriptorBindingFlags descriptorBindingFlags = { };
+        bool updateAfterBind = std::all_of(layoutBindings.begin(), layoutBindings.end(), [](const auto& layoutBinding)
+        {
+            return IsUpdateAfterBindAllowed((VkDescriptorType)layoutBinding.descriptorType);
+        });
+
+        std::vector<vk::DescriptorBindingFlags> bindingFlags;
+        bindingFlags.reserve(layoutBindings.size());
+        for (const auto& layoutBinding : layoutBindings)
+        {
+            vk::DescriptorBindingFlags descriptorBindingFlags = { };
+            if (updateAfterBind)
                 descriptorBindingFlags |= vk::DescriptorBindingFlagBits::eUpdateAfterBind;
-                if (uniform.Count > 1)
-                    descriptorBindingFlags |= vk::DescriptorBindingFlagBits::ePartiallyBound;
-                bindingFlags.push_back(descriptorBindingFlags);
-            }
+            if (layoutBinding.descriptorCount > 1)
+                descriptorBindingFlags |= vk::DescriptorBindingFlagBits::ePartiallyBound;
+            bindingFlags.push_back(descriptorBindingFlags);
         }
 
         vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo;
         bindingFlagsCreateInfo.setBindingFlags(bindingFlags);
 
         vk::DescriptorSetLayoutCreateInfo layoutCreateInfo;
-        layoutCreateInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool);
-        layoutCreateInfo.setBindings(layoutBindings);
+        if (updateAfterBind)
+            layoutCreateInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool);
+        layoutCreateInfo.setBindingCount((uint32_t)layoutBindings.size());
+        layoutCreateInfo.setPBindings(layoutBindings.data());
         layoutCreateInfo.setPNext(&bindingFlagsCreateInfo);
 
         return vulkan.GetDevice().createDescriptorSetLayout(layoutCreateInfo);
     }
 
-    vk::DescriptorSet DescriptorCache::AllocateDescriptorSet(vk::DescriptorSetLayout layout)
+    vk::DescriptorPool DescriptorCache::CreateDescriptorPool(const PoolDemand& demand, bool updateAfterBind)
+    {
+        auto& vulkan = GetCurrentVulkanContext();
+
+        std::vector<vk::DescriptorPoolSize> descriptorPoolSizes;
+        for (const auto& [descriptorType, descriptorCount] : demand.DescriptorCounts)
+        {
+            descriptorPoolSizes.push_back(vk::DescriptorPoolSize{
+                (vk::DescriptorType)descriptorType, std::max(descriptorCount, MinPoolDescriptorCount)
+            });
+        }
+        // only empty layouts were requested, but pool can not be created without sizes
+        if (descriptorPoolSizes.empty())
+            descriptorPoolSizes.push_back(vk::DescriptorPoolSize{ vk::DescriptorType::eUniformBuffer, MinPoolDescriptorCount });
+
+        vk::DescriptorPoolCreateFlags descriptorPoolFlags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
+        if (updateAfterBind)
+            descriptorPoolFlags |= vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
+
+        vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo;
+        descriptorPoolCreateInfo
+            .setFlags(descriptorPoolFlags)
+            .setPoolSizes(descriptorPoolSizes)
+            .setMaxSets(std::max(demand.SetCount, MinPoolSetCount));
+
+        return vulkan.GetDevice().createDescriptorPool(descriptorPoolCreateInfo);
+    }
+
+    bool DescriptorCache::IsUpdateAfterBindLayout(vk::DescriptorSetLayout layout) const
+    {
+        // matches flags chosen in CreateDescriptorSetLayout
+        auto& descriptorCounts = this->layoutDescriptorCounts.at(layout);
+        return std::all_of(descriptorCounts.begin(), descriptorCounts.end(), [](const auto& descriptorCount)
+        {
+            return IsUpdateAfterBindAllowed(descriptorCount.first);
+        });
+    }
+
+    DescriptorCache::PoolDemand& DescriptorCache::GetPoolDemand(bool updateAfterBind)
+    {
+        return updateAfterBind ? this->updateAfterBindDemand : this->bindTimeDemand;
+    }
+
+    void DescriptorCache::AddDemand(PoolDemand& demand, vk::DescriptorSetLayout layout)
+    {
+        for (const auto& [descriptorType, descriptorCount] : this->layoutDescriptorCounts.at(layout))
+            demand.DescriptorCounts[descriptorType] += descriptorCount;
+        demand.SetCount++;
+    }
+
+    void DescriptorCache::RemoveDemand(PoolDemand& demand, vk::DescriptorSetLayout layout)
+    {
+        for (const auto& [descriptorType, descriptorCount] : this->layoutDescriptorCounts.at(layout))
+            demand.DescriptorCounts[descriptorType] -= descriptorCount;
+        demand.SetCount--;
+    }
+
+    bool DescriptorCache::TryAllocateDescriptorSet(vk::DescriptorPool pool, vk::DescriptorSetLayout layout, vk::DescriptorSet& set)
     {
         auto& vulkan = GetCurrentVulkanContext();
 
         vk::DescriptorSetAllocateInfo descriptorAllocateInfo;
         descriptorAllocateInfo
-            .setDescriptorPool(this->descriptorPool)
+            .setDescriptorPool(pool)
             .setSetLayouts(layout);
 
-        return vulkan.GetDevice().allocateDescriptorSets(descriptorAllocateInfo).front();
+        auto result = vulkan.GetDevice().allocateDescriptorSets(&descriptorAllocateInfo, &set);
+        // pool is exhausted, caller should grow instead
+        if (result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool)
+            return false;
+
+        assert(result == vk::Result::eSuccess);
+        return true;
+    }
+
+    vk::DescriptorSet DescriptorCache::AllocateDescriptorSet(vk::DescriptorSetLayout layout)
+    {
+        vk::DescriptorSet descriptorSet;
+        bool updateAfterBind = this->IsUpdateAfterBindLayout(layout);
+        auto& descriptorDemand = this->GetPoolDemand(updateAfterBind);
+        this->AddDemand(descriptorDemand, layout);
+
+        // newest pools are the largest ones, sets freed into older pools are reused too
+        auto descriptorPool = std::find_if(this->descriptorPools.rbegin(), this->descriptorPools.rend(), [this, layout, updateAfterBind, &descriptorSet](const DescriptorPool& pool)
+        {
+            return pool.UpdateAfterBind == updateAfterBind && this->TryAllocateDescriptorSet(pool.Handle, layout, descriptorSet);
+        });
+
+        DescriptorPool* allocationPool = nullptr;
+        if (descriptorPool != this->descriptorPools.rend())
+        {
+            allocationPool = std::addressof(*descriptorPool);
+        }
+        else
+        {
+            // new pool fits all live sets, so pools stop growing once demand is stable
+            this->descriptorPools.push_back(DescriptorPool{ this->CreateDescriptorPool(descriptorDemand, updateAfterBind), 0, updateAfterBind });
+            allocationPool = std::addressof(this->descriptorPools.back());
+            bool isAllocated = this->TryAllocateDescriptorSet(allocationPool->Handle, layout, descriptorSet);
+            assert(isAllocated);
+        }
+
+        allocationPool->SetCount++;
+        this->allocatedSets.emplace((VkDescriptorSet)descriptorSet, AllocatedSet{ allocationPool->Handle, layout });
+        return descriptorSet;
+    }
+
+    vk::DescriptorUpdateTemplate DescriptorCache::GetDescriptorUpdateTemplate(vk::DescriptorSetLayout layout, ArrayView<const vk::DescriptorUpdateTemplateEntry> entries)
+    {
+        LayoutKey key;
+        key.reserve(2 + entries.size() * 6);
+        uint64_t layoutHandle = (uint64_t)(VkDescriptorSetLayout)layout;
+        key.push_back((uint32_t)layoutHandle);
+        key.push_back((uint32_t)(layoutHandle >> 32));
+        for (const auto& entry : entries)
+        {
+            key.push_back(entry.dstBinding);
+            key.push_back(entry.dstArrayElement);
+            key.push_back(entry.descriptorCount);
+            key.push_back((uint32_t)entry.descriptorType);
+            key.push_back((uint32_t)entry.offset);
+            key.push_back((uint32_t)entry.stride);
+        }
+
+        auto updateTemplate = this->updateTemplates.find(key);
+        if (updateTemplate != this->updateTemplates.end())
+            return updateTemplate->second;
+
+        vk::DescriptorUpdateTemplateCreateInfo updateTemplateCreateInfo;
+        updateTemplateCreateInfo
+            .setDescriptorUpdateEntryCount((uint32_t)entries.size())
+            .setPDescriptorUpdateEntries(entries.data())
+            .setTemplateType(vk::DescriptorUpdateTemplateType::eDescriptorSet)
+            .setDescriptorSetLayout(layout);
+
+        auto descriptorUpdateTemplate = GetCurrentVulkanContext().GetDevice().createDescriptorUpdateTemplate(updateTemplateCreateInfo);
+        this->updateTemplates.emplace(std::move(key), descriptorUpdateTemplate);
+        return descriptorUpdateTemplate;
     }
 
     void DescriptorCache::DestroyDescriptorSetLayout(vk::DescriptorSetLayout layout)
@@ -142,13 +301,73 @@ namespace VulkanAbstractionLayer
 
     void DescriptorCache::FreeDescriptorSet(vk::DescriptorSet set)
     {
-        GetCurrentVulkanContext().GetDevice().freeDescriptorSets(this->descriptorPool, set);
+        auto& device = GetCurrentVulkanContext().GetDevice();
+        auto allocatedSet = this->allocatedSets.find((VkDescriptorSet)set);
+        assert(allocatedSet != this->allocatedSets.end());
+
+        device.freeDescriptorSets(allocatedSet->second.Pool, set);
+        this->RemoveDemand(this->GetPoolDemand(this->IsUpdateAfterBindLayout(allocatedSet->second.Layout)), allocatedSet->second.Layout);
+
+        auto descriptorPool = std::find_if(this->descriptorPools.begin(), this->descriptorPools.end(),
+            [pool = allocatedSet->second.Pool](const DescriptorPool& descriptorPool) { return descriptorPool.Handle == pool; });
+        assert(descriptorPool != this->descriptorPools.end());
+        this->allocatedSets.erase(allocatedSet);
+
+        // caller guarantees that freed sets are not in use, so empty pool can be destroyed immediately
+        descriptorPool->SetCount--;
+        if (descriptorPool->SetCount == 0)
+        {
+            device.destroyDescriptorPool(descriptorPool->Handle);
+            this->descriptorPools.erase(descriptorPool);
+        }
+    }
+
+    vk::DescriptorSetLayout DescriptorCache::GetDescriptorSetLayout(ArrayView<const ShaderUniforms> specification)
+    {
+        auto layoutBindings = this->MergeLayoutBindings(specification);
+
+        LayoutKey key;
+        key.reserve(layoutBindings.size() * 4);
+        for (const auto& layoutBinding : layoutBindings)
+        {
+            key.push_back(layoutBinding.binding);
+            key.push_back((uint32_t)layoutBinding.descriptorType);
+            key.push_back(layoutBinding.descriptorCount);
+            key.push_back((uint32_t)(VkShaderStageFlags)layoutBinding.stageFlags);
+        }
+
+        auto layout = this->layouts.find(key);
+        if (layout != this->layouts.end())
+        {
+            this->layoutHitCount++;
+            return layout->second;
+        }
+
+        this->layoutMissCount++;
+        auto descriptorSetLayout = this->CreateDescriptorSetLayout(layoutBindings);
+        this->layouts.emplace(std::move(key), descriptorSetLayout);
+
+        auto& descriptorCounts = this->layoutDescriptorCounts[descriptorSetLayout];
+        for (const auto& layoutBinding : layoutBindings)
+            descriptorCounts[(VkDescriptorType)layoutBinding.descriptorType] += layoutBinding.descriptorCount;
+        return descriptorSetLayout;
+    }
+
+    uint32_t DescriptorCache::GetDynamicOffsetCount(vk::DescriptorSetLayout layout) const
+    {
+        uint32_t dynamicOffsetCount = 0;
+        for (const auto& [descriptorType, descriptorCount] : this->layoutDescriptorCounts.at(layout))
+        {
+            if (descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+                dynamicOffsetCount += descriptorCount;
+        }
+        return dynamicOffsetCount;
     }
 
     DescriptorCache::Descriptor DescriptorCache::GetDescriptor(ArrayView<const ShaderUniforms> specification)
     {
-        auto descriptorSetLayout = this->CreateDescriptorSetLayout(specification);
+        auto descriptorSetLayout = this->GetDescriptorSetLayout(specification);
         auto descriptorSet = this->AllocateDescriptorSet(descriptorSetLayout);
-        return this->cache.emplace_back(Descriptor{ descriptorSetLayout, descriptorSet });
+        return Descriptor{ descriptorSetLayout, descriptorSet };
     }
 }
\ No newline at end of file
@@ -29,12 +29,27 @@
 #pragma once
 
 #include <vulkan/vulkan.hpp>
+#include <unordered_map>
 
 #include "ShaderReflection.h"
 #include "ArrayUtils.h"
 
 namespace VulkanAbstractionLayer
 {
+	// descriptor sets of every pipeline layout, ordered from the least frequently changed. Frame and bindless set layouts
+	// are the same in all pipeline layouts of render graph, so switching to pipeline of another pass does not disturb them
+	struct DescriptorSetIndex
+	{
+		enum Value : uint32_t
+		{
+			FRAME = 0,    // frame globals shared by all passes of render graph
+			BINDLESS = 1, // context bindless heap
+			PASS = 2,     // rewritten every frame by pass descriptor bindings
+			MATERIAL = 3, // bound by pass per draw
+			COUNT,
+		};
+	};
+
 	class DescriptorCache
 	{
 	public:
@@ -45,19 +60,71 @@ namespace VulkanAbstractionLayer
 		};
 
 	private:
-		vk::DescriptorPool descriptorPool;
-		std::vector<Descriptor> cache;
+		// binding, type, count and stage flags of each binding, sorted by binding
+		using LayoutKey = std::vector<uint32_t>;
 
-		vk::DescriptorSetLayout CreateDescriptorSetLayout(ArrayView<const ShaderUniforms> specification);
-		vk::DescriptorSet AllocateDescriptorSet(vk::DescriptorSetLayout layout);
+		struct LayoutKeyHasher
+		{
+			size_t operator()(const LayoutKey& key) const;
+		};
+
+		// descriptors of all live sets, sizes next pool
+		struct PoolDemand
+		{
+			std::unordered_map<VkDescriptorType, uint32_t> DescriptorCounts;
+			uint32_t SetCount = 0;
+		};
+
+		struct DescriptorPool
+		{
+			vk::DescriptorPool Handle;
+			uint32_t SetCount = 0; // pool is destroyed when its last set is freed
+			bool UpdateAfterBind = false;
+		};
+
+		struct AllocatedSet
+		{
+			vk::DescriptorPool Pool;
+			vk::DescriptorSetLayout Layout;
+		};
+
+		std::unordered_map<LayoutKey, vk::DescriptorSetLayout, LayoutKeyHasher> layouts;
+		std::unordered_map<VkDescriptorSetLayout, std::unordered_map<VkDescriptorType, uint32_t>> layoutDescriptorCounts;
+		size_t layoutHitCount = 0;
+		size_t layoutMissCount = 0;
+
+		std::vector<DescriptorPool> descriptorPools;
+		std::unordered_map<VkDescriptorSet, AllocatedSet> allocatedSets;
+		PoolDemand updateAfterBindDemand;
+		PoolDemand bindTimeDemand; // layouts with dynamic buffers or input attachments can not be update-after-bind
+
+		// set layout handle followed by fields of each template entry
+		std::unordered_map<LayoutKey, vk::DescriptorUpdateTemplate, LayoutKeyHasher> updateTemplates;
+
+		std::vector<vk::DescriptorSetLayoutBinding> MergeLayoutBindings(ArrayView<const ShaderUniforms> specification);
+		vk::DescriptorSetLayout CreateDescriptorSetLayout(ArrayView<const vk::DescriptorSetLayoutBinding> layoutBindings);
+		vk::DescriptorPool CreateDescriptorPool(const PoolDemand& demand, bool updateAfterBind);
+		bool IsUpdateAfterBindLayout(vk::DescriptorSetLayout layout) const;
+		PoolDemand& GetPoolDemand(bool updateAfterBind);
+		void AddDemand(PoolDemand& demand, vk::DescriptorSetLayout layout);
+		void RemoveDemand(PoolDemand& demand, vk::DescriptorSetLayout layout);
+		bool TryAllocateDescriptorSet(vk::DescriptorPool pool, vk::DescriptorSetLayout layout, vk::DescriptorSet& set);
 		void DestroyDescriptorSetLayout(vk::DescriptorSetLayout layout);
-		void FreeDescriptorSet(vk::DescriptorSet set);
 	public:
 
 		void Init();
 		void Destroy();
 
-		const auto& GetDescriptorPool() const { return this->descriptorPool; }
+		size_t GetDescriptorPoolCount() const { return this->descriptorPools.size(); }
+		size_t GetLayoutCount() const { return this->layouts.size(); }
+		size_t GetLayoutHitCount() const { return this->layoutHitCount; }
+		size_t GetLayoutMissCount() const { return this->layoutMissCount; }
+
+		vk::DescriptorSetLayout GetDescriptorSetLayout(ArrayView<const ShaderUniforms> specification);
+		uint32_t GetDynamicOffsetCount(vk::DescriptorSetLayout layout) const;
 		Descriptor GetDescriptor(ArrayView<const ShaderUniforms> specification);
+		vk::DescriptorSet AllocateDescriptorSet(vk::DescriptorSetLayout layout);
+		void FreeDescriptorSet(vk::DescriptorSet set);
+		vk::DescriptorUpdateTemplate GetDescriptorUpdateTemplate(vk::DescriptorSetLayout layout, ArrayView<const vk::DescriptorUpdateTemplateEntry> entries);
 	};
 }
\ No newline at end of file
@@ -65,13 +65,25 @@ namespace VulkanAbstractionLayer
         fragmentShaderInfo.setCode(fragment.Bytecode);
         this->fragmentShader = vulkan.GetDevice().createShaderModule(fragmentShaderInfo);
 
+        this->vertexBytecodeHash = HashShaderBytecode(vertex.Bytecode);
+        this->fragmentBytecodeHash = HashShaderBytecode(fragment.Bytecode);
+
         this->inputAttributes = vertex.InputAttributes;
-        // TODO: support multiple descriptor sets
-        assert(vertex.DescriptorSets.size() < 2);
-        assert(fragment.DescriptorSets.size() < 2);
-        this->shaderUniforms = std::vector{
-            ShaderUniforms{ vertex.DescriptorSets[0], ShaderType::VERTEX },
-            ShaderUniforms{ fragment.DescriptorSets[0], ShaderType::FRAGMENT },
+        // bindless set is reflected too, but its layout is owned by context
+        assert(vertex.DescriptorSets.size() <= DescriptorSetIndex::COUNT);
+        assert(fragment.DescriptorSets.size() <= DescriptorSetIndex::COUNT);
+        this->setUniforms.resize(DescriptorSetIndex::COUNT);
+        for (uint32_t setIndex = 0; setIndex < DescriptorSetIndex::COUNT; setIndex++)
+        {
+            if (setIndex == DescriptorSetIndex::BINDLESS) continue;
+            this->setUniforms[setIndex] = std::vector{
+                ShaderUniforms{ setIndex < vertex.DescriptorSets.size() ? vertex.DescriptorSets[setIndex] : ShaderData::UniformBlock{ }, ShaderType::VERTEX },
+                ShaderUniforms{ setIndex < fragment.DescriptorSets.size() ? fragment.DescriptorSets[setIndex] : ShaderData::UniformBlock{ }, ShaderType::FRAGMENT },
+            };
+        }
+        this->pushConstants = std::vector{
+            ShaderPushConstants{ vertex.PushConstantByteSize, ShaderType::VERTEX },
+            ShaderPushConstants{ fragment.PushConstantByteSize, ShaderType::FRAGMENT },
         };
     }
 
@@ -79,8 +91,11 @@ namespace VulkanAbstractionLayer
     {
         this->vertexShader = other.vertexShader;
         this->fragmentShader = other.fragmentShader;
+        this->vertexBytecodeHash = other.vertexBytecodeHash;
+        this->fragmentBytecodeHash = other.fragmentBytecodeHash;
         this->inputAttributes = std::move(other.inputAttributes);
-        this->shaderUniforms = std::move(other.shaderUniforms);
+        this->setUniforms = std::move(other.setUniforms);
+        this->pushConstants = std::move(other.pushConstants);
 
         other.vertexShader = vk::ShaderModule{ };
         other.fragmentShader = vk::ShaderModule{ };
@@ -92,8 +107,11 @@ namespace VulkanAbstractionLayer
 
         this->vertexShader = other.vertexShader;
         this->fragmentShader = other.fragmentShader;
+        this->vertexBytecodeHash = other.vertexBytecodeHash;
+        this->fragmentBytecodeHash = other.fragmentBytecodeHash;
         this->inputAttributes = std::move(other.inputAttributes);
-        this->shaderUniforms = std::move(other.shaderUniforms);
+        this->setUniforms = std::move(other.setUniforms);
+        this->pushConstants = std::move(other.pushConstants);
 
         other.vertexShader = vk::ShaderModule{ };
         other.fragmentShader = vk::ShaderModule{ };
@@ -108,7 +126,17 @@ namespace VulkanAbstractionLayer
 
     ArrayView<const ShaderUniforms> GraphicShader::GetShaderUniforms() const
     {
-        return this->shaderUniforms;
+        return this->GetSetUniforms(DescriptorSetIndex::PASS);
+    }
+
+    ArrayView<const ShaderUniforms> GraphicShader::GetSetUniforms(uint32_t setIndex) const
+    {
+        return this->setUniforms[setIndex];
+    }
+
+    ArrayView<const ShaderPushConstants> GraphicShader::GetPushConstants() const
+    {
+        return this->pushConstants;
     }
 
     const vk::ShaderModule& GraphicShader::GetNativeShader(ShaderType type) const
@@ -124,4 +152,18 @@ namespace VulkanAbstractionLayer
             return this->fragmentShader;
         }
     }
+
+    uint64_t GraphicShader::GetBytecodeHash(ShaderType type) const
+    {
+        switch (type)
+        {
+        case ShaderType::VERTEX:
+            return this->vertexBytecodeHash;
+        case ShaderType::FRAGMENT:
+            return this->fragmentBytecodeHash;
+        default:
+            assert(false);
+            return this->fragmentBytecodeHash;
+        }
+    }
 }
\ No newline at end of file
@@ -36,7 +36,10 @@ namespace VulkanAbstractionLayer
     {
         vk::ShaderModule vertexShader;
         vk::ShaderModule fragmentShader;
-        std::vector<ShaderUniforms> shaderUniforms;
+        uint64_t vertexBytecodeHash = 0;
+        uint64_t fragmentBytecodeHash = 0;
+        std::vector<std::vector<ShaderUniforms>> setUniforms; // indexed by DescriptorSetIndex
+        std::vector<ShaderPushConstants> pushConstants;
         std::vector<TypeSPIRV> inputAttributes;
 
         void Destroy();
@@ -55,6 +58,9 @@ namespace VulkanAbstractionLayer
 
         ArrayView<const TypeSPIRV> GetInputAttributes() const override;
         ArrayView<const ShaderUniforms> GetShaderUniforms() const override;
+        ArrayView<const ShaderUniforms> GetSetUniforms(uint32_t setIndex) const override;
+        ArrayView<const ShaderPushConstants> GetPushConstants() const override;
         virtual const vk::ShaderModule& GetNativeShader(ShaderType type) const override;
+        virtual uint64_t GetBytecodeHash(ShaderType type) const override;
     };
 }
\ No newline at end of file
@@ -47,7 +47,7 @@ namespace VulkanAbstractionLayer
         init_info.Device = vulkanContext.GetDevice();
         init_info.QueueFamily = vulkanContext.GetQueueFamilyIndex();
         init_info.Queue = vulkanContext.GetGraphicsQueue();
-        init_info.PipelineCache = vk::PipelineCache{ };
+        init_info.PipelineCache = vulkanContext.GetPipelineCache();
         init_info.Allocator = nullptr;
         init_info.InFlyFrameCount = vulkanContext.GetVirtualFrameCount();
         init_info.MinImageCount = vulkanContext.GetPresentImageCount();
@@ -80,7 +80,7 @@ namespace VulkanAbstractionLayer
         case VulkanAbstractionLayer::ImageUsage::DEPTH_SPENCIL_ATTACHMENT:
             return vk::ImageLayout::eDepthStencilAttachmentOptimal;
         case VulkanAbstractionLayer::ImageUsage::INPUT_ATTACHMENT:
-            return vk::ImageLayout::eAttachmentOptimalKHR; // TODO: is it ok?
+            return vk::ImageLayout::eShaderReadOnlyOptimal; // attachment optimal layouts need synchronization2, which is not enabled
         case VulkanAbstractionLayer::ImageUsage::FRAGMENT_SHADING_RATE_ATTACHMENT:
             return vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR;
         default:
@@ -197,7 +197,11 @@ namespace VulkanAbstractionLayer
     {
         if ((bool)this->handle)
         {
-            if ((bool)this->allocation) // allocated
+            if (this->isMemoryAliased) // memory is owned externally
+            {
+                GetCurrentVulkanContext().GetDevice().destroyImage(this->handle);
+            }
+            else if ((bool)this->allocation) // allocated
             {
                 DeallocateImage(this->handle, this->allocation);
             }
@@ -223,6 +227,8 @@ namespace VulkanAbstractionLayer
             this->extent = vk::Extent2D{ 0u, 0u };
             this->mipLevelCount = 1;
             this->layerCount = 1;
+            this->allocation = { };
+            this->isMemoryAliased = false;
         }
     }
 
@@ -230,6 +236,7 @@ namespace VulkanAbstractionLayer
     {
         this->handle = image;
         this->format = format;
+        this->generation = NextResourceGeneration();
 
         auto& Vulkan = GetCurrentVulkanContext();
         auto subresourceRange = GetDefaultImageSubresourceRange(*this);
@@ -313,6 +320,11 @@ namespace VulkanAbstractionLayer
         this->Init(width, height, format, usage, memoryUsage, options);
     }
 
+    Image::Image(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, VmaAllocation aliasedMemory, ImageOptions::Value options)
+    {
+        this->Init(width, height, format, usage, aliasedMemory, options);
+    }
+
     Image::Image(vk::Image image, uint32_t width, uint32_t height, Format format)
     {
         this->extent = vk::Extent2D{ width, height };
@@ -328,8 +340,10 @@ namespace VulkanAbstractionLayer
         this->extent = other.extent;
         this->format = other.format;
         this->allocation = other.allocation;
+        this->isMemoryAliased = other.isMemoryAliased;
         this->mipLevelCount = other.mipLevelCount;
         this->layerCount = other.layerCount;
+        this->generation = other.generation;
 
         other.handle = vk::Image{ };
         other.defaultImageViews = { };
@@ -337,8 +351,10 @@ namespace VulkanAbstractionLayer
         other.extent = vk::Extent2D{ 0u, 0u };
         other.format = Format::UNDEFINED;
         other.allocation = { };
+        other.isMemoryAliased = false;
         other.mipLevelCount = 1;
         other.layerCount = 1;
+        other.generation = 0;
     }
 
     Image& Image::operator=(Image&& other) noexcept
@@ -351,8 +367,10 @@ namespace VulkanAbstractionLayer
         this->extent = other.extent;
         this->format = other.format;
         this->allocation = other.allocation;
+        this->isMemoryAliased = other.isMemoryAliased;
         this->mipLevelCount = other.mipLevelCount;
         this->layerCount = other.layerCount;
+        this->generation = other.generation;
 
         other.handle = vk::Image{ };
         other.defaultImageViews = { };
@@ -360,8 +378,10 @@ namespace VulkanAbstractionLayer
         other.extent = vk::Extent2D{ 0u, 0u };
         other.format = Format::UNDEFINED;
         other.allocation = { };
+        other.isMemoryAliased = false;
         other.mipLevelCount = 1;
         other.layerCount = 1;
+        other.generation = 0;
 
         return *this;
     }
@@ -371,19 +391,16 @@ namespace VulkanAbstractionLayer
         this->Destroy();
     }
 
-    void Image::Init(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, MemoryUsage memoryUsage, ImageOptions::Value options)
+    static vk::ImageCreateInfo GetImageCreateInfo(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, ImageOptions::Value options)
     {
-        this->mipLevelCount = CalculateImageMipLevelCount(options, width, height);
-        this->layerCount = CalculateImageLayerCount(options);
-
         vk::ImageCreateInfo imageCreateInfo;
         imageCreateInfo
             .setImageType(vk::ImageType::e2D)
             .setFormat(ToNative(format))
             .setExtent(vk::Extent3D{ width, height, 1 })
             .setSamples(vk::SampleCountFlagBits::e1)
-            .setMipLevels(this->GetMipLevelCount())
-            .setArrayLayers(this->layerCount)
+            .setMipLevels(CalculateImageMipLevelCount(options, width, height))
+            .setArrayLayers(CalculateImageLayerCount(options))
             .setTiling(vk::ImageTiling::eOptimal)
             .setUsage((vk::ImageUsageFlags)usage)
             .setSharingMode(vk::SharingMode::eExclusive)
@@ -391,12 +408,46 @@ namespace VulkanAbstractionLayer
 
         if (options & ImageOptions::CUBEMAP)
             imageCreateInfo.setFlags(vk::ImageCreateFlagBits::eCubeCompatible);
+
+        return imageCreateInfo;
+    }
+
+    vk::MemoryRequirements GetImageMemoryRequirements(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, ImageOptions::Value options)
+    {
+        auto& device = GetCurrentVulkanContext().GetDevice();
+        auto image = device.createImage(GetImageCreateInfo(width, height, format, usage, options));
+        auto memoryRequirements = device.getImageMemoryRequirements(image);
+        device.destroyImage(image);
+        return memoryRequirements;
+    }
+
+    void Image::Init(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, MemoryUsage memoryUsage, ImageOptions::Value options)
+    {
+        this->mipLevelCount = CalculateImageMipLevelCount(options, width, height);
+        this->layerCount = CalculateImageLayerCount(options);
+
+        auto imageCreateInfo = GetImageCreateInfo(width, height, format, usage, options);
         
         this->extent = vk::Extent2D{ (uint32_t)width, (uint32_t)height };
         this->allocation = AllocateImage(imageCreateInfo, memoryUsage, &this->handle);
         this->InitViews(this->handle, format);
     }
 
+    void Image::Init(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, VmaAllocation aliasedMemory, ImageOptions::Value options)
+    {
+        this->mipLevelCount = CalculateImageMipLevelCount(options, width, height);
+        this->layerCount = CalculateImageLayerCount(options);
+
+        auto imageCreateInfo = GetImageCreateInfo(width, height, format, usage, options);
+
+        this->extent = vk::Extent2D{ (uint32_t)width, (uint32_t)height };
+        this->allocation = aliasedMemory;
+        this->isMemoryAliased = true;
+        this->handle = GetCurrentVulkanContext().GetDevice().createImage(imageCreateInfo);
+        BindImageMemory(this->handle, this->allocation);
+        this->InitViews(this->handle, format);
+    }
+
     vk::ImageView Image::GetNativeView(ImageView view) const
     {
         switch (view)
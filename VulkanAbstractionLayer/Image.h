@@ -56,6 +56,7 @@ namespace VulkanAbstractionLayer
             DEPTH_SPENCIL_ATTACHMENT = (Value)vk::ImageUsageFlagBits::eDepthStencilAttachment,
             INPUT_ATTACHMENT = (Value)vk::ImageUsageFlagBits::eInputAttachment,
             FRAGMENT_SHADING_RATE_ATTACHMENT = (Value)vk::ImageUsageFlagBits::eFragmentShadingRateAttachmentKHR,
+            TRANSIENT_ATTACHMENT = (Value)vk::ImageUsageFlagBits::eTransientAttachment,
         };
     };
 
@@ -100,18 +101,22 @@ namespace VulkanAbstractionLayer
         uint32_t layerCount = 1;
         Format format = Format::UNDEFINED;
         VmaAllocation allocation = { };
+        bool isMemoryAliased = false;
+        uint64_t generation = 0;
 
         void Destroy();
         void InitViews(const vk::Image& image, Format format);
     public:
         Image() = default;
         Image(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, MemoryUsage memoryUsage, ImageOptions::Value options);
+        Image(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, VmaAllocation aliasedMemory, ImageOptions::Value options);
         Image(vk::Image image, uint32_t width, uint32_t height, Format format);
         Image(Image&& other) noexcept;
         Image& operator=(Image&& other) noexcept;
         ~Image();
 
         void Init(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, MemoryUsage memoryUsage, ImageOptions::Value options);
+        void Init(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, VmaAllocation aliasedMemory, ImageOptions::Value options);
 
         vk::ImageView GetNativeView(ImageView view) const;
         vk::ImageView GetNativeView(ImageView view, uint32_t layer) const;
@@ -124,6 +129,8 @@ namespace VulkanAbstractionLayer
         uint32_t GetHeight() const { return this->extent.height; }
         uint32_t GetMipLevelCount() const { return this->mipLevelCount; }
         uint32_t GetLayerCount() const { return this->layerCount; }
+        bool IsMemoryAliased() const { return this->isMemoryAliased; }
+        uint64_t GetGeneration() const { return this->generation; }
     };
 
     vk::ImageSubresourceLayers GetDefaultImageSubresourceLayers(const Image& image);
@@ -132,6 +139,7 @@ namespace VulkanAbstractionLayer
 
     uint32_t CalculateImageMipLevelCount(ImageOptions::Value options, uint32_t width, uint32_t height);
     uint32_t CalculateImageLayerCount(ImageOptions::Value options);
+    vk::MemoryRequirements GetImageMemoryRequirements(uint32_t width, uint32_t height, Format format, ImageUsage::Value usage, ImageOptions::Value options);
 
     using ImageReference = std::reference_wrapper<const Image>;
 }
\ No newline at end of file
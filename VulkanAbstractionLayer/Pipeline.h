@@ -44,6 +44,54 @@ namespace VulkanAbstractionLayer
         CLEAR_DEPTH_SPENCIL,
     };
 
+    enum class CullMode
+    {
+        NONE = 0,
+        FRONT,
+        BACK,
+    };
+
+    enum class BlendMode
+    {
+        DISABLED = 0,
+        ALPHA_BLEND,
+        ADDITIVE,
+    };
+
+    enum class CompareOperation
+    {
+        NEVER = 0,
+        LESS,
+        EQUAL,
+        LESS_OR_EQUAL,
+        GREATER,
+        NOT_EQUAL,
+        GREATER_OR_EQUAL,
+        ALWAYS,
+    };
+
+    enum class PrimitiveTopology
+    {
+        POINT_LIST = 0,
+        LINE_LIST,
+        LINE_STRIP,
+        TRIANGLE_LIST,
+        TRIANGLE_STRIP,
+        TRIANGLE_FAN,
+    };
+
+    // fixed-function state of graphic pipeline, defaults match what every pipeline used before
+    struct FixedFunctionState
+    {
+        CullMode Cull = CullMode::BACK;
+        BlendMode Blend = BlendMode::ALPHA_BLEND;
+        bool DepthTestEnable = true;
+        bool DepthWriteEnable = true;
+        CompareOperation DepthCompare = CompareOperation::LESS;
+        PrimitiveTopology Topology = PrimitiveTopology::TRIANGLE_LIST;
+        uint32_t SampleCount = 1;
+    };
+
     class Pipeline
     {
     public:
@@ -100,6 +148,7 @@ namespace VulkanAbstractionLayer
         std::shared_ptr<Shader> Shader;
         std::vector<VertexBinding> VertexBindings;
         DescriptorBinding DescriptorBindings;
+        FixedFunctionState State;
 
         void AddOutputAttachment(const std::string& name, ClearColor clear);
         void AddOutputAttachment(const std::string& name, ClearDepthStencil clear);
@@ -0,0 +1,88 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "PipelineStateCache.h"
+#include "VulkanContext.h"
+
+namespace VulkanAbstractionLayer
+{
+    void PipelineStateKey::Append(const PipelineStateKey& other)
+    {
+        for (uint64_t word : other.words)
+            this->Add(word);
+    }
+
+    void PipelineStateCache::Destroy()
+    {
+        auto& device = GetCurrentVulkanContext().GetDevice();
+        for (const auto& [key, pipeline] : this->cache)
+            device.destroyPipeline(pipeline);
+        this->cache.clear();
+
+        for (const auto& [key, layout] : this->layouts)
+            device.destroyPipelineLayout(layout);
+        this->layouts.clear();
+    }
+
+    vk::Pipeline PipelineStateCache::Find(const PipelineStateKey& key) const
+    {
+        auto entry = this->cache.find(key);
+        return entry != this->cache.end() ? entry->second : vk::Pipeline{ };
+    }
+
+    void PipelineStateCache::Insert(PipelineStateKey key, vk::Pipeline pipeline)
+    {
+        assert(this->cache.find(key) == this->cache.end());
+        this->cache.emplace(std::move(key), pipeline);
+    }
+
+    vk::PipelineLayout PipelineStateCache::GetPipelineLayout(ArrayView<const vk::DescriptorSetLayout> descriptorSetLayouts, const vk::PushConstantRange& pushConstantRange)
+    {
+        PipelineStateKey key;
+        for (const auto& descriptorSetLayout : descriptorSetLayouts)
+            key.Add(static_cast<VkDescriptorSetLayout>(descriptorSetLayout));
+        key.Add((VkShaderStageFlags)pushConstantRange.stageFlags);
+        key.Add(pushConstantRange.offset);
+        key.Add(pushConstantRange.size);
+
+        auto layout = this->layouts.find(key);
+        if (layout != this->layouts.end())
+            return layout->second;
+
+        vk::PipelineLayoutCreateInfo layoutCreateInfo;
+        layoutCreateInfo
+            .setSetLayoutCount((uint32_t)descriptorSetLayouts.size())
+            .setPSetLayouts(descriptorSetLayouts.data());
+        if (pushConstantRange.size > 0)
+            layoutCreateInfo.setPushConstantRanges(pushConstantRange);
+
+        auto pipelineLayout = GetCurrentVulkanContext().GetDevice().createPipelineLayout(layoutCreateInfo);
+        this->layouts.emplace(std::move(key), pipelineLayout);
+        return pipelineLayout;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+#include "ArrayUtils.h"
+
+namespace VulkanAbstractionLayer
+{
+    // words describing everything which affects pipeline creation. Keys are compared word by word, so collisions of the key
+    // hash only cost a comparison. Shaders are added as 64-bit bytecode hashes though (see HashShaderBytecode), so two
+    // shaders with colliding bytecode hashes would share a pipeline
+    class PipelineStateKey
+    {
+        std::vector<uint64_t> words;
+        size_t hash = 14695981039346656037ull;
+
+    public:
+        template<typename T>
+        void Add(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(uint64_t));
+            uint64_t word = 0;
+            std::memcpy(&word, &value, sizeof(T));
+            this->words.push_back(word);
+            this->hash = (this->hash ^ (size_t)word) * 1099511628211ull;
+        }
+
+        void Append(const PipelineStateKey& other);
+
+        size_t GetHash() const { return this->hash; }
+        bool operator==(const PipelineStateKey& other) const { return this->words == other.words; }
+
+        struct Hasher
+        {
+            size_t operator()(const PipelineStateKey& key) const { return key.GetHash(); }
+        };
+    };
+
+    // context-wide storage of created pipelines, not thread safe
+    class PipelineStateCache
+    {
+        std::unordered_map<PipelineStateKey, vk::Pipeline, PipelineStateKey::Hasher> cache;
+        std::unordered_map<PipelineStateKey, vk::PipelineLayout, PipelineStateKey::Hasher> layouts;
+
+    public:
+        void Destroy();
+
+        vk::Pipeline Find(const PipelineStateKey& key) const;
+        void Insert(PipelineStateKey key, vk::Pipeline pipeline);
+        size_t GetPipelineCount() const { return this->cache.size(); }
+
+        // layouts with equal set layouts and push constant range are shared, so descriptors stay bound between passes
+        vk::PipelineLayout GetPipelineLayout(ArrayView<const vk::DescriptorSetLayout> descriptorSetLayouts, const vk::PushConstantRange& pushConstantRange);
+    };
+}
\ No newline at end of file
@@ -30,12 +30,105 @@
 #include "VulkanContext.h"
 #include "CommandBuffer.h"
 
+#include <algorithm>
+
 namespace VulkanAbstractionLayer
 {
-    RenderGraph::RenderGraph(std::vector<RenderGraphNode> nodes, std::unordered_map<std::string, Image> attachments, const std::string& outputName, PresentCallback onPresent, CreateCallback onCreate)
-        : nodes(std::move(nodes)), attachments(std::move(attachments)), outputName(std::move(outputName)), onPresent(std::move(onPresent)), onCreate(std::move(onCreate))
+    RenderGraph::RenderGraph(std::vector<RenderGraphNode> nodes, std::unordered_map<std::string, Image> attachments, std::vector<VmaAllocation> attachmentMemory, const std::string& outputName, PresentCallback onPresent, CreateCallback onCreate, RenderGraphStatistics statistics, std::vector<AsyncComputeBatch> asyncComputeBatches, FrameDescriptors frameDescriptors)
+        : nodes(std::move(nodes)), attachments(std::move(attachments)), attachmentMemory(std::move(attachmentMemory)), outputName(std::move(outputName)), onPresent(std::move(onPresent)), onCreate(std::move(onCreate)), statistics(std::move(statistics)), asyncComputeBatches(std::move(asyncComputeBatches)), frameDescriptors(std::move(frameDescriptors))
+    {
+        for (size_t i = 0; i < this->nodes.size(); i++)
+        {
+            auto handle = InternResourceName(this->nodes[i].Name);
+            if (handle >= this->nodeIndices.size())
+                this->nodeIndices.resize(handle + 1, this->nodes.size());
+            this->nodeIndices[handle] = i;
+        }
+        for (const auto& [attachmentName, attachment] : this->attachments)
+        {
+            auto handle = InternResourceName(attachmentName);
+            if (handle >= this->attachmentsByHandle.size())
+                this->attachmentsByHandle.resize(handle + 1, nullptr);
+            this->attachmentsByHandle[handle] = std::addressof(attachment);
+        }
+        this->CreateSecondaryCommandBuffers();
+        this->CreateAsyncComputeResources();
+    }
+
+    void RenderGraph::CreateAsyncComputeResources()
     {
+        if (this->asyncComputeBatches.empty()) return;
+
+        auto& vulkan = GetCurrentVulkanContext();
+        auto& device = vulkan.GetDevice();
+
+        for (size_t frameIndex = 0; frameIndex < vulkan.GetVirtualFrameCount(); frameIndex++)
+        {
+            vk::CommandPoolCreateInfo commandPoolCreateInfo;
+            commandPoolCreateInfo
+                .setQueueFamilyIndex(vulkan.GetComputeQueueFamilyIndex())
+                .setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+            auto commandPool = device.createCommandPool(commandPoolCreateInfo);
+
+            vk::CommandBufferAllocateInfo commandBufferAllocateInfo;
+            commandBufferAllocateInfo
+                .setCommandPool(commandPool)
+                .setCommandBufferCount((uint32_t)this->asyncComputeBatches.size())
+                .setLevel(vk::CommandBufferLevel::ePrimary);
+
+            this->asyncComputeCommandPools.push_back(commandPool);
+            this->asyncComputeCommandBuffers.push_back(device.allocateCommandBuffers(commandBufferAllocateInfo));
 
+            auto& graphicsToCompute = this->graphicsToComputeSemaphores.emplace_back();
+            auto& computeToGraphics = this->computeToGraphicsSemaphores.emplace_back();
+            for (size_t batchIndex = 0; batchIndex < this->asyncComputeBatches.size(); batchIndex++)
+            {
+                graphicsToCompute.push_back(device.createSemaphore(vk::SemaphoreCreateInfo{ }));
+                computeToGraphics.push_back(device.createSemaphore(vk::SemaphoreCreateInfo{ }));
+            }
+        }
+    }
+
+    void RenderGraph::CreateSecondaryCommandBuffers()
+    {
+        auto& vulkan = GetCurrentVulkanContext();
+        auto& device = vulkan.GetDevice();
+
+        size_t parallelNodeCount = 0;
+        this->secondaryCommandPools.resize(this->nodes.size());
+        this->secondaryCommandBuffers.resize(this->nodes.size());
+        this->beforeRenderCommandBuffers.resize(this->nodes.size());
+        for (size_t i = 0; i < this->nodes.size(); i++)
+        {
+            if (!this->nodes[i].RecordInParallel) continue;
+            parallelNodeCount++;
+
+            for (size_t frameIndex = 0; frameIndex < vulkan.GetVirtualFrameCount(); frameIndex++)
+            {
+                vk::CommandPoolCreateInfo commandPoolCreateInfo;
+                commandPoolCreateInfo
+                    .setQueueFamilyIndex(vulkan.GetQueueFamilyIndex())
+                    .setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+                auto commandPool = device.createCommandPool(commandPoolCreateInfo);
+
+                vk::CommandBufferAllocateInfo commandBufferAllocateInfo;
+                commandBufferAllocateInfo
+                    .setCommandPool(commandPool)
+                    .setCommandBufferCount(2)
+                    .setLevel(vk::CommandBufferLevel::eSecondary);
+                auto commandBuffers = device.allocateCommandBuffers(commandBufferAllocateInfo);
+
+                this->secondaryCommandPools[i].push_back(commandPool);
+                this->secondaryCommandBuffers[i].push_back(commandBuffers[0]);
+                this->beforeRenderCommandBuffers[i].push_back(commandBuffers[1]);
+            }
+        }
+
+        if (parallelNodeCount > 0)
+        {
+            size_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1; // leave one core for the primary recording thread
+            this->workerPool = std::make_unique<WorkerPool>(std::min(threadCount, parallelNodeCount));
+        }
     }
 
     void RenderGraph::InitializeOnFirstFrame(CommandBuffer& commandBuffer)
@@ -50,35 +143,233 @@ namespace VulkanAbstractionLayer
     void RenderGraph::ExecuteRenderGraphNode(RenderGraphNode& node, CommandBuffer& commandBuffer, ResolveInfo& resolve)
     {
         RenderPassState state{ *this, commandBuffer, node.PassNative };
+        size_t nodeIndex = std::addressof(node) - this->nodes.data();
 
-        node.PassCustom->ResolveResources(resolve);
-        node.Descriptors.Resolve(resolve);
-        node.Descriptors.Write(node.PassNative.DescriptorSet);
-
-        node.PassCustom->BeforeRender(state);
+        this->BeforeRenderPassGroup(nodeIndex, commandBuffer, resolve);
         node.PipelineBarrierCallback(commandBuffer, resolve);
 
         commandBuffer.BeginPass(node.PassNative);
         node.PassCustom->OnRender(state);
         commandBuffer.EndPass(node.PassNative);
 
-        node.PassCustom->AfterRender(state);
+        this->AfterRenderPassGroup(nodeIndex, commandBuffer);
+    }
+
+    void RenderGraph::BeforeRenderPassGroup(size_t nodeIndex, CommandBuffer& commandBuffer, ResolveInfo& resolve)
+    {
+        // callbacks can record copies and barriers, which are not allowed inside of render pass instance,
+        // so callbacks of merged subpasses are run before the first subpass begins
+        if (this->nodes[nodeIndex].PassNative.SubpassIndex != 0) return;
+
+        for (size_t i = nodeIndex; i < nodeIndex + this->nodes[nodeIndex].PassNative.SubpassCount; i++)
+        {
+            auto& node = this->nodes[i];
+            this->WriteRenderGraphNodeDescriptors(node, resolve);
+            node.PassCustom->BeforeRender(RenderPassState{ *this, commandBuffer, node.PassNative });
+        }
+    }
+
+    void RenderGraph::AfterRenderPassGroup(size_t nodeIndex, CommandBuffer& commandBuffer)
+    {
+        // run after the last subpass ends the render pass
+        const auto& pass = this->nodes[nodeIndex].PassNative;
+        if (pass.SubpassIndex + 1 != pass.SubpassCount) return;
+
+        for (size_t i = nodeIndex - pass.SubpassIndex; i <= nodeIndex; i++)
+        {
+            auto& node = this->nodes[i];
+            node.PassCustom->AfterRender(RenderPassState{ *this, commandBuffer, node.PassNative });
+        }
+    }
+
+    void RenderGraph::WriteFrameDescriptors(ResolveInfo& resolve)
+    {
+        auto& frame = this->frameDescriptors;
+        if (frame.Sets.empty()) return;
+
+        if ((bool)frame.OnResolve) frame.OnResolve(resolve);
+        frame.Bindings.Resolve(resolve);
+        frame.Bindings.Write(frame.Sets[GetCurrentVulkanContext().GetCurrentVirtualFrameIndex()], frame.SetLayout);
+    }
+
+    void RenderGraph::WriteRenderGraphNodeDescriptors(RenderGraphNode& node, ResolveInfo& resolve)
+    {
+        auto& pass = node.PassNative;
+        auto frameIndex = GetCurrentVulkanContext().GetCurrentVirtualFrameIndex();
+        if (!pass.DescriptorSets.empty())
+            pass.DescriptorSet = pass.DescriptorSets[frameIndex];
+        if (!this->frameDescriptors.Sets.empty())
+            pass.FrameDescriptorSet = this->frameDescriptors.Sets[frameIndex];
+
+        node.Descriptors.Resolve(resolve);
+        node.Descriptors.Write(pass.DescriptorSet, pass.DescriptorSetLayout);
+    }
+
+    void RenderGraph::ResolveRenderGraphNodeResources(size_t nodeIndex)
+    {
+        // merged subpasses emit their barriers before render pass begins, so resolve whole group at once
+        auto& node = this->nodes[nodeIndex];
+        if (node.PassNative.SubpassIndex != 0) return;
+
+        for (size_t subpassIndex = 0; subpassIndex < node.PassNative.SubpassCount; subpassIndex++)
+            this->nodes[nodeIndex + subpassIndex].PassCustom->ResolveResources(this->resolveInfo);
+    }
+
+    void RenderGraph::RecordSecondaryCommandBuffer(size_t nodeIndex, size_t frameIndex)
+    {
+        auto& node = this->nodes[nodeIndex];
+        CommandBuffer commandBuffer{ this->secondaryCommandBuffers[nodeIndex][frameIndex] };
+        RenderPassState state{ *this, commandBuffer, node.PassNative };
+
+        commandBuffer.BeginSecondary(node.PassNative);
+        commandBuffer.BindPass(node.PassNative);
+        node.PassCustom->OnRender(state);
+        commandBuffer.End();
+    }
+
+    void RenderGraph::ExecuteRenderGraphNodesInParallel(size_t firstNodeIndex, size_t lastNodeIndex, CommandBuffer& commandBuffer, ResolveInfo& resolve)
+    {
+        auto& vulkan = GetCurrentVulkanContext();
+        size_t frameIndex = vulkan.GetCurrentVirtualFrameIndex();
+
+        // callbacks other than OnRender can touch state shared between passes, so they run on calling thread in graph order
+        // before any pass is recorded. Their commands go to separate secondary buffer of each node, which is executed right
+        // before barriers of the node, so they stay ordered with barriers and render passes of previous nodes
+        for (size_t i = firstNodeIndex; i < lastNodeIndex; i++)
+        {
+            assert(this->nodes[i].RecordInParallel && !this->beforeRenderCommandBuffers[i].empty());
+            // virtual frame fence is already waited, so commands recorded to this pool are not in use anymore
+            vulkan.GetDevice().resetCommandPool(this->secondaryCommandPools[i][frameIndex], { });
+
+            CommandBuffer beforeRenderCommandBuffer{ this->beforeRenderCommandBuffers[i][frameIndex] };
+            beforeRenderCommandBuffer.BeginSecondary(PassNative{ });
+            this->ResolveRenderGraphNodeResources(i);
+            this->BeforeRenderPassGroup(i, beforeRenderCommandBuffer, resolve);
+            beforeRenderCommandBuffer.End();
+        }
+
+        for (size_t i = firstNodeIndex; i < lastNodeIndex; i++)
+            this->workerPool->Submit([this, i, frameIndex]() { this->RecordSecondaryCommandBuffer(i, frameIndex); });
+        this->workerPool->WaitIdle();
+
+        for (size_t i = firstNodeIndex; i < lastNodeIndex; i++)
+        {
+            auto& node = this->nodes[i];
+            // same order as ExecuteRenderGraphNode: before render commands, barriers, render pass
+            commandBuffer.ExecuteCommands(CommandBuffer{ this->beforeRenderCommandBuffers[i][frameIndex] });
+            node.PipelineBarrierCallback(commandBuffer, resolve);
+
+            commandBuffer.BeginPassWithSecondaryCommands(node.PassNative);
+            commandBuffer.ExecuteCommands(CommandBuffer{ this->secondaryCommandBuffers[i][frameIndex] });
+            commandBuffer.EndPass(node.PassNative);
+
+            this->AfterRenderPassGroup(i, commandBuffer);
+        }
+    }
+
+    void RenderGraph::ExecuteAsyncComputeBatch(size_t batchIndex, CommandBuffer& commandBuffer)
+    {
+        auto& vulkan = GetCurrentVulkanContext();
+        auto& batch = this->asyncComputeBatches[batchIndex];
+        size_t frameIndex = vulkan.GetCurrentVirtualFrameIndex();
+        auto& graphicsToCompute = this->graphicsToComputeSemaphores[frameIndex][batchIndex];
+        auto& computeToGraphics = this->computeToGraphicsSemaphores[frameIndex][batchIndex];
+
+        // ownership release barriers are recorded before graphics commands are submitted, so batch resources are resolved first
+        for (size_t i = batch.FirstNodeIndex; i < batch.LastNodeIndex; i++)
+            this->ResolveRenderGraphNodeResources(i);
+
+        batch.GraphicsQueueRelease(commandBuffer, this->resolveInfo);
+        vulkan.SubmitCurrentCommandBuffer(ArrayView<const vk::Semaphore>{ &graphicsToCompute, 1 });
+
+        // virtual frame fence is already waited and each batch is waited by graphics queue before it is signaled
+        if (batchIndex == 0)
+            vulkan.GetDevice().resetCommandPool(this->asyncComputeCommandPools[frameIndex], { });
+
+        CommandBuffer computeCommandBuffer{ this->asyncComputeCommandBuffers[frameIndex][batchIndex] };
+        computeCommandBuffer.Begin();
+        for (size_t i = batch.FirstNodeIndex; i < batch.LastNodeIndex; i++)
+            this->ExecuteRenderGraphNode(this->nodes[i], computeCommandBuffer, this->resolveInfo);
+        batch.ComputeQueueRelease(computeCommandBuffer, this->resolveInfo);
+        computeCommandBuffer.End();
+
+        vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+        vk::SubmitInfo submitInfo;
+        submitInfo
+            .setWaitSemaphores(graphicsToCompute)
+            .setWaitDstStageMask(waitStage)
+            .setSignalSemaphores(computeToGraphics)
+            .setCommandBuffers(computeCommandBuffer.GetNativeHandle());
+        vulkan.GetComputeQueue().submit(std::array{ submitInfo });
+
+        this->pendingAsyncComputeBatches.push_back(batchIndex);
+    }
+
+    void RenderGraph::WaitForAsyncCompute()
+    {
+        if (this->pendingAsyncComputeBatches.empty()) return;
+
+        // commands recorded so far overlap with async compute, only the rest of the frame waits for it
+        auto& vulkan = GetCurrentVulkanContext();
+        size_t frameIndex = vulkan.GetCurrentVirtualFrameIndex();
+        vulkan.SubmitCurrentCommandBuffer({ });
+
+        for (size_t batchIndex : this->pendingAsyncComputeBatches)
+        {
+            vulkan.WaitSemaphoreOnNextSubmit(
+                this->computeToGraphicsSemaphores[frameIndex][batchIndex],
+                this->asyncComputeBatches[batchIndex].GraphicsWaitStages
+            );
+        }
+        this->pendingAsyncComputeBatches.clear();
     }
 
     void RenderGraph::Execute(CommandBuffer& commandBuffer)
     {
         this->InitializeOnFirstFrame(commandBuffer);
 
-        ResolveInfo resolve;
-        for (const auto& [attachmentName, attachment] : this->attachments)
+        // resolve info is reused between frames to keep its storage
+        this->resolveInfo.Reset();
+        for (ResourceHandle handle = 0; handle < (ResourceHandle)this->attachmentsByHandle.size(); handle++)
         {
-            resolve.Resolve(attachmentName, attachment);
+            if (this->attachmentsByHandle[handle] != nullptr)
+                this->resolveInfo.Resolve(handle, *this->attachmentsByHandle[handle]);
         }
+        this->WriteFrameDescriptors(this->resolveInfo);
 
-        for (auto& node : this->nodes)
+        size_t asyncComputeBatchIndex = 0;
+        for (size_t i = 0; i < this->nodes.size();)
         {
-            this->ExecuteRenderGraphNode(node, commandBuffer, resolve);
+            if (asyncComputeBatchIndex < this->asyncComputeBatches.size() && this->asyncComputeBatches[asyncComputeBatchIndex].FirstNodeIndex == i)
+            {
+                this->ExecuteAsyncComputeBatch(asyncComputeBatchIndex, commandBuffer);
+                i = this->asyncComputeBatches[asyncComputeBatchIndex].LastNodeIndex;
+                asyncComputeBatchIndex++;
+                continue;
+            }
+
+            if (this->nodes[i].WaitsForAsyncCompute)
+                this->WaitForAsyncCompute();
+
+            if (!this->nodes[i].RecordInParallel)
+            {
+                this->ResolveRenderGraphNodeResources(i);
+                this->ExecuteRenderGraphNode(this->nodes[i], commandBuffer, this->resolveInfo);
+                i++;
+                continue;
+            }
+
+            // consecutive parallel nodes are recorded together and stitched into primary command buffer in graph order
+            size_t lastNodeIndex = i + 1;
+            while (lastNodeIndex < this->nodes.size() && this->nodes[lastNodeIndex].RecordInParallel && !this->nodes[lastNodeIndex].WaitsForAsyncCompute)
+                lastNodeIndex++;
+
+            this->ExecuteRenderGraphNodesInParallel(i, lastNodeIndex, commandBuffer, this->resolveInfo);
+            i = lastNodeIndex;
         }
+
+        // work recorded after render graph can depend on async compute results, as well as the next frame
+        this->WaitForAsyncCompute();
     }
 
     void RenderGraph::Present(CommandBuffer& commandBuffer, const Image& presentImage)
@@ -86,18 +377,39 @@ namespace VulkanAbstractionLayer
         this->onPresent(commandBuffer, this->attachments.at(this->outputName), presentImage);
     }
 
+    bool RenderGraph::HasNode(const std::string& name) const
+    {
+        auto handle = GetResourceRegistry().Find(name);
+        return handle < this->nodeIndices.size() && this->nodeIndices[handle] < this->nodes.size();
+    }
+
+    const RenderGraphNode& RenderGraph::GetNodeByName(ResourceHandle handle) const
+    {
+        assert(handle < this->nodeIndices.size() && this->nodeIndices[handle] < this->nodes.size());
+        return this->nodes[this->nodeIndices[handle]];
+    }
+
+    RenderGraphNode& RenderGraph::GetNodeByName(ResourceHandle handle)
+    {
+        assert(handle < this->nodeIndices.size() && this->nodeIndices[handle] < this->nodes.size());
+        return this->nodes[this->nodeIndices[handle]];
+    }
+
+    const Image& RenderGraph::GetAttachmentByName(ResourceHandle handle) const
+    {
+        assert(handle < this->attachmentsByHandle.size() && this->attachmentsByHandle[handle] != nullptr);
+        return *this->attachmentsByHandle[handle];
+    }
+
     const RenderGraphNode& RenderGraph::GetNodeByName(const std::string& name) const
     {
-        auto it = std::find_if(this->nodes.begin(), this->nodes.end(), [&name](const RenderGraphNode& node) { return node.Name == name; });
-        assert(it != this->nodes.end());
-        return *it;
+        // names come from user code, so unknown ones are reported in release builds too
+        return this->nodes.at(this->nodeIndices.at(GetResourceRegistry().Get(name)));
     }
 
     RenderGraphNode& RenderGraph::GetNodeByName(const std::string& name)
     {
-        auto it = std::find_if(this->nodes.begin(), this->nodes.end(), [&name](const RenderGraphNode& node) { return node.Name == name; });
-        assert(it != this->nodes.end());
-        return *it;
+        return this->nodes.at(this->nodeIndices.at(GetResourceRegistry().Get(name)));
     }
 
     RenderGraph::~RenderGraph()
@@ -106,16 +418,54 @@ namespace VulkanAbstractionLayer
         auto& device = vulkan.GetDevice();
         device.waitIdle();
 
+        this->workerPool.reset();
+        for (const auto& commandPools : this->secondaryCommandPools)
+        {
+            for (const auto& commandPool : commandPools)
+                device.destroyCommandPool(commandPool);
+        }
+        this->secondaryCommandPools.clear();
+        this->secondaryCommandBuffers.clear();
+        this->beforeRenderCommandBuffers.clear();
+
+        for (const auto& commandPool : this->asyncComputeCommandPools)
+            device.destroyCommandPool(commandPool);
+        for (const auto& semaphores : this->graphicsToComputeSemaphores)
+        {
+            for (const auto& semaphore : semaphores)
+                device.destroySemaphore(semaphore);
+        }
+        for (const auto& semaphores : this->computeToGraphicsSemaphores)
+        {
+            for (const auto& semaphore : semaphores)
+                device.destroySemaphore(semaphore);
+        }
+        this->asyncComputeCommandPools.clear();
+        this->asyncComputeCommandBuffers.clear();
+        this->graphicsToComputeSemaphores.clear();
+        this->computeToGraphicsSemaphores.clear();
+
         for (const auto& node : this->nodes)
         {
             auto& pass = node.PassNative;
-            if ((bool)pass.Pipeline)         device.destroyPipeline(pass.Pipeline);
-            if ((bool)pass.PipelineLayout)   device.destroyPipelineLayout(pass.PipelineLayout);
+            // pipelines and layouts are owned by context pipeline state cache and can be reused by next graph
+            for (const auto& descriptorSet : pass.DescriptorSets)
+                vulkan.GetDescriptorCache().FreeDescriptorSet(descriptorSet);
+            if (pass.SubpassIndex != 0) continue; // render pass is shared with previous nodes
             if ((bool)pass.Framebuffer)      device.destroyFramebuffer(pass.Framebuffer);
             if ((bool)pass.RenderPassHandle) device.destroyRenderPass(pass.RenderPassHandle);
         }
         this->nodes.clear();
         this->attachments.clear();
+
+        for (const auto& descriptorSet : this->frameDescriptors.Sets)
+            vulkan.GetDescriptorCache().FreeDescriptorSet(descriptorSet);
+        this->frameDescriptors.Sets.clear();
+
+        // aliased attachments are already destroyed, now their shared memory can be released
+        for (auto memory : this->attachmentMemory)
+            DeallocateMemory(memory);
+        this->attachmentMemory.clear();
     }
 
     const Image& RenderGraph::GetAttachmentByName(const std::string& name) const
@@ -31,8 +31,10 @@
 #include "RenderPass.h"
 #include "Image.h"
 #include "CommandBuffer.h"
+#include "WorkerPool.h"
 
 #include <vector>
+#include <memory>
 #include <functional>
 #include <unordered_map>
 #include <unordered_set>
@@ -47,6 +49,41 @@ namespace VulkanAbstractionLayer
         std::vector<std::string> UsedAttachments;
         std::function<void(CommandBuffer&, const ResolveInfo&)> PipelineBarrierCallback;
         DescriptorBinding Descriptors;
+        bool RecordInParallel = false;
+        bool WaitsForAsyncCompute = false;
+    };
+
+    struct AsyncComputeBatch
+    {
+        using ReleaseCallback = std::function<void(CommandBuffer&, const ResolveInfo&)>;
+
+        size_t FirstNodeIndex = 0;
+        size_t LastNodeIndex = 0;
+        ReleaseCallback GraphicsQueueRelease;
+        ReleaseCallback ComputeQueueRelease;
+        vk::PipelineStageFlags GraphicsWaitStages;
+    };
+
+    // descriptors shared by all passes, written once per frame before any pass is executed
+    struct FrameDescriptors
+    {
+        DescriptorBinding Bindings;
+        std::function<void(ResolveInfo&)> OnResolve;
+        vk::DescriptorSetLayout SetLayout;
+        std::vector<vk::DescriptorSet> Sets; // per virtual frame
+    };
+
+    struct RenderGraphStatistics
+    {
+        size_t NaiveAttachmentMemory = 0;
+        size_t AllocatedAttachmentMemory = 0;
+        size_t AliasedAttachmentCount = 0;
+        size_t LazilyAllocatedAttachmentCount = 0;
+        size_t CulledPassCount = 0;
+        size_t UnscheduledBarrierCount = 0;
+        size_t ScheduledBarrierCount = 0;
+        size_t MergedPassCount = 0;
+        size_t AsyncComputePassCount = 0;
     };
 
     class RenderGraph
@@ -56,13 +93,42 @@ namespace VulkanAbstractionLayer
 
         std::vector<RenderGraphNode> nodes;
         std::unordered_map<std::string, Image> attachments;
+        std::vector<VmaAllocation> attachmentMemory;
         std::string outputName;
         PresentCallback onPresent;
         CreateCallback onCreate;
+        RenderGraphStatistics statistics;
+        ResolveInfo resolveInfo;
+        std::vector<size_t> nodeIndices;
+        std::vector<const Image*> attachmentsByHandle;
+        // per node, per virtual frame. Each command pool is only used by one recording task at a time
+        std::vector<std::vector<vk::CommandPool>> secondaryCommandPools;
+        std::vector<std::vector<vk::CommandBuffer>> secondaryCommandBuffers;
+        std::vector<std::vector<vk::CommandBuffer>> beforeRenderCommandBuffers; // allocated from the same pools, recorded on calling thread
+        std::unique_ptr<WorkerPool> workerPool;
+        std::vector<AsyncComputeBatch> asyncComputeBatches;
+        // per virtual frame. Semaphores are indexed by batch
+        std::vector<vk::CommandPool> asyncComputeCommandPools;
+        std::vector<std::vector<vk::CommandBuffer>> asyncComputeCommandBuffers;
+        std::vector<std::vector<vk::Semaphore>> graphicsToComputeSemaphores;
+        std::vector<std::vector<vk::Semaphore>> computeToGraphicsSemaphores;
+        std::vector<size_t> pendingAsyncComputeBatches;
+        FrameDescriptors frameDescriptors;
 
         void InitializeOnFirstFrame(CommandBuffer& commandBuffer);
+        void CreateSecondaryCommandBuffers();
+        void ResolveRenderGraphNodeResources(size_t nodeIndex);
+        void WriteFrameDescriptors(ResolveInfo& resolve);
+        void WriteRenderGraphNodeDescriptors(RenderGraphNode& node, ResolveInfo& resolve);
+        void BeforeRenderPassGroup(size_t nodeIndex, CommandBuffer& commandBuffer, ResolveInfo& resolve);
+        void AfterRenderPassGroup(size_t nodeIndex, CommandBuffer& commandBuffer);
+        void RecordSecondaryCommandBuffer(size_t nodeIndex, size_t frameIndex);
+        void ExecuteRenderGraphNodesInParallel(size_t firstNodeIndex, size_t lastNodeIndex, CommandBuffer& commandBuffer, ResolveInfo& resolve);
+        void CreateAsyncComputeResources();
+        void ExecuteAsyncComputeBatch(size_t batchIndex, CommandBuffer& commandBuffer);
+        void WaitForAsyncCompute();
     public:
-        RenderGraph(std::vector<RenderGraphNode> nodes, std::unordered_map<std::string, Image> attachments, const std::string& outputName, PresentCallback onPresent, CreateCallback onCreate);
+        RenderGraph(std::vector<RenderGraphNode> nodes, std::unordered_map<std::string, Image> attachments, std::vector<VmaAllocation> attachmentMemory, const std::string& outputName, PresentCallback onPresent, CreateCallback onCreate, RenderGraphStatistics statistics, std::vector<AsyncComputeBatch> asyncComputeBatches, FrameDescriptors frameDescriptors);
         ~RenderGraph();
         RenderGraph(RenderGraph&&) = default;
         RenderGraph& operator=(RenderGraph&& other) = delete;
@@ -70,9 +136,32 @@ namespace VulkanAbstractionLayer
         void ExecuteRenderGraphNode(RenderGraphNode& node, CommandBuffer& commandBuffer, ResolveInfo& resolve);
         void Execute(CommandBuffer& commandBuffer);
         void Present(CommandBuffer& commandBuffer, const Image& presentImage);
+        // culled passes have no node: lookups by handle assert and lookups by name throw std::out_of_range for them.
+        // Use HasNode to check, or RenderGraphBuilder::PinRenderPass to keep pass which is queried at runtime
+        bool HasNode(const std::string& name) const;
+        const RenderGraphNode& GetNodeByName(ResourceHandle handle) const;
+        RenderGraphNode& GetNodeByName(ResourceHandle handle);
+        const Image& GetAttachmentByName(ResourceHandle handle) const;
         const RenderGraphNode& GetNodeByName(const std::string& name) const;
         RenderGraphNode& GetNodeByName(const std::string& name);
         const Image& GetAttachmentByName(const std::string& name) const;
+        const RenderGraphStatistics& GetStatistics() const { return this->statistics; }
+
+        template<typename T>
+        T& GetRenderPassByName(ResourceHandle handle)
+        {
+            auto& node = this->GetNodeByName(handle);
+            assert(dynamic_cast<T*>(node.PassCustom.get()) != nullptr);
+            return *static_cast<T*>(node.PassCustom.get());
+        }
+
+        template<typename T>
+        const T& GetRenderPassByName(ResourceHandle handle) const
+        {
+            const auto& node = this->GetNodeByName(handle);
+            assert(dynamic_cast<const T*>(node.PassCustom.get()) != nullptr);
+            return *static_cast<const T*>(node.PassCustom.get());
+        }
 
         template<typename T>
         T& GetRenderPassByName(const std::string& name)
@@ -32,6 +32,10 @@
 #include "GraphicShader.h"
 #include "ComputeShader.h"
 
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
 namespace VulkanAbstractionLayer
 {
     vk::VertexInputRate VertexBindingRateToVertexInputRate(VertexBinding::Rate rate)
@@ -48,18 +52,104 @@ namespace VulkanAbstractionLayer
         }
     }
 
-    vk::ShaderStageFlags PipelineTypeToShaderStages(vk::PipelineBindPoint pipelineType)
+    vk::CullModeFlags CullModeToCullModeFlags(CullMode mode)
+    {
+        switch (mode)
+        {
+        case CullMode::NONE:
+            return vk::CullModeFlagBits::eNone;
+        case CullMode::FRONT:
+            return vk::CullModeFlagBits::eFront;
+        case CullMode::BACK:
+            return vk::CullModeFlagBits::eBack;
+        default:
+            assert(false);
+            return vk::CullModeFlagBits::eNone;
+        }
+    }
+
+    vk::CompareOp CompareOperationToCompareOp(CompareOperation operation)
+    {
+        switch (operation)
+        {
+        case CompareOperation::NEVER:
+            return vk::CompareOp::eNever;
+        case CompareOperation::LESS:
+            return vk::CompareOp::eLess;
+        case CompareOperation::EQUAL:
+            return vk::CompareOp::eEqual;
+        case CompareOperation::LESS_OR_EQUAL:
+            return vk::CompareOp::eLessOrEqual;
+        case CompareOperation::GREATER:
+            return vk::CompareOp::eGreater;
+        case CompareOperation::NOT_EQUAL:
+            return vk::CompareOp::eNotEqual;
+        case CompareOperation::GREATER_OR_EQUAL:
+            return vk::CompareOp::eGreaterOrEqual;
+        case CompareOperation::ALWAYS:
+            return vk::CompareOp::eAlways;
+        default:
+            assert(false);
+            return vk::CompareOp::eAlways;
+        }
+    }
+
+    vk::PrimitiveTopology PrimitiveTopologyToNative(PrimitiveTopology topology)
+    {
+        switch (topology)
+        {
+        case PrimitiveTopology::POINT_LIST:
+            return vk::PrimitiveTopology::ePointList;
+        case PrimitiveTopology::LINE_LIST:
+            return vk::PrimitiveTopology::eLineList;
+        case PrimitiveTopology::LINE_STRIP:
+            return vk::PrimitiveTopology::eLineStrip;
+        case PrimitiveTopology::TRIANGLE_LIST:
+            return vk::PrimitiveTopology::eTriangleList;
+        case PrimitiveTopology::TRIANGLE_STRIP:
+            return vk::PrimitiveTopology::eTriangleStrip;
+        case PrimitiveTopology::TRIANGLE_FAN:
+            return vk::PrimitiveTopology::eTriangleFan;
+        default:
+            assert(false);
+            return vk::PrimitiveTopology::eTriangleList;
+        }
+    }
+
+    vk::PipelineColorBlendAttachmentState BlendModeToColorBlendAttachmentState(BlendMode mode)
     {
-        switch (pipelineType)
+        vk::PipelineColorBlendAttachmentState colorBlendAttachmentState;
+        colorBlendAttachmentState
+            .setBlendEnable(mode != BlendMode::DISABLED)
+            .setColorBlendOp(vk::BlendOp::eAdd)
+            .setSrcAlphaBlendFactor(vk::BlendFactor::eOne)
+            .setDstAlphaBlendFactor(vk::BlendFactor::eZero)
+            .setAlphaBlendOp(vk::BlendOp::eAdd)
+            .setColorWriteMask(
+                vk::ColorComponentFlagBits::eR |
+                vk::ColorComponentFlagBits::eG |
+                vk::ColorComponentFlagBits::eB |
+                vk::ColorComponentFlagBits::eA
+            );
+
+        switch (mode)
         {
-        case vk::PipelineBindPoint::eGraphics:
-            return vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
-        case vk::PipelineBindPoint::eCompute:
-            return vk::ShaderStageFlagBits::eCompute;
+        case BlendMode::DISABLED:
+            break;
+        case BlendMode::ALPHA_BLEND:
+            colorBlendAttachmentState
+                .setSrcColorBlendFactor(vk::BlendFactor::eSrcAlpha)
+                .setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha);
+            break;
+        case BlendMode::ADDITIVE:
+            colorBlendAttachmentState
+                .setSrcColorBlendFactor(vk::BlendFactor::eOne)
+                .setDstColorBlendFactor(vk::BlendFactor::eOne);
+            break;
         default:
             assert(false);
-            return vk::ShaderStageFlags{ };
         }
+        return colorBlendAttachmentState;
     }
 
     vk::AttachmentLoadOp AttachmentStateToLoadOp(AttachmentState state)
@@ -106,94 +196,6 @@ namespace VulkanAbstractionLayer
         }
     }
 
-    vk::PipelineStageFlags BufferUsageToPipelineStage(BufferUsage::Bits layout)
-    {
-        switch (layout)
-        {
-        case BufferUsage::UNKNOWN:
-            return vk::PipelineStageFlagBits::eTopOfPipe;
-        case BufferUsage::TRANSFER_SOURCE:
-            return vk::PipelineStageFlagBits::eTransfer;
-        case BufferUsage::TRANSFER_DESTINATION:
-            return vk::PipelineStageFlagBits::eTransfer;
-        case BufferUsage::UNIFORM_TEXEL_BUFFER:
-            return vk::PipelineStageFlagBits::eVertexShader; // TODO: from other shader stages?
-        case BufferUsage::STORAGE_TEXEL_BUFFER:
-            return vk::PipelineStageFlagBits::eComputeShader;
-        case BufferUsage::UNIFORM_BUFFER:
-            return vk::PipelineStageFlagBits::eVertexShader;
-        case BufferUsage::STORAGE_BUFFER:
-            return vk::PipelineStageFlagBits::eComputeShader;
-        case BufferUsage::INDEX_BUFFER:
-            return vk::PipelineStageFlagBits::eVertexInput;
-        case BufferUsage::VERTEX_BUFFER:
-            return vk::PipelineStageFlagBits::eVertexInput;
-        case BufferUsage::INDIRECT_BUFFER:
-            return vk::PipelineStageFlagBits::eDrawIndirect;
-        case BufferUsage::SHADER_DEVICE_ADDRESS:
-            return vk::PipelineStageFlagBits::eFragmentShader; // TODO: what should be here?
-        case BufferUsage::TRANSFORM_FEEDBACK_BUFFER:
-            return vk::PipelineStageFlagBits::eTransformFeedbackEXT;
-        case BufferUsage::TRANSFORM_FEEDBACK_COUNTER_BUFFER:
-            return vk::PipelineStageFlagBits::eTransformFeedbackEXT;
-        case BufferUsage::CONDITIONAL_RENDERING:
-            return vk::PipelineStageFlagBits::eConditionalRenderingEXT;
-        case BufferUsage::ACCELERATION_STRUCTURE_BUILD_INPUT_READONLY:
-            return vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR;
-        case BufferUsage::ACCELERATION_STRUCTURE_STORAGE:
-            return vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR; // TODO: what should be here?
-        case BufferUsage::SHADER_BINDING_TABLE:
-            return vk::PipelineStageFlagBits::eFragmentShader; // TODO: what should be here?
-        default:
-            assert(false);
-            return vk::PipelineStageFlags{ };
-        }
-    }
-
-    vk::AccessFlags BufferUsageToAccessFlags(BufferUsage::Bits layout)
-    {
-        switch (layout)
-        {
-        case BufferUsage::UNKNOWN:
-            return vk::AccessFlags{ };
-        case BufferUsage::TRANSFER_SOURCE:
-            return vk::AccessFlagBits::eTransferRead;
-        case BufferUsage::TRANSFER_DESTINATION:
-            return vk::AccessFlagBits::eTransferWrite;
-        case BufferUsage::UNIFORM_TEXEL_BUFFER:
-            return vk::AccessFlagBits::eShaderRead;
-        case BufferUsage::STORAGE_TEXEL_BUFFER:
-            return vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead;
-        case BufferUsage::UNIFORM_BUFFER:
-            return vk::AccessFlagBits::eShaderRead;
-        case BufferUsage::STORAGE_BUFFER:
-            return vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead;
-        case BufferUsage::INDEX_BUFFER:
-            return vk::AccessFlagBits::eIndexRead;
-        case BufferUsage::VERTEX_BUFFER:
-            return vk::AccessFlagBits::eVertexAttributeRead;
-        case BufferUsage::INDIRECT_BUFFER:
-            return vk::AccessFlagBits::eIndirectCommandRead;
-        case BufferUsage::SHADER_DEVICE_ADDRESS:
-            return vk::AccessFlagBits::eShaderRead;
-        case BufferUsage::TRANSFORM_FEEDBACK_BUFFER:
-            return vk::AccessFlagBits::eTransformFeedbackWriteEXT;
-        case BufferUsage::TRANSFORM_FEEDBACK_COUNTER_BUFFER:
-            return vk::AccessFlagBits::eTransformFeedbackCounterWriteEXT;
-        case BufferUsage::CONDITIONAL_RENDERING:
-            return vk::AccessFlagBits::eConditionalRenderingReadEXT;
-        case BufferUsage::ACCELERATION_STRUCTURE_BUILD_INPUT_READONLY:
-            return vk::AccessFlagBits::eAccelerationStructureReadKHR;
-        case BufferUsage::ACCELERATION_STRUCTURE_STORAGE:
-            return vk::AccessFlagBits::eAccelerationStructureReadKHR;
-        case BufferUsage::SHADER_BINDING_TABLE:
-            return vk::AccessFlagBits::eShaderRead;
-        default:
-            assert(false);
-            return vk::AccessFlags{ };
-        }
-    }
-
     bool HasImageWriteDependency(ImageUsage::Bits usage)
     {
         switch (usage)
@@ -265,68 +267,335 @@ namespace VulkanAbstractionLayer
         return bufferBarrier;
     }
 
-    void EmitPipelineBarrier(CommandBuffer& commandBuffer, const ResolveInfo& resolveInfo, const std::unordered_map<std::string, BufferTransition>& bufferTransitions, const std::unordered_map<std::string, ImageTransition>& imageTransitions)
+    static vk::PipelineStageFlags ToComputeQueueStages(vk::PipelineStageFlags stages)
+    {
+        // stages are derived from resource usage only, on compute queue the same accesses are done by compute shaders
+        const vk::PipelineStageFlags computeQueueStages =
+            vk::PipelineStageFlagBits::eTopOfPipe |
+            vk::PipelineStageFlagBits::eDrawIndirect |
+            vk::PipelineStageFlagBits::eComputeShader |
+            vk::PipelineStageFlagBits::eTransfer |
+            vk::PipelineStageFlagBits::eBottomOfPipe |
+            vk::PipelineStageFlagBits::eHost |
+            vk::PipelineStageFlagBits::eAllCommands;
+
+        auto supportedStages = stages & computeQueueStages;
+        if (supportedStages != stages) supportedStages |= vk::PipelineStageFlagBits::eComputeShader;
+        return supportedStages;
+    }
+
+    // resources which were previously used on the other queue. Their barriers are synchronized by semaphore instead
+    // of previous usage stages, and transfer queue family ownership if queues belong to different families
+    struct QueueTransferInfo
     {
+        std::unordered_set<std::string> Resources;
+        // acquired resources which were released by the other queue in previous frame, not in the same one
+        std::unordered_set<std::string> WrappedResources;
+        uint32_t SourceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t DistanceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        bool IsComputeQueue = false;
+        bool IsRelease = false;
+    };
+
+    class PipelineBarrierTable
+    {
+        struct BufferBarrierEntry
+        {
+            ResourceHandle Handle;
+            BufferTransition Transition;
+            vk::AccessFlags SourceAccess;
+            vk::AccessFlags DistanceAccess;
+            uint32_t SourceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+            uint32_t DistanceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+            bool IsWrapped = false;
+        };
+
+        struct ImageBarrierEntry
+        {
+            ResourceHandle Handle;
+            ImageTransition Transition;
+            vk::AccessFlags SourceAccess;
+            vk::AccessFlags DistanceAccess;
+            uint32_t SourceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+            uint32_t DistanceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+            bool IsWrapped = false;
+        };
+
+        std::vector<BufferBarrierEntry> bufferEntries;
+        std::vector<ImageBarrierEntry> imageEntries;
+        std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+        std::vector<vk::ImageMemoryBarrier> imageBarriers;
         vk::PipelineStageFlags pipelineSourceFlags = { };
         vk::PipelineStageFlags pipelineDistanceFlags = { };
+        uint32_t sourceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t distanceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        bool hasWrappedEntries = false;
+        bool isFirstFrame = true;
 
-        std::vector<vk::BufferMemoryBarrier> bufferBarriers;
-        for (const auto& [bufferName, bufferTransition] : bufferTransitions)
+        static vk::BufferMemoryBarrier CreateBarrier(const BufferBarrierEntry& entry, const Buffer& buffer)
         {
-            if (!HasBufferWriteDependency(bufferTransition.InitialUsage))
-                continue;
+            auto bufferBarrier = CreateBufferMemoryBarrier(buffer.GetNativeHandle(), entry.Transition.InitialUsage, entry.Transition.FinalUsage);
+            bufferBarrier
+                .setSrcAccessMask(entry.SourceAccess)
+                .setDstAccessMask(entry.DistanceAccess)
+                .setSrcQueueFamilyIndex(entry.SourceQueueFamily)
+                .setDstQueueFamilyIndex(entry.DistanceQueueFamily);
+            return bufferBarrier;
+        }
+
+        static vk::ImageMemoryBarrier CreateBarrier(const ImageBarrierEntry& entry, const Image& image)
+        {
+            auto imageBarrier = CreateImageMemoryBarrier(image.GetNativeHandle(), entry.Transition.InitialUsage, entry.Transition.FinalUsage, image.GetFormat(), image.GetMipLevelCount(), image.GetLayerCount());
+            imageBarrier
+                .setSrcAccessMask(entry.SourceAccess)
+                .setDstAccessMask(entry.DistanceAccess)
+                .setSrcQueueFamilyIndex(entry.SourceQueueFamily)
+                .setDstQueueFamilyIndex(entry.DistanceQueueFamily);
+            return imageBarrier;
+        }
 
-            pipelineSourceFlags |= BufferUsageToPipelineStage(bufferTransition.InitialUsage);
-            pipelineDistanceFlags |= BufferUsageToPipelineStage(bufferTransition.FinalUsage);
+        template<typename Entry>
+        void AddEntry(Entry entry, vk::PipelineStageFlags sourceStage, vk::PipelineStageFlags distanceStage, bool isQueueTransfer, bool isOwnershipTransfer, const QueueTransferInfo& queueTransfer, std::vector<Entry>& entries)
+        {
+            if (isOwnershipTransfer)
+            {
+                entry.SourceQueueFamily = queueTransfer.SourceQueueFamily;
+                entry.DistanceQueueFamily = queueTransfer.DistanceQueueFamily;
+                entry.IsWrapped = !queueTransfer.IsRelease && queueTransfer.WrappedResources.count(GetResourceName(entry.Handle)) != 0;
+                this->hasWrappedEntries |= entry.IsWrapped;
+            }
 
-            auto buffers = resolveInfo.GetBuffers().at(bufferName);
-            for (const auto& buffer : buffers)
+            if (queueTransfer.IsRelease)
             {
-                bufferBarriers.push_back(
-                    CreateBufferMemoryBarrier(buffer.get().GetNativeHandle(), bufferTransition.InitialUsage, bufferTransition.FinalUsage)
-                );
+                // acquire part of ownership transfer is recorded on the other queue
+                distanceStage = vk::PipelineStageFlagBits::eBottomOfPipe;
+                entry.DistanceAccess = { };
+            }
+            else if (isQueueTransfer)
+            {
+                // semaphore waits on distance stages and makes previous accesses visible
+                sourceStage = distanceStage;
+                entry.SourceAccess = { };
+            }
+
+            if (queueTransfer.IsComputeQueue)
+            {
+                sourceStage = ToComputeQueueStages(sourceStage);
+                distanceStage = ToComputeQueueStages(distanceStage);
             }
+
+            this->pipelineSourceFlags |= sourceStage;
+            this->pipelineDistanceFlags |= distanceStage;
+            entries.push_back(std::move(entry));
         }
 
-        std::vector<vk::ImageMemoryBarrier> imageBarriers;
-        for (const auto& [imageName, imageTransition] : imageTransitions)
+        bool HasSameBarrierCount(const ResolveInfo& resolveInfo) const
         {
-            if (imageTransition.InitialUsage == imageTransition.FinalUsage && !HasImageWriteDependency(imageTransition.InitialUsage))
-                continue;
+            size_t bufferBarrierCount = 0, imageBarrierCount = 0;
+            for (const auto& entry : this->bufferEntries)
+                bufferBarrierCount += resolveInfo.GetBuffers(entry.Handle).size();
+            for (const auto& entry : this->imageEntries)
+                imageBarrierCount += resolveInfo.GetImages(entry.Handle).size();
+            return bufferBarrierCount == this->bufferBarriers.size() && imageBarrierCount == this->imageBarriers.size();
+        }
+
+        void RebuildBarriers(const ResolveInfo& resolveInfo)
+        {
+            this->bufferBarriers.clear();
+            this->imageBarriers.clear();
+            // every entry was a transition when graph was built, resource which stopped resolving would silently lose its barriers
+            for (const auto& entry : this->bufferEntries)
+            {
+                auto& buffers = resolveInfo.GetBuffers(entry.Handle);
+                assert(!buffers.empty());
+                for (const auto& buffer : buffers)
+                    this->bufferBarriers.push_back(CreateBarrier(entry, buffer.get()));
+            }
+            for (const auto& entry : this->imageEntries)
+            {
+                auto& images = resolveInfo.GetImages(entry.Handle);
+                assert(!images.empty());
+                for (const auto& image : images)
+                    this->imageBarriers.push_back(CreateBarrier(entry, image.get()));
+            }
+        }
 
-            pipelineSourceFlags |= ImageUsageToPipelineStage(imageTransition.InitialUsage);
-            pipelineDistanceFlags |= ImageUsageToPipelineStage(imageTransition.FinalUsage);
+        template<typename Entry>
+        void SetWrappedOwnershipTransfer(bool isEnabled, std::vector<Entry>& entries)
+        {
+            for (auto& entry : entries)
+            {
+                if (!entry.IsWrapped) continue;
+                entry.SourceQueueFamily = isEnabled ? this->sourceQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+                entry.DistanceQueueFamily = isEnabled ? this->distanceQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+            }
+        }
 
-            auto images = resolveInfo.GetImages().at(imageName);
-            for (const auto& image : images)
+        void PatchBarriers(const ResolveInfo& resolveInfo)
+        {
+            auto bufferBarrier = this->bufferBarriers.begin();
+            for (const auto& entry : this->bufferEntries)
             {
-                imageBarriers.push_back(
-                    CreateImageMemoryBarrier(image.get().GetNativeHandle(), imageTransition.InitialUsage, imageTransition.FinalUsage, image.get().GetFormat(), image.get().GetMipLevelCount(), image.get().GetLayerCount())
-                );
+                for (const auto& buffer : resolveInfo.GetBuffers(entry.Handle))
+                {
+                    if (bufferBarrier->buffer != buffer.get().GetNativeHandle())
+                        *bufferBarrier = CreateBarrier(entry, buffer.get());
+                    bufferBarrier++;
+                }
+            }
+            auto imageBarrier = this->imageBarriers.begin();
+            for (const auto& entry : this->imageEntries)
+            {
+                for (const auto& image : resolveInfo.GetImages(entry.Handle))
+                {
+                    if (imageBarrier->image != image.get().GetNativeHandle())
+                        *imageBarrier = CreateBarrier(entry, image.get());
+                    imageBarrier++;
+                }
             }
         }
 
-        if (bufferBarriers.empty() && imageBarriers.empty())
-            return;
+    public:
+        PipelineBarrierTable(const std::unordered_map<std::string, BufferTransition>& bufferTransitions, const std::unordered_map<std::string, ImageTransition>& imageTransitions, const QueueTransferInfo& queueTransfer)
+        {
+            this->sourceQueueFamily = queueTransfer.SourceQueueFamily;
+            this->distanceQueueFamily = queueTransfer.DistanceQueueFamily;
 
-        commandBuffer.GetNativeHandle().pipelineBarrier(
-            pipelineSourceFlags,
-            pipelineDistanceFlags,
-            { },
-            { },
-            bufferBarriers,
-            imageBarriers
-        );
-    }
+            // transitions are filtered once when graph is built, only resource handles are resolved per frame
+            for (const auto& [bufferName, bufferTransition] : bufferTransitions)
+            {
+                bool isQueueTransfer = queueTransfer.Resources.count(bufferName) != 0;
+                bool isOwnershipTransfer = isQueueTransfer && queueTransfer.SourceQueueFamily != queueTransfer.DistanceQueueFamily;
+                // ownership is transferred for read-only accesses too
+                if (!isOwnershipTransfer && (queueTransfer.IsRelease || !HasBufferWriteDependency(bufferTransition.InitialUsage)))
+                    continue;
+
+                BufferBarrierEntry entry{
+                    InternResourceName(bufferName),
+                    bufferTransition,
+                    BufferUsageToAccessFlags(bufferTransition.InitialUsage),
+                    BufferUsageToAccessFlags(bufferTransition.FinalUsage),
+                };
+                auto sourceStage = BufferUsageToPipelineStage(bufferTransition.InitialUsage);
+                auto distanceStage = BufferUsageToPipelineStage(bufferTransition.FinalUsage);
+                this->AddEntry(std::move(entry), sourceStage, distanceStage, isQueueTransfer, isOwnershipTransfer, queueTransfer, this->bufferEntries);
+            }
+            for (const auto& [imageName, imageTransition] : imageTransitions)
+            {
+                bool isQueueTransfer = queueTransfer.Resources.count(imageName) != 0;
+                // discarded image content does not need to change its owner
+                bool isOwnershipTransfer = isQueueTransfer && queueTransfer.SourceQueueFamily != queueTransfer.DistanceQueueFamily && imageTransition.InitialUsage != ImageUsage::UNKNOWN;
+                if (!isOwnershipTransfer && (queueTransfer.IsRelease || (imageTransition.InitialUsage == imageTransition.FinalUsage && !HasImageWriteDependency(imageTransition.InitialUsage))))
+                    continue;
+
+                auto sourceUsage = imageTransition.AliasedUsage != ImageUsage::UNKNOWN ? imageTransition.AliasedUsage : imageTransition.InitialUsage;
+                ImageBarrierEntry entry{
+                    InternResourceName(imageName),
+                    imageTransition,
+                    ImageUsageToAccessFlags(sourceUsage),
+                    ImageUsageToAccessFlags(imageTransition.FinalUsage),
+                };
+                auto sourceStage = ImageUsageToPipelineStage(sourceUsage);
+                auto distanceStage = ImageUsageToPipelineStage(imageTransition.FinalUsage);
+                this->AddEntry(std::move(entry), sourceStage, distanceStage, isQueueTransfer, isOwnershipTransfer, queueTransfer, this->imageEntries);
+            }
+        }
+
+        void Emit(CommandBuffer& commandBuffer, const ResolveInfo& resolveInfo)
+        {
+            if (this->bufferEntries.empty() && this->imageEntries.empty())
+                return;
+
+            // nothing was released by previous frame before the first one, so wrapped resources are only transitioned
+            // on this queue and wait for all previous commands instead of semaphore
+            bool isFirstFrameWithoutRelease = std::exchange(this->isFirstFrame, false) && this->hasWrappedEntries;
+            if (isFirstFrameWithoutRelease)
+            {
+                this->SetWrappedOwnershipTransfer(false, this->bufferEntries);
+                this->SetWrappedOwnershipTransfer(false, this->imageEntries);
+                this->RebuildBarriers(resolveInfo);
+            }
+            else if (this->HasSameBarrierCount(resolveInfo))
+                this->PatchBarriers(resolveInfo);
+            else
+                this->RebuildBarriers(resolveInfo);
+
+            if (!this->bufferBarriers.empty() || !this->imageBarriers.empty())
+            {
+                commandBuffer.GetNativeHandle().pipelineBarrier(
+                    isFirstFrameWithoutRelease ? vk::PipelineStageFlagBits::eAllCommands : this->pipelineSourceFlags,
+                    this->pipelineDistanceFlags,
+                    { },
+                    { },
+                    this->bufferBarriers,
+                    this->imageBarriers
+                );
+            }
+
+            if (isFirstFrameWithoutRelease)
+            {
+                // barriers are rebuilt with ownership transfer next frame
+                this->SetWrappedOwnershipTransfer(true, this->bufferEntries);
+                this->SetWrappedOwnershipTransfer(true, this->imageEntries);
+                this->bufferBarriers.clear();
+                this->imageBarriers.clear();
+            }
+        }
+    };
 
-    RenderGraphBuilder::PipelineBarrierCallback RenderGraphBuilder::CreatePipelineBarrierCallback(const std::string& renderPassName, const Pipeline& pipeline, const ResourceTransitions& resourceTransitions)
+    RenderGraphBuilder::PipelineBarrierCallback RenderGraphBuilder::CreatePipelineBarrierCallback(const std::vector<size_t>& renderPassGroup, size_t subpassIndex, const PipelineHashMap& pipelines, const ResourceTransitions& resourceTransitions, const QueueTransferHashMap& queueTransfers)
     {
-        auto& bufferTransitions = resourceTransitions.Buffers.Transitions.at(renderPassName);
-        auto& imageTransitions = resourceTransitions.Images.Transitions.at(renderPassName);
+        // barriers can not be recorded inside of render pass, so first subpass emits them for the whole group
+        if (subpassIndex != 0)
+            return [](CommandBuffer&, const ResolveInfo&) { };
+
+        std::unordered_map<std::string, BufferTransition> bufferTransitions;
+        std::unordered_map<std::string, ImageTransition> imageTransitions;
+        std::unordered_set<std::string> groupAttachments;
+
+        auto& vulkan = GetCurrentVulkanContext();
+        QueueTransferInfo queueTransfer;
+        queueTransfer.IsComputeQueue = this->asyncComputeRenderPasses.count(this->renderPassReferences[renderPassGroup.front()].Name) != 0;
+        queueTransfer.SourceQueueFamily = queueTransfer.IsComputeQueue ? vulkan.GetQueueFamilyIndex() : vulkan.GetComputeQueueFamilyIndex();
+        queueTransfer.DistanceQueueFamily = queueTransfer.IsComputeQueue ? vulkan.GetComputeQueueFamilyIndex() : vulkan.GetQueueFamilyIndex();
+
+        auto findRenderPassIndex = [this](const RenderPassName& renderPassName)
+        {
+            return (size_t)std::distance(this->renderPassReferences.begin(), std::find_if(this->renderPassReferences.begin(), this->renderPassReferences.end(),
+                [&renderPassName](const RenderPassReference& renderPassReference) { return renderPassReference.Name == renderPassName; }));
+        };
+
+        for (size_t renderPassIndex : renderPassGroup)
+        {
+            auto& renderPassName = this->renderPassReferences[renderPassIndex].Name;
+            for (const auto& [bufferName, bufferTransition] : resourceTransitions.Buffers.Transitions.at(renderPassName))
+                bufferTransitions.emplace(bufferName, bufferTransition);
+
+            // transitions of attachments written by previous subpasses are handled by subpass dependencies
+            for (const auto& [imageName, imageTransition] : resourceTransitions.Images.Transitions.at(renderPassName))
+            {
+                if (groupAttachments.count(imageName) == 0)
+                    imageTransitions.emplace(imageName, imageTransition);
+            }
+            for (const auto& attachment : pipelines.at(renderPassName).GetOutputAttachments())
+                groupAttachments.insert(attachment.Name);
+
+            auto renderPassQueueTransfers = queueTransfers.find(renderPassName);
+            if (renderPassQueueTransfers != queueTransfers.end())
+            {
+                for (const auto& [resourceName, previousRenderPassName] : renderPassQueueTransfers->second)
+                {
+                    queueTransfer.Resources.insert(resourceName);
+                    // compute queue releases at the end of frame, graphics queue releases right before batch is submitted
+                    if (!queueTransfer.IsComputeQueue && findRenderPassIndex(previousRenderPassName) > renderPassIndex)
+                        queueTransfer.WrappedResources.insert(resourceName);
+                }
+            }
+        }
 
-        return [bufferTransitions, imageTransitions](CommandBuffer& commandBuffer, const ResolveInfo& resolveInfo)
+        return [barrierTable = PipelineBarrierTable(bufferTransitions, imageTransitions, queueTransfer)](CommandBuffer& commandBuffer, const ResolveInfo& resolveInfo) mutable
         {
-            EmitPipelineBarrier(commandBuffer, resolveInfo, bufferTransitions, imageTransitions);
+            barrierTable.Emit(commandBuffer, resolveInfo);
         };
     }
 
@@ -349,9 +618,9 @@ namespace VulkanAbstractionLayer
                 }
             }
         }
-        return [resolve = std::move(resolveInfo), transitions = std::move(attachmentTransitions)](CommandBuffer& commandBuffer)
+        return [resolve = std::move(resolveInfo), barrierTable = PipelineBarrierTable({ }, attachmentTransitions, QueueTransferInfo{ })](CommandBuffer& commandBuffer) mutable
         {
-            EmitPipelineBarrier(commandBuffer, resolve, { }, transitions);
+            barrierTable.Emit(commandBuffer, resolve);
         };
     }
 
@@ -403,10 +672,11 @@ namespace VulkanAbstractionLayer
             .setBasePipelineHandle(vk::Pipeline{ })
             .setBasePipelineIndex(0);
 
-        return GetCurrentVulkanContext().GetDevice().createComputePipeline(vk::PipelineCache{ }, pipelineCreateInfo).value;
+        auto& vulkan = GetCurrentVulkanContext();
+        return vulkan.GetDevice().createComputePipeline(vulkan.GetPipelineCache(), pipelineCreateInfo).value;
     }
 
-    static vk::Pipeline CreateGraphicPipeline(const Shader& shader, const vk::PipelineLayout& layout, ArrayView<const VertexBinding> vertexBindings, const vk::RenderPass& renderPass)
+    static vk::Pipeline CreateGraphicPipeline(const Shader& shader, const vk::PipelineLayout& layout, ArrayView<const VertexBinding> vertexBindings, const FixedFunctionState& state, uint32_t colorAttachmentCount, const vk::RenderPass& renderPass, uint32_t subpassIndex)
     {
         std::array shaderStageCreateInfos = {
             vk::PipelineShaderStageCreateInfo {
@@ -479,7 +749,7 @@ namespace VulkanAbstractionLayer
         vk::PipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo;
         inputAssemblyStateCreateInfo
             .setPrimitiveRestartEnable(false)
-            .setTopology(vk::PrimitiveTopology::eTriangleList);
+            .setTopology(PrimitiveTopologyToNative(state.Topology));
 
         vk::PipelineViewportStateCreateInfo viewportStateCreateInfo;
         viewportStateCreateInfo
@@ -489,36 +759,25 @@ namespace VulkanAbstractionLayer
         vk::PipelineRasterizationStateCreateInfo rasterizationStateCreateInfo;
         rasterizationStateCreateInfo
             .setPolygonMode(vk::PolygonMode::eFill)
-            .setCullMode(vk::CullModeFlagBits::eBack)
+            .setCullMode(CullModeToCullModeFlags(state.Cull))
             .setFrontFace(vk::FrontFace::eCounterClockwise)
             .setLineWidth(1.0f);
 
         vk::PipelineMultisampleStateCreateInfo multisampleStateCreateInfo;
         multisampleStateCreateInfo
-            .setRasterizationSamples(vk::SampleCountFlagBits::e1)
+            .setRasterizationSamples((vk::SampleCountFlagBits)state.SampleCount)
             .setMinSampleShading(1.0f);
 
-        vk::PipelineColorBlendAttachmentState colorBlendAttachmentState;
-        colorBlendAttachmentState
-            .setBlendEnable(true)
-            .setSrcColorBlendFactor(vk::BlendFactor::eSrcAlpha)
-            .setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha)
-            .setColorBlendOp(vk::BlendOp::eAdd)
-            .setSrcAlphaBlendFactor(vk::BlendFactor::eOne)
-            .setDstAlphaBlendFactor(vk::BlendFactor::eZero)
-            .setAlphaBlendOp(vk::BlendOp::eAdd)
-            .setColorWriteMask(
-                vk::ColorComponentFlagBits::eR |
-                vk::ColorComponentFlagBits::eG |
-                vk::ColorComponentFlagBits::eB |
-                vk::ColorComponentFlagBits::eA
-            );
+        // every color attachment of subpass must have its blend state
+        std::vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachmentStates(
+            colorAttachmentCount, BlendModeToColorBlendAttachmentState(state.Blend)
+        );
 
         vk::PipelineColorBlendStateCreateInfo colorBlendStateCreateInfo;
         colorBlendStateCreateInfo
             .setLogicOpEnable(false)
             .setLogicOp(vk::LogicOp::eCopy)
-            .setAttachments(colorBlendAttachmentState)
+            .setAttachments(colorBlendAttachmentStates)
             .setBlendConstants({ 0.0f, 0.0f, 0.0f, 0.0f });
 
         std::array dynamicStates = {
@@ -529,10 +788,10 @@ namespace VulkanAbstractionLayer
         vk::PipelineDepthStencilStateCreateInfo depthSpencilStateCreateInfo;
         depthSpencilStateCreateInfo
             .setStencilTestEnable(false)
-            .setDepthTestEnable(true)
-            .setDepthWriteEnable(true)
+            .setDepthTestEnable(state.DepthTestEnable)
+            .setDepthWriteEnable(state.DepthWriteEnable)
             .setDepthBoundsTestEnable(false)
-            .setDepthCompareOp(vk::CompareOp::eLess)
+            .setDepthCompareOp(CompareOperationToCompareOp(state.DepthCompare))
             .setMinDepthBounds(0.0f)
             .setMaxDepthBounds(1.0f);
 
@@ -552,142 +811,284 @@ namespace VulkanAbstractionLayer
             .setPDynamicState(&dynamicStateCreateInfo)
             .setLayout(layout)
             .setRenderPass(renderPass)
-            .setSubpass(0)
+            .setSubpass(subpassIndex)
             .setBasePipelineHandle(vk::Pipeline{ })
             .setBasePipelineIndex(0);
 
-        return GetCurrentVulkanContext().GetDevice().createGraphicsPipeline(vk::PipelineCache{ }, pipelineCreateInfo).value;
+        auto& vulkan = GetCurrentVulkanContext();
+        return vulkan.GetDevice().createGraphicsPipeline(vulkan.GetPipelineCache(), pipelineCreateInfo).value;
     }
 
-    static vk::PipelineLayout CreatePipelineLayout(const vk::DescriptorSetLayout& descriptorSetLayout, vk::PipelineBindPoint pipelineType)
+    static vk::PushConstantRange GetPushConstantRange(const Shader& shader)
     {
+        // single range from the start of block, so constants can be pushed at once for all stages
         vk::PushConstantRange pushConstantRange;
         pushConstantRange
             .setOffset(0)
-            .setSize(128)
-            .setStageFlags(PipelineTypeToShaderStages(pipelineType));
+            .setSize(0);
+
+        for (const auto& pushConstants : shader.GetPushConstants())
+        {
+            if (pushConstants.ByteSize == 0) continue;
+            pushConstantRange.stageFlags |= ToNative(pushConstants.ShaderStage);
+            pushConstantRange.size = std::max(pushConstantRange.size, pushConstants.ByteSize);
+        }
+        return pushConstantRange;
+    }
+
+    static std::vector<ShaderUniforms> GetPassShaderUniforms(const Shader& shader, const DescriptorBinding& descriptorBindings)
+    {
+        auto shaderUniforms = shader.GetShaderUniforms();
+        std::vector<ShaderUniforms> passUniforms(shaderUniforms.begin(), shaderUniforms.end());
 
-        vk::PipelineLayoutCreateInfo layoutCreateInfo;
-        layoutCreateInfo
-            .setSetLayouts(descriptorSetLayout)
-            .setPushConstantRanges(pushConstantRange);
+        // reflection can not tell dynamic buffers from regular ones, so their type is taken from pass bindings
+        for (const auto& boundBuffer : descriptorBindings.GetBoundBuffers())
+        {
+            if (boundBuffer.Type != UniformType::UNIFORM_BUFFER_DYNAMIC && boundBuffer.Type != UniformType::STORAGE_BUFFER_DYNAMIC)
+                continue;
 
-        return GetCurrentVulkanContext().GetDevice().createPipelineLayout(layoutCreateInfo);
+            for (auto& stageUniforms : passUniforms)
+            {
+                for (auto& uniform : stageUniforms.Uniforms)
+                {
+                    if (uniform.Binding == boundBuffer.Binding)
+                        uniform.Type = boundBuffer.Type;
+                }
+            }
+        }
+        return passUniforms;
     }
 
-    PassNative RenderGraphBuilder::BuildRenderPass(const RenderPassReference& renderPassReference, const PipelineHashMap& pipelines, const AttachmentHashMap& attachments, const ResourceTransitions& resourceTransitions)
+    std::vector<PassNative> RenderGraphBuilder::BuildRenderPassGroup(const std::vector<size_t>& renderPassGroup, const PipelineHashMap& pipelines, const AttachmentHashMap& attachments, const ResourceTransitions& resourceTransitions, vk::DescriptorSetLayout frameSetLayout, std::vector<RenderPassCompatibility>& compatibilities)
     {
-        PassNative passNative;
+        struct GroupAttachment
+        {
+            std::string Name;
+            vk::AttachmentLoadOp LoadOp;
+            ImageUsage::Bits InitialUsage;
+            ImageUsage::Bits FinalUsage;
+            uint32_t FirstSubpass;
+            uint32_t LastSubpass;
+        };
 
-        std::vector<vk::AttachmentDescription> attachmentDescriptions;
-        std::vector<vk::AttachmentReference> attachmentReferences;
+        struct SubpassAttachments
+        {
+            std::vector<vk::AttachmentReference> ColorAttachments;
+            std::vector<vk::AttachmentReference> InputAttachments;
+            std::vector<uint32_t> PreserveAttachments;
+            std::vector<uint32_t> UsedAttachments;
+            vk::AttachmentReference DepthStencilAttachment;
+        };
+
+        std::vector<PassNative> passNatives(renderPassGroup.size());
+        std::vector<RenderPassCompatibility> subpassCompatibilities(renderPassGroup.size());
+        std::vector<GroupAttachment> groupAttachments;
+        std::vector<SubpassAttachments> subpasses(renderPassGroup.size());
         std::vector<vk::ImageView> attachmentViews;
+        std::vector<vk::ClearValue> clearValues;
 
         uint32_t renderAreaWidth = 0, renderAreaHeight = 0;
 
-        auto& pass = pipelines.at(renderPassReference.Name);
-        auto& renderPassAttachments = pass.GetOutputAttachments();
-        auto& imageTransitions = resourceTransitions.Images.Transitions.at(renderPassReference.Name);
+        auto findGroupAttachment = [&groupAttachments](const std::string& name)
+        {
+            auto it = std::find_if(groupAttachments.begin(), groupAttachments.end(), [&name](const GroupAttachment& attachment) { return attachment.Name == name; });
+            return (uint32_t)(it - groupAttachments.begin());
+        };
 
-        // should render pass be created?
-        if (!renderPassAttachments.empty())
+        for (uint32_t subpassIndex = 0; subpassIndex < (uint32_t)renderPassGroup.size(); subpassIndex++)
         {
-            vk::AttachmentReference depthStencilAttachmentReference;
-            for (size_t attachmentIndex = 0; attachmentIndex < renderPassAttachments.size(); attachmentIndex++)
+            auto& renderPassName = this->renderPassReferences[renderPassGroup[subpassIndex]].Name;
+            auto& pass = pipelines.at(renderPassName);
+            auto& imageTransitions = resourceTransitions.Images.Transitions.at(renderPassName);
+            auto& subpass = subpasses[subpassIndex];
+
+            // input attachments can only reference attachments written by previous subpasses
+            for (const auto& imageDependency : pass.GetImageDependencies())
+            {
+                if (imageDependency.Usage != ImageUsage::INPUT_ATTACHMENT)
+                    continue;
+
+                uint32_t attachmentIndex = findGroupAttachment(imageDependency.Name);
+                assert(attachmentIndex != groupAttachments.size()); // validated by GroupRenderPasses
+
+                auto& groupAttachment = groupAttachments[attachmentIndex];
+                groupAttachment.FinalUsage = ImageUsage::INPUT_ATTACHMENT;
+                groupAttachment.LastSubpass = subpassIndex;
+                subpass.InputAttachments.push_back(vk::AttachmentReference{ attachmentIndex, ImageUsageToImageLayout(ImageUsage::INPUT_ATTACHMENT) });
+                subpass.UsedAttachments.push_back(attachmentIndex);
+            }
+
+            for (const auto& attachment : pass.GetOutputAttachments())
             {
-                const auto& attachment = renderPassAttachments[attachmentIndex];
                 const auto& imageReference = attachments.at(attachment.Name);
-                const auto& attachmentTransition = imageTransitions.at(attachment.Name);
+                auto attachmentUsage = imageTransitions.at(attachment.Name).FinalUsage;
 
-                if (renderAreaWidth == 0 && renderAreaHeight == 0)
+                uint32_t attachmentIndex = findGroupAttachment(attachment.Name);
+                if (attachmentIndex == groupAttachments.size())
                 {
-                    renderAreaWidth = std::max(renderAreaWidth, (uint32_t)imageReference.GetWidth());
-                    renderAreaHeight = std::max(renderAreaHeight, (uint32_t)imageReference.GetHeight());
-                }
+                    auto loadOp = AttachmentStateToLoadOp(attachment.OnLoad);
+                    if (loadOp == vk::AttachmentLoadOp::eLoad && !this->IsAttachmentLoaded(attachment.Name, renderPassGroup.front(), pipelines))
+                        loadOp = vk::AttachmentLoadOp::eDontCare;
 
-                vk::AttachmentDescription attachmentDescription;
-                attachmentDescription
-                    .setFormat(ToNative(imageReference.GetFormat()))
-                    .setSamples(vk::SampleCountFlagBits::e1)
-                    .setLoadOp(AttachmentStateToLoadOp(attachment.OnLoad))
-                    .setStoreOp(vk::AttachmentStoreOp::eStore)
-                    .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
-                    .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
-                    .setInitialLayout(ImageUsageToImageLayout(attachmentTransition.FinalUsage))
-                    .setFinalLayout(ImageUsageToImageLayout(attachmentTransition.FinalUsage));
+                    groupAttachments.push_back(GroupAttachment{ attachment.Name, loadOp, attachmentUsage, attachmentUsage, subpassIndex, subpassIndex });
 
-                attachmentDescriptions.push_back(std::move(attachmentDescription));
-                if (attachment.Layer == Pipeline::OutputAttachment::ALL_LAYERS)
-                    attachmentViews.push_back(imageReference.GetNativeView(ImageView::NATIVE));
-                else
-                    attachmentViews.push_back(imageReference.GetNativeView(ImageView::NATIVE, attachment.Layer));
+                    if (renderAreaWidth == 0 && renderAreaHeight == 0)
+                    {
+                        renderAreaWidth = std::max(renderAreaWidth, (uint32_t)imageReference.GetWidth());
+                        renderAreaHeight = std::max(renderAreaHeight, (uint32_t)imageReference.GetHeight());
+                    }
+
+                    if (attachment.Layer == Pipeline::OutputAttachment::ALL_LAYERS)
+                        attachmentViews.push_back(imageReference.GetNativeView(ImageView::NATIVE));
+                    else
+                        attachmentViews.push_back(imageReference.GetNativeView(ImageView::NATIVE, attachment.Layer));
+
+                    if (attachmentUsage == ImageUsage::DEPTH_SPENCIL_ATTACHMENT)
+                    {
+                        clearValues.push_back(vk::ClearDepthStencilValue{
+                            attachment.DepthSpencilClear.Depth, attachment.DepthSpencilClear.Stencil
+                        });
+                    }
+                    else
+                    {
+                        clearValues.push_back(vk::ClearColorValue{
+                            std::array{ attachment.ColorClear.R, attachment.ColorClear.G, attachment.ColorClear.B, attachment.ColorClear.A }
+                        });
+                    }
+                }
+                auto& groupAttachment = groupAttachments[attachmentIndex];
+                groupAttachment.FinalUsage = attachmentUsage;
+                groupAttachment.LastSubpass = subpassIndex;
+                subpass.UsedAttachments.push_back(attachmentIndex);
 
                 vk::AttachmentReference attachmentReference;
                 attachmentReference
-                    .setAttachment((uint32_t)attachmentIndex)
-                    .setLayout(ImageUsageToImageLayout(attachmentTransition.FinalUsage));
+                    .setAttachment(attachmentIndex)
+                    .setLayout(ImageUsageToImageLayout(attachmentUsage));
 
-                if (attachmentTransition.FinalUsage == ImageUsage::DEPTH_SPENCIL_ATTACHMENT)
-                {
-                    depthStencilAttachmentReference = std::move(attachmentReference);
-                    passNative.ClearValues.push_back(vk::ClearDepthStencilValue{
-                        attachment.DepthSpencilClear.Depth, attachment.DepthSpencilClear.Stencil
-                    });
-                }
+                if (attachmentUsage == ImageUsage::DEPTH_SPENCIL_ATTACHMENT)
+                    subpass.DepthStencilAttachment = std::move(attachmentReference);
                 else
+                    subpass.ColorAttachments.push_back(std::move(attachmentReference));
+            }
+        }
+
+        // should render pass be created?
+        if (!groupAttachments.empty())
+        {
+            std::vector<vk::AttachmentDescription> attachmentDescriptions;
+            for (uint32_t attachmentIndex = 0; attachmentIndex < (uint32_t)groupAttachments.size(); attachmentIndex++)
+            {
+                const auto& groupAttachment = groupAttachments[attachmentIndex];
+                auto format = attachments.at(groupAttachment.Name).GetFormat();
+                auto storeOp = this->IsAttachmentStored(groupAttachment.Name, renderPassGroup.back(), pipelines) ?
+                    vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+                bool hasStencil = (bool)(ImageFormatToImageAspect(format) & vk::ImageAspectFlagBits::eStencil);
+
+                vk::AttachmentDescription attachmentDescription;
+                attachmentDescription
+                    .setFormat(ToNative(format))
+                    .setSamples(vk::SampleCountFlagBits::e1)
+                    .setLoadOp(groupAttachment.LoadOp)
+                    .setStoreOp(storeOp)
+                    .setStencilLoadOp(hasStencil ? groupAttachment.LoadOp : vk::AttachmentLoadOp::eDontCare)
+                    .setStencilStoreOp(hasStencil ? storeOp : vk::AttachmentStoreOp::eDontCare)
+                    .setInitialLayout(ImageUsageToImageLayout(groupAttachment.InitialUsage))
+                    .setFinalLayout(ImageUsageToImageLayout(groupAttachment.FinalUsage));
+                attachmentDescriptions.push_back(std::move(attachmentDescription));
+
+                // attachment content must survive subpasses between its writer and its reader
+                for (uint32_t subpassIndex = groupAttachment.FirstSubpass + 1; subpassIndex < groupAttachment.LastSubpass; subpassIndex++)
                 {
-                    attachmentReferences.push_back(std::move(attachmentReference));
-                    passNative.ClearValues.push_back(vk::ClearColorValue{
-                        std::array{ attachment.ColorClear.R, attachment.ColorClear.G, attachment.ColorClear.B, attachment.ColorClear.A }
-                    });
+                    auto& usedAttachments = subpasses[subpassIndex].UsedAttachments;
+                    if (std::find(usedAttachments.begin(), usedAttachments.end(), attachmentIndex) == usedAttachments.end())
+                        subpasses[subpassIndex].PreserveAttachments.push_back(attachmentIndex);
                 }
             }
 
-            vk::SubpassDescription subpassDescription;
-            subpassDescription
-                .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
-                .setColorAttachments(attachmentReferences)
-                .setPDepthStencilAttachment(depthStencilAttachmentReference != vk::AttachmentReference{ } ?
-                    std::addressof(depthStencilAttachmentReference) : nullptr
-                );
+            std::vector<vk::SubpassDescription> subpassDescriptions;
+            for (const auto& subpass : subpasses)
+            {
+                vk::SubpassDescription subpassDescription;
+                subpassDescription
+                    .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+                    .setColorAttachments(subpass.ColorAttachments)
+                    .setInputAttachments(subpass.InputAttachments)
+                    .setPreserveAttachments(subpass.PreserveAttachments)
+                    .setPDepthStencilAttachment(subpass.DepthStencilAttachment != vk::AttachmentReference{ } ?
+                        std::addressof(subpass.DepthStencilAttachment) : nullptr
+                    );
+                subpassDescriptions.push_back(std::move(subpassDescription));
+            }
 
-            // TODO
-            std::array subpassDependencies = {
-                vk::SubpassDependency {
-                    VK_SUBPASS_EXTERNAL,
-                    0,
-                    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
-                    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
-                    vk::AccessFlagBits::eMemoryRead,
-                    vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
-                    vk::DependencyFlagBits::eByRegion
-                },
-                vk::SubpassDependency {
-                    0,
-                    VK_SUBPASS_EXTERNAL,
-                    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
-                    vk::PipelineStageFlagBits::eBottomOfPipe,
+            // waits for previous usage of each attachment and chains with layout transitions recorded before render pass.
+            // Load reads attachment, so previous writes must be visible to it too, not only to attachment writes
+            vk::SubpassDependency externalDependency;
+            externalDependency
+                .setSrcSubpass(VK_SUBPASS_EXTERNAL)
+                .setDstSubpass(0)
+                .setDependencyFlags(vk::DependencyFlagBits::eByRegion);
+            for (const auto& groupAttachment : groupAttachments)
+            {
+                auto& firstRenderPassName = this->renderPassReferences[renderPassGroup[groupAttachment.FirstSubpass]].Name;
+                auto& imageTransition = resourceTransitions.Images.Transitions.at(firstRenderPassName).at(groupAttachment.Name);
+                auto sourceUsage = imageTransition.AliasedUsage != ImageUsage::UNKNOWN ? imageTransition.AliasedUsage : imageTransition.InitialUsage;
+                bool isDepthStencil = groupAttachment.InitialUsage == ImageUsage::DEPTH_SPENCIL_ATTACHMENT;
+
+                externalDependency.srcStageMask |= ImageUsageToPipelineStage(sourceUsage) | ImageUsageToPipelineStage(groupAttachment.InitialUsage);
+                if (HasImageWriteDependency(sourceUsage))
+                    externalDependency.srcAccessMask |= ImageUsageToAccessFlags(sourceUsage);
+
+                externalDependency.dstStageMask |= isDepthStencil ?
+                    vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests :
+                    vk::PipelineStageFlags{ vk::PipelineStageFlagBits::eColorAttachmentOutput };
+                externalDependency.dstAccessMask |= ImageUsageToAccessFlags(groupAttachment.InitialUsage);
+                if (groupAttachment.LoadOp == vk::AttachmentLoadOp::eLoad)
+                    externalDependency.dstAccessMask |= isDepthStencil ? vk::AccessFlagBits::eDepthStencilAttachmentRead : vk::AccessFlagBits::eColorAttachmentRead;
+            }
+
+            std::vector<vk::SubpassDependency> subpassDependencies;
+            subpassDependencies.push_back(std::move(externalDependency));
+            // each subpass waits for attachment writes of the previous one, same pixel only
+            for (uint32_t subpassIndex = 1; subpassIndex < (uint32_t)subpasses.size(); subpassIndex++)
+            {
+                subpassDependencies.push_back(vk::SubpassDependency{
+                    subpassIndex - 1,
+                    subpassIndex,
+                    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+                    vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
                     vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
-                    vk::AccessFlagBits::eMemoryRead,
+                    vk::AccessFlagBits::eInputAttachmentRead | vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite |
+                    vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
                     vk::DependencyFlagBits::eByRegion
-                },
-            };
+                });
+            }
+            subpassDependencies.push_back(vk::SubpassDependency{
+                (uint32_t)subpasses.size() - 1,
+                VK_SUBPASS_EXTERNAL,
+                vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
+                vk::PipelineStageFlagBits::eBottomOfPipe,
+                vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+                vk::AccessFlagBits::eMemoryRead,
+                vk::DependencyFlagBits::eByRegion
+            });
 
             vk::RenderPassCreateInfo renderPassCreateInfo;
             renderPassCreateInfo
                 .setAttachments(attachmentDescriptions)
-                .setSubpasses(subpassDescription)
+                .setSubpasses(subpassDescriptions)
                 .setDependencies(subpassDependencies);
 
             vk::RenderPassMultiviewCreateInfo renderPassMultiViewCreateInfo;
-            if (!renderPassAttachments.empty())
+            uint32_t viewMask = 0; // referenced by multiview create info, must outlive render pass creation
+            if (renderPassGroup.size() == 1) // merged passes are never layered
             {
-                auto& layeredAttachment = renderPassAttachments.front();
+                auto& layeredAttachment = pipelines.at(this->renderPassReferences[renderPassGroup.front()].Name).GetOutputAttachments().front();
                 uint32_t layerCount = attachments.at(layeredAttachment.Name).GetLayerCount();
 
                 if (layerCount > 1 && layeredAttachment.Layer == Pipeline::OutputAttachment::ALL_LAYERS)
                 {
-                    uint32_t viewMask = (1u << layerCount) - 1; // bits of mask: for example 0b0...011 for 2 views
+                    viewMask = (1u << layerCount) - 1; // bits of mask: for example 0b0...011 for 2 views
                     renderPassMultiViewCreateInfo
                         .setSubpassCount(1)
                         .setViewMasks(viewMask)
@@ -695,49 +1096,220 @@ namespace VulkanAbstractionLayer
                     renderPassCreateInfo.setPNext(&renderPassMultiViewCreateInfo);
                 }
             }
-            passNative.RenderPassHandle = GetCurrentVulkanContext().GetDevice().createRenderPass(renderPassCreateInfo);
+            auto renderPassHandle = GetCurrentVulkanContext().GetDevice().createRenderPass(renderPassCreateInfo);
+
+            // pipelines can be shared between render passes with the same formats and subpass layout
+            PipelineStateKey renderPassKey;
+            renderPassKey.Add(attachmentDescriptions.size());
+            for (const auto& attachmentDescription : attachmentDescriptions)
+            {
+                renderPassKey.Add(attachmentDescription.format);
+                renderPassKey.Add(attachmentDescription.samples);
+            }
+            renderPassKey.Add(subpasses.size());
+            for (const auto& subpass : subpasses)
+            {
+                renderPassKey.Add(subpass.ColorAttachments.size());
+                for (const auto& colorAttachment : subpass.ColorAttachments)
+                    renderPassKey.Add(colorAttachment.attachment);
+                renderPassKey.Add(subpass.InputAttachments.size());
+                for (const auto& inputAttachment : subpass.InputAttachments)
+                    renderPassKey.Add(inputAttachment.attachment);
+                renderPassKey.Add(subpass.DepthStencilAttachment != vk::AttachmentReference{ } ? subpass.DepthStencilAttachment.attachment : VK_ATTACHMENT_UNUSED);
+            }
+            renderPassKey.Add(viewMask);
+
+            for (uint32_t subpassIndex = 0; subpassIndex < (uint32_t)subpasses.size(); subpassIndex++)
+            {
+                subpassCompatibilities[subpassIndex].Key = renderPassKey;
+                subpassCompatibilities[subpassIndex].ColorAttachmentCount = (uint32_t)subpasses[subpassIndex].ColorAttachments.size();
+            }
 
             vk::FramebufferCreateInfo framebufferCreateInfo;
             framebufferCreateInfo
-                .setRenderPass(passNative.RenderPassHandle)
+                .setRenderPass(renderPassHandle)
                 .setAttachments(attachmentViews)
                 .setWidth(renderAreaWidth)
                 .setHeight(renderAreaHeight)
                 .setLayers(1);
-            passNative.Framebuffer = GetCurrentVulkanContext().GetDevice().createFramebuffer(framebufferCreateInfo);
+            auto framebuffer = GetCurrentVulkanContext().GetDevice().createFramebuffer(framebufferCreateInfo);
 
-            passNative.RenderArea = vk::Rect2D{ vk::Offset2D{ 0u, 0u }, vk::Extent2D{ renderAreaWidth, renderAreaHeight } };
+            for (uint32_t subpassIndex = 0; subpassIndex < (uint32_t)passNatives.size(); subpassIndex++)
+            {
+                auto& passNative = passNatives[subpassIndex];
+                passNative.RenderPassHandle = renderPassHandle;
+                passNative.Framebuffer = framebuffer;
+                passNative.RenderArea = vk::Rect2D{ vk::Offset2D{ 0u, 0u }, vk::Extent2D{ renderAreaWidth, renderAreaHeight } };
+                passNative.ClearValues = clearValues;
+                passNative.SubpassIndex = subpassIndex;
+                passNative.SubpassCount = (uint32_t)passNatives.size();
+            }
         }
 
-        if (dynamic_cast<GraphicShader*>(pass.Shader.get()) != nullptr)
-            passNative.PipelineType = vk::PipelineBindPoint::eGraphics;
-        else if (dynamic_cast<ComputeShader*>(pass.Shader.get()) != nullptr)
-            passNative.PipelineType = vk::PipelineBindPoint::eCompute;
-
-        if ((bool)pass.Shader)
+        for (uint32_t subpassIndex = 0; subpassIndex < (uint32_t)passNatives.size(); subpassIndex++)
         {
-            auto descriptor = GetCurrentVulkanContext().GetDescriptorCache().GetDescriptor(pass.Shader->GetShaderUniforms());
-            passNative.DescriptorSet = descriptor.Set;
-            passNative.PipelineLayout = CreatePipelineLayout(descriptor.SetLayout, passNative.PipelineType);
+            auto& passNative = passNatives[subpassIndex];
+            auto& pass = pipelines.at(this->renderPassReferences[renderPassGroup[subpassIndex]].Name);
+
+            if (dynamic_cast<GraphicShader*>(pass.Shader.get()) != nullptr)
+                passNative.PipelineType = vk::PipelineBindPoint::eGraphics;
+            else if (dynamic_cast<ComputeShader*>(pass.Shader.get()) != nullptr)
+                passNative.PipelineType = vk::PipelineBindPoint::eCompute;
 
-            if(passNative.PipelineType == vk::PipelineBindPoint::eGraphics)
-                passNative.Pipeline = CreateGraphicPipeline(*pass.Shader, passNative.PipelineLayout, pass.VertexBindings, passNative.RenderPassHandle);
-            if(passNative.PipelineType == vk::PipelineBindPoint::eCompute)
-                passNative.Pipeline = CreateComputePipeline(*pass.Shader, passNative.PipelineLayout);
+            if ((bool)pass.Shader)
+            {
+                auto& vulkan = GetCurrentVulkanContext();
+                auto& descriptorCache = vulkan.GetDescriptorCache();
+                auto descriptorSetLayout = descriptorCache.GetDescriptorSetLayout(GetPassShaderUniforms(*pass.Shader, pass.DescriptorBindings));
+                passNative.DescriptorSetLayout = descriptorSetLayout;
+                passNative.DynamicOffsetCount = descriptorCache.GetDynamicOffsetCount(descriptorSetLayout);
+                // descriptors are rewritten every frame, so each virtual frame gets its own set to not touch one used by GPU
+                for (size_t frameIndex = 0; frameIndex < vulkan.GetVirtualFrameCount(); frameIndex++)
+                    passNative.DescriptorSets.push_back(descriptorCache.AllocateDescriptorSet(descriptorSetLayout));
+                passNative.MaterialSetLayout = descriptorCache.GetDescriptorSetLayout(pass.Shader->GetSetUniforms(DescriptorSetIndex::MATERIAL));
+                passNative.PushConstantRange = GetPushConstantRange(*pass.Shader);
+
+                std::array setLayouts = { frameSetLayout, vulkan.GetBindlessHeap().GetDescriptorSetLayout(), descriptorSetLayout, passNative.MaterialSetLayout };
+                static_assert(DescriptorSetIndex::FRAME == 0 && DescriptorSetIndex::BINDLESS == 1 && DescriptorSetIndex::PASS == 2 && DescriptorSetIndex::MATERIAL == 3);
+                passNative.PipelineLayout = vulkan.GetPipelineStateCache().GetPipelineLayout(setLayouts, passNative.PushConstantRange);
+                // pipeline itself is compiled later, see CompileRenderPassPipelines
+            }
         }
 
-        return passNative;
+        for (auto& subpassCompatibility : subpassCompatibilities)
+            compatibilities.push_back(std::move(subpassCompatibility));
+
+        return passNatives;
     }
 
-    RenderGraphBuilder::ResourceTransitions RenderGraphBuilder::ResolveResourceTransitions(const PipelineHashMap& pipelines)
+    void RenderGraphBuilder::CompileRenderPassPipelines(std::vector<RenderGraphNode>& nodes, const PipelineHashMap& pipelines, const std::vector<RenderPassCompatibility>& compatibilities)
     {
-        ResourceTransitions resourceTransitions;
-        std::unordered_map<std::string, BufferUsage::Bits> lastBufferUsages;
-        std::unordered_map<std::string, ImageUsage::Bits> lastImageUsages;
+        struct PipelineCompilation
+        {
+            PipelineStateKey Key;
+            std::vector<size_t> NodeIndices;
+            vk::Pipeline Pipeline;
+        };
 
-        for (const auto& renderPassReference : this->renderPassReferences)
+        auto& pipelineStateCache = GetCurrentVulkanContext().GetPipelineStateCache();
+        std::vector<PipelineCompilation> compilations;
+        std::unordered_map<PipelineStateKey, size_t, PipelineStateKey::Hasher> compilationIndices;
+        size_t reusedPipelineCount = 0;
+
+        assert(compatibilities.size() == nodes.size());
+        for (size_t i = 0; i < nodes.size(); i++)
         {
-            auto& pipeline = pipelines.at(renderPassReference.Name);
+            auto& passNative = nodes[i].PassNative;
+            if (!(bool)passNative.PipelineLayout)
+                continue;
+
+            // shaders are identified by bytecode hash instead of module handle, so pipelines survive shader recreation on graph rebuild.
+            // Same bytecode can still get different layouts (frame set union, dynamic buffers chosen per pass), so layout is part of the key.
+            // Layouts are cached for the lifetime of the context, so the handle identifies them across rebuilds
+            auto& pass = pipelines.at(nodes[i].Name);
+            PipelineStateKey key;
+            key.Add(passNative.PipelineType);
+            key.Add(static_cast<VkPipelineLayout>(passNative.PipelineLayout));
+            if (passNative.PipelineType == vk::PipelineBindPoint::eGraphics)
+            {
+                assert(pass.State.SampleCount == 1); // attachments are always single sampled
+                key.Add(pass.Shader->GetBytecodeHash(ShaderType::VERTEX));
+                key.Add(pass.Shader->GetBytecodeHash(ShaderType::FRAGMENT));
+                key.Add(pass.VertexBindings.size());
+                for (const auto& vertexBinding : pass.VertexBindings)
+                {
+                    key.Add(vertexBinding.BindingRange);
+                    key.Add(vertexBinding.InputRate);
+                }
+                key.Add(pass.State.Cull);
+                key.Add(pass.State.Blend);
+                key.Add(pass.State.DepthTestEnable);
+                key.Add(pass.State.DepthWriteEnable);
+                key.Add(pass.State.DepthCompare);
+                key.Add(pass.State.Topology);
+                key.Add(pass.State.SampleCount);
+                key.Add(passNative.SubpassIndex);
+                key.Append(compatibilities[i].Key);
+            }
+            if (passNative.PipelineType == vk::PipelineBindPoint::eCompute)
+            {
+                key.Add(pass.Shader->GetBytecodeHash(ShaderType::COMPUTE));
+            }
+
+            auto cachedPipeline = pipelineStateCache.Find(key);
+            if ((bool)cachedPipeline)
+            {
+                passNative.Pipeline = cachedPipeline;
+                reusedPipelineCount++;
+                continue;
+            }
+
+            auto compilationIndex = compilationIndices.find(key);
+            if (compilationIndex != compilationIndices.end())
+            {
+                compilations[compilationIndex->second].NodeIndices.push_back(i);
+                reusedPipelineCount++;
+                continue;
+            }
+            compilationIndices.emplace(key, compilations.size());
+            compilations.push_back(PipelineCompilation{ std::move(key), { i }, vk::Pipeline{ } });
+        }
+
+        auto compilePipeline = [&nodes, &pipelines, &compatibilities](PipelineCompilation& compilation)
+        {
+            size_t nodeIndex = compilation.NodeIndices.front();
+            auto& passNative = nodes[nodeIndex].PassNative;
+            auto& pass = pipelines.at(nodes[nodeIndex].Name);
+
+            if (passNative.PipelineType == vk::PipelineBindPoint::eGraphics)
+            {
+                compilation.Pipeline = CreateGraphicPipeline(*pass.Shader, passNative.PipelineLayout, pass.VertexBindings, pass.State,
+                    compatibilities[nodeIndex].ColorAttachmentCount, passNative.RenderPassHandle, passNative.SubpassIndex);
+            }
+            if (passNative.PipelineType == vk::PipelineBindPoint::eCompute)
+                compilation.Pipeline = CreateComputePipeline(*pass.Shader, passNative.PipelineLayout);
+        };
+
+        // pipeline cache is internally synchronized, and each task writes only to its own compilation
+        size_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        threadCount = std::min(threadCount, compilations.size());
+        if (threadCount > 1)
+        {
+            WorkerPool workerPool(threadCount);
+            for (auto& compilation : compilations)
+                workerPool.Submit([&compilePipeline, &compilation]() { compilePipeline(compilation); });
+            workerPool.WaitIdle();
+        }
+        else
+        {
+            for (auto& compilation : compilations)
+                compilePipeline(compilation);
+        }
+
+        for (auto& compilation : compilations)
+        {
+            for (size_t nodeIndex : compilation.NodeIndices)
+                nodes[nodeIndex].PassNative.Pipeline = compilation.Pipeline;
+
+            pipelineStateCache.Insert(std::move(compilation.Key), compilation.Pipeline);
+        }
+
+        if ((bool)this->infoCallback)
+        {
+            this->infoCallback("render graph: " + std::to_string(compilations.size()) + " pipelines compiled on " +
+                std::to_string(std::max(threadCount, (size_t)1)) + " threads, " + std::to_string(reusedPipelineCount) + " pipelines reused");
+        }
+    }
+
+    RenderGraphBuilder::ResourceTransitions RenderGraphBuilder::ResolveResourceTransitions(const PipelineHashMap& pipelines)
+    {
+        ResourceTransitions resourceTransitions;
+        std::unordered_map<std::string, BufferUsage::Bits> lastBufferUsages;
+        std::unordered_map<std::string, ImageUsage::Bits> lastImageUsages;
+
+        for (const auto& renderPassReference : this->renderPassReferences)
+        {
+            auto& pipeline = pipelines.at(renderPassReference.Name);
             auto& bufferTransitions = resourceTransitions.Buffers.Transitions[renderPassReference.Name];
             auto& imageTransitions = resourceTransitions.Images.Transitions[renderPassReference.Name];
 
@@ -804,28 +1376,268 @@ namespace VulkanAbstractionLayer
         return resourceTransitions;
     }
 
-    RenderGraphBuilder::AttachmentHashMap RenderGraphBuilder::AllocateAttachments(const PipelineHashMap& pipelines, const ResourceTransitions& transitions)
+    bool RenderGraphBuilder::IsTransientAttachment(const std::string& attachmentName, const PipelineHashMap& pipelines, const ResourceTransitions& transitions)
     {
+        if (attachmentName == this->outputName || this->externalResources.count(attachmentName))
+            return false;
+
+        // async compute runs alongside graphics passes, so memory of its images can not be shared with them
+        for (const auto& renderPassName : this->asyncComputeRenderPasses)
+        {
+            for (const auto& imageDependency : pipelines.at(renderPassName).GetImageDependencies())
+            {
+                if (imageDependency.Name == attachmentName)
+                    return false;
+            }
+        }
+
+        // attachment content must not be read before first write in a frame
+        auto& firstPipeline = pipelines.at(transitions.Images.FirstUsages.at(attachmentName));
+        for (const auto& imageDependency : firstPipeline.GetImageDependencies())
+        {
+            if (imageDependency.Name == attachmentName)
+                return false;
+        }
+
+        for (const auto& outputAttachment : firstPipeline.GetOutputAttachments())
+        {
+            if (outputAttachment.Name == attachmentName)
+            {
+                return outputAttachment.Layer == Pipeline::OutputAttachment::ALL_LAYERS &&
+                    AttachmentStateToLoadOp(outputAttachment.OnLoad) != vk::AttachmentLoadOp::eLoad;
+            }
+        }
+        return false;
+    }
+
+    bool RenderGraphBuilder::IsAttachmentLoaded(const std::string& attachmentName, size_t renderPassIndex, const PipelineHashMap& pipelines)
+    {
+        if (attachmentName == this->outputName || this->externalResources.count(attachmentName))
+            return true;
+
+        for (size_t i = 0; i < renderPassIndex; i++)
+        {
+            auto& pipeline = pipelines.at(this->renderPassReferences[i].Name);
+            for (const auto& attachment : pipeline.GetOutputAttachments())
+            {
+                if (attachment.Name == attachmentName)
+                    return true;
+            }
+            for (const auto& imageDependency : pipeline.GetImageDependencies())
+            {
+                if (imageDependency.Name == attachmentName && HasImageWriteDependency(imageDependency.Usage))
+                    return true;
+            }
+        }
+        // nothing wrote attachment earlier in the frame, so explicit load would only read undefined content.
+        // Attachments which keep content between frames must be declared as external resources
+        return false;
+    }
+
+    bool RenderGraphBuilder::IsAttachmentStored(const std::string& attachmentName, size_t renderPassIndex, const PipelineHashMap& pipelines)
+    {
+        if (attachmentName == this->outputName || this->externalResources.count(attachmentName))
+            return true;
+
+        // content is needed if next usage reads it instead of overwriting
+        for (size_t i = renderPassIndex + 1; i < this->renderPassReferences.size(); i++)
+        {
+            auto& pipeline = pipelines.at(this->renderPassReferences[i].Name);
+            for (const auto& imageDependency : pipeline.GetImageDependencies())
+            {
+                if (imageDependency.Name == attachmentName)
+                    return true;
+            }
+            for (const auto& attachment : pipeline.GetOutputAttachments())
+            {
+                if (attachment.Name == attachmentName)
+                {
+                    return attachment.Layer != Pipeline::OutputAttachment::ALL_LAYERS ||
+                        AttachmentStateToLoadOp(attachment.OnLoad) == vk::AttachmentLoadOp::eLoad;
+                }
+            }
+        }
+        // nothing reads attachment later in the frame, and loads in the next frame are discarded by IsAttachmentLoaded
+        return false;
+    }
+
+    static bool IsLazilyAllocatedMemorySupported()
+    {
+        auto memoryProperties = GetCurrentVulkanContext().GetPhysicalDevice().getMemoryProperties();
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            if (memoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated)
+                return true;
+        }
+        return false;
+    }
+
+    RenderGraphBuilder::AttachmentHashMap RenderGraphBuilder::AllocateAttachments(const PipelineHashMap& pipelines, ResourceTransitions& transitions, std::vector<VmaAllocation>& attachmentMemory, RenderGraphStatistics& statistics)
+    {
+        struct AttachmentAllocation
+        {
+            const Pipeline::AttachmentDeclaration* Declaration;
+            uint32_t Width;
+            uint32_t Height;
+            ImageUsage::Value Usage;
+            vk::MemoryRequirements MemoryRequirements;
+            size_t FirstUsage;
+            size_t LastUsage;
+        };
+
+        struct MemoryBlock
+        {
+            std::vector<size_t> Attachments;
+            vk::MemoryRequirements MemoryRequirements;
+        };
+
         AttachmentHashMap attachments;
+        std::vector<AttachmentAllocation> allocations;
+        std::unordered_map<std::string, size_t> renderPassIndices;
+
+        for (size_t i = 0; i < this->renderPassReferences.size(); i++)
+            renderPassIndices[this->renderPassReferences[i].Name] = i;
 
         auto [surfaceWidth, surfaceHeight] = GetCurrentVulkanContext().GetSurfaceExtent();
 
-        for (const auto& [renderPassName, pipeline] : pipelines)
+        for (const auto& renderPassReference : this->renderPassReferences)
         {
-            auto& attachmentDeclarations = pipeline.GetAttachmentDeclarations();
+            auto& attachmentDeclarations = pipelines.at(renderPassReference.Name).GetAttachmentDeclarations();
             for (const auto& attachment : attachmentDeclarations)
             {
-                auto attachmentUsage = transitions.Images.TotalUsages.at(attachment.Name);
+                auto isDeclared = std::any_of(allocations.begin(), allocations.end(), [&attachment](const AttachmentAllocation& allocation)
+                {
+                    return allocation.Declaration->Name == attachment.Name;
+                });
+                if (isDeclared) continue;
+
+                AttachmentAllocation allocation;
+                allocation.Declaration = &attachment;
+                allocation.Width = attachment.Width == 0 ? surfaceWidth : attachment.Width;
+                allocation.Height = attachment.Height == 0 ? surfaceHeight : attachment.Height;
+                allocation.Usage = transitions.Images.TotalUsages.at(attachment.Name);
+                allocation.MemoryRequirements = GetImageMemoryRequirements(allocation.Width, allocation.Height, attachment.ImageFormat, allocation.Usage, attachment.Options);
+                allocation.FirstUsage = renderPassIndices.at(transitions.Images.FirstUsages.at(attachment.Name));
+                allocation.LastUsage = renderPassIndices.at(transitions.Images.LastUsages.at(attachment.Name));
+
+                statistics.NaiveAttachmentMemory += allocation.MemoryRequirements.size;
+                allocations.push_back(std::move(allocation));
+            }
+        }
 
-                attachments.emplace(attachment.Name, Image(
-                    attachment.Width == 0 ? surfaceWidth : attachment.Width,
-                    attachment.Height == 0 ? surfaceHeight : attachment.Height,
-                    attachment.ImageFormat,
-                    attachmentUsage,
-                    MemoryUsage::GPU_ONLY,
-                    attachment.Options
+        // attachments which are never sampled or copied can live in tile memory on GPUs which support it
+        constexpr ImageUsage::Value AttachmentOnlyUsage = ImageUsage::COLOR_ATTACHMENT | ImageUsage::DEPTH_SPENCIL_ATTACHMENT | ImageUsage::INPUT_ATTACHMENT;
+        bool useLazilyAllocatedMemory = this->lazilyAllocatedAttachments && IsLazilyAllocatedMemorySupported();
+
+        // greedily pack transient attachments with non-overlapping lifetimes into shared memory blocks, largest first
+        std::vector<size_t> transientAttachments;
+        for (size_t i = 0; i < allocations.size(); i++)
+        {
+            auto& allocation = allocations[i];
+            if (!this->IsTransientAttachment(allocation.Declaration->Name, pipelines, transitions))
+                continue;
+
+            if (useLazilyAllocatedMemory && (allocation.Usage & ~AttachmentOnlyUsage) == 0)
+            {
+                statistics.LazilyAllocatedAttachmentCount++;
+                attachments.emplace(allocation.Declaration->Name, Image(
+                    allocation.Width,
+                    allocation.Height,
+                    allocation.Declaration->ImageFormat,
+                    allocation.Usage | ImageUsage::TRANSIENT_ATTACHMENT,
+                    MemoryUsage::GPU_LAZILY_ALLOCATED,
+                    allocation.Declaration->Options
                 ));
+                continue;
             }
+            transientAttachments.push_back(i);
+        }
+        std::stable_sort(transientAttachments.begin(), transientAttachments.end(), [&allocations](size_t left, size_t right)
+        {
+            return allocations[left].MemoryRequirements.size > allocations[right].MemoryRequirements.size;
+        });
+
+        std::vector<MemoryBlock> memoryBlocks;
+        for (size_t attachmentIndex : transientAttachments)
+        {
+            auto& allocation = allocations[attachmentIndex];
+            auto memoryBlock = std::find_if(memoryBlocks.begin(), memoryBlocks.end(), [&allocation, &allocations](const MemoryBlock& block)
+            {
+                if ((block.MemoryRequirements.memoryTypeBits & allocation.MemoryRequirements.memoryTypeBits) == 0)
+                    return false;
+
+                return std::none_of(block.Attachments.begin(), block.Attachments.end(), [&allocation, &allocations](size_t other)
+                {
+                    return allocation.FirstUsage <= allocations[other].LastUsage && allocations[other].FirstUsage <= allocation.LastUsage;
+                });
+            });
+
+            if (memoryBlock == memoryBlocks.end())
+            {
+                memoryBlocks.push_back(MemoryBlock{ { attachmentIndex }, allocation.MemoryRequirements });
+                continue;
+            }
+
+            auto& blockRequirements = memoryBlock->MemoryRequirements;
+            blockRequirements.size = std::max(blockRequirements.size, allocation.MemoryRequirements.size);
+            blockRequirements.alignment = std::max(blockRequirements.alignment, allocation.MemoryRequirements.alignment);
+            blockRequirements.memoryTypeBits &= allocation.MemoryRequirements.memoryTypeBits;
+            memoryBlock->Attachments.push_back(attachmentIndex);
+        }
+
+        for (auto& memoryBlock : memoryBlocks)
+        {
+            if (memoryBlock.Attachments.size() < 2)
+                continue; // nothing to alias with, allocate as usual
+
+            auto memory = AllocateMemory(memoryBlock.MemoryRequirements, MemoryUsage::GPU_ONLY);
+            attachmentMemory.push_back(memory);
+            statistics.AllocatedAttachmentMemory += memoryBlock.MemoryRequirements.size;
+            statistics.AliasedAttachmentCount += memoryBlock.Attachments.size();
+
+            std::sort(memoryBlock.Attachments.begin(), memoryBlock.Attachments.end(), [&allocations](size_t left, size_t right)
+            {
+                return allocations[left].FirstUsage < allocations[right].FirstUsage;
+            });
+
+            // each attachment starts in undefined layout, waiting for the previous attachment in the same memory (wraps around frame)
+            for (size_t i = 0; i < memoryBlock.Attachments.size(); i++)
+            {
+                auto& allocation = allocations[memoryBlock.Attachments[i]];
+                auto& previousAllocation = allocations[memoryBlock.Attachments[(i + memoryBlock.Attachments.size() - 1) % memoryBlock.Attachments.size()]];
+                auto& attachmentName = allocation.Declaration->Name;
+                auto& previousAttachmentName = previousAllocation.Declaration->Name;
+
+                auto& firstTransition = transitions.Images.Transitions.at(this->renderPassReferences[allocation.FirstUsage].Name).at(attachmentName);
+                auto& previousLastTransition = transitions.Images.Transitions.at(this->renderPassReferences[previousAllocation.LastUsage].Name).at(previousAttachmentName);
+                firstTransition.InitialUsage = ImageUsage::UNKNOWN;
+                firstTransition.AliasedUsage = previousLastTransition.FinalUsage;
+
+                attachments.emplace(attachmentName, Image(
+                    allocation.Width,
+                    allocation.Height,
+                    allocation.Declaration->ImageFormat,
+                    allocation.Usage,
+                    memory,
+                    allocation.Declaration->Options
+                ));
+            }
+        }
+
+        for (const auto& allocation : allocations)
+        {
+            if (attachments.find(allocation.Declaration->Name) != attachments.end())
+                continue;
+
+            statistics.AllocatedAttachmentMemory += allocation.MemoryRequirements.size;
+            attachments.emplace(allocation.Declaration->Name, Image(
+                allocation.Width,
+                allocation.Height,
+                allocation.Declaration->ImageFormat,
+                allocation.Usage,
+                MemoryUsage::GPU_ONLY,
+                allocation.Declaration->Options
+            ));
         }
         return attachments;
     }
@@ -847,6 +1659,61 @@ namespace VulkanAbstractionLayer
         return *this;
     }
 
+    RenderGraphBuilder& RenderGraphBuilder::AddExternalResource(const std::string& name)
+    {
+        this->externalResources.insert(name);
+        return *this;
+    }
+
+    RenderGraphBuilder& RenderGraphBuilder::PinRenderPass(const std::string& name)
+    {
+        this->pinnedRenderPasses.insert(name);
+        return *this;
+    }
+
+    RenderGraphBuilder& RenderGraphBuilder::EnableParallelRecording(const std::string& name)
+    {
+        this->parallelRenderPasses.insert(name);
+        return *this;
+    }
+
+    RenderGraphBuilder& RenderGraphBuilder::SetInfoCallback(InfoCallback callback)
+    {
+        this->infoCallback = std::move(callback);
+        return *this;
+    }
+
+    RenderGraphBuilder& RenderGraphBuilder::SetLazilyAllocatedAttachments(bool enabled)
+    {
+        this->lazilyAllocatedAttachments = enabled;
+        return *this;
+    }
+
+    RenderGraphBuilder& RenderGraphBuilder::SetFrameDescriptors(DescriptorBinding bindings, std::function<void(ResolveInfo&)> onResolve)
+    {
+        this->frameDescriptors.Bindings = std::move(bindings);
+        this->frameDescriptors.OnResolve = std::move(onResolve);
+        return *this;
+    }
+
+    void RenderGraphBuilder::CreateFrameDescriptors(const PipelineHashMap& pipelines)
+    {
+        // every pipeline layout of graph gets the same frame set layout, so pipeline layouts stay compatible up to pass set
+        std::vector<ShaderUniforms> frameUniforms;
+        for (const auto& [renderPassName, pipeline] : pipelines)
+        {
+            if (!(bool)pipeline.Shader) continue;
+            auto setUniforms = pipeline.Shader->GetSetUniforms(DescriptorSetIndex::FRAME);
+            frameUniforms.insert(frameUniforms.end(), setUniforms.begin(), setUniforms.end());
+        }
+
+        auto& vulkan = GetCurrentVulkanContext();
+        auto& descriptorCache = vulkan.GetDescriptorCache();
+        this->frameDescriptors.SetLayout = descriptorCache.GetDescriptorSetLayout(frameUniforms);
+        for (size_t frameIndex = 0; frameIndex < vulkan.GetVirtualFrameCount(); frameIndex++)
+            this->frameDescriptors.Sets.push_back(descriptorCache.AllocateDescriptorSet(this->frameDescriptors.SetLayout));
+    }
+
     RenderGraphBuilder::PipelineHashMap RenderGraphBuilder::CreatePipelines()
     {
         PipelineHashMap pipelines;
@@ -856,13 +1723,583 @@ namespace VulkanAbstractionLayer
             renderPassReference.Pass->SetupPipeline(pipeline);
 
             for (const auto& boundBuffer : pipeline.DescriptorBindings.GetBoundBuffers())
-                pipeline.AddDependency(boundBuffer.Name, boundBuffer.Usage);
+                pipeline.AddDependency(GetResourceName(boundBuffer.Handle), boundBuffer.Usage);
             for (const auto& boundImage : pipeline.DescriptorBindings.GetBoundImages())
-                pipeline.AddDependency(boundImage.Name, boundImage.Usage);
+                pipeline.AddDependency(GetResourceName(boundImage.Handle), boundImage.Usage);
         }
         return pipelines;
     }
 
+    void RenderGraphBuilder::CullRenderPasses(PipelineHashMap& pipelines, RenderGraphStatistics& statistics)
+    {
+        // culling is skipped only if neither output nor external resources are set, as then every pass is considered useful.
+        // Culled passes are removed from the graph, RenderGraph::GetNodeByName does not find them
+        if (this->outputName.empty() && this->externalResources.empty())
+            return;
+
+        std::unordered_set<std::string> graphAttachments;
+        for (const auto& [renderPassName, pipeline] : pipelines)
+        {
+            for (const auto& attachment : pipeline.GetAttachmentDeclarations())
+                graphAttachments.insert(attachment.Name);
+        }
+
+        std::unordered_set<std::string> liveResources = this->externalResources;
+        if (!this->outputName.empty()) liveResources.insert(this->outputName);
+
+        // pass is alive if it writes resource outside of graph or resource read by other alive pass
+        // repeat until nothing changes, as resources can be read in next frame before they are written
+        std::vector<bool> isRenderPassAlive(this->renderPassReferences.size(), false);
+        bool hasChanged = true;
+        while (hasChanged)
+        {
+            hasChanged = false;
+            for (size_t i = this->renderPassReferences.size(); i-- > 0;)
+            {
+                if (isRenderPassAlive[i]) continue;
+
+                auto& pipeline = pipelines.at(this->renderPassReferences[i].Name);
+                bool hasWrites = false, isAlive = false;
+                auto checkWrite = [&](const std::string& name)
+                {
+                    hasWrites = true;
+                    isAlive |= graphAttachments.count(name) == 0 || liveResources.count(name) != 0;
+                };
+
+                for (const auto& attachment : pipeline.GetOutputAttachments())
+                    checkWrite(attachment.Name);
+                for (const auto& imageDependency : pipeline.GetImageDependencies())
+                {
+                    if (HasImageWriteDependency(imageDependency.Usage))
+                        checkWrite(imageDependency.Name);
+                }
+                for (const auto& bufferDependency : pipeline.GetBufferDependencies())
+                {
+                    if (HasBufferWriteDependency(bufferDependency.Usage))
+                        checkWrite(bufferDependency.Name);
+                }
+
+                // pinned passes have side effects the graph does not see and are never culled
+                isAlive |= this->pinnedRenderPasses.count(this->renderPassReferences[i].Name) != 0;
+                if (hasWrites && !isAlive) continue;
+
+                isRenderPassAlive[i] = true;
+                hasChanged = true;
+                for (const auto& imageDependency : pipeline.GetImageDependencies())
+                    liveResources.insert(imageDependency.Name);
+                for (const auto& attachment : pipeline.GetOutputAttachments())
+                {
+                    if (AttachmentStateToLoadOp(attachment.OnLoad) == vk::AttachmentLoadOp::eLoad)
+                        liveResources.insert(attachment.Name);
+                }
+            }
+        }
+
+        auto isAttachmentUsed = [](const Pipeline& pipeline, const std::string& name)
+        {
+            auto& outputAttachments = pipeline.GetOutputAttachments();
+            auto& imageDependencies = pipeline.GetImageDependencies();
+            return std::any_of(outputAttachments.begin(), outputAttachments.end(), [&name](const auto& attachment) { return attachment.Name == name; }) ||
+                std::any_of(imageDependencies.begin(), imageDependencies.end(), [&name](const auto& dependency) { return dependency.Name == name; });
+        };
+
+        for (size_t i = 0; i < this->renderPassReferences.size(); i++)
+        {
+            auto& renderPassReference = this->renderPassReferences[i];
+            if (isRenderPassAlive[i]) continue;
+
+            // attachments declared by culled pass can still be used by alive passes, move declaration to first of them
+            for (const auto& attachment : pipelines.at(renderPassReference.Name).GetAttachmentDeclarations())
+            {
+                for (size_t j = 0; j < this->renderPassReferences.size(); j++)
+                {
+                    auto& pipeline = pipelines.at(this->renderPassReferences[j].Name);
+                    if (isRenderPassAlive[j] && isAttachmentUsed(pipeline, attachment.Name))
+                    {
+                        pipeline.DeclareAttachment(attachment.Name, attachment.ImageFormat, attachment.Width, attachment.Height, attachment.Options);
+                        break;
+                    }
+                }
+            }
+
+            if ((bool)this->infoCallback)
+                this->infoCallback("render graph: culled pass " + renderPassReference.Name);
+
+            pipelines.erase(renderPassReference.Name);
+            statistics.CulledPassCount++;
+        }
+
+        std::vector<RenderPassReference> aliveRenderPasses;
+        for (size_t i = 0; i < this->renderPassReferences.size(); i++)
+        {
+            if (isRenderPassAlive[i])
+                aliveRenderPasses.push_back(std::move(this->renderPassReferences[i]));
+        }
+        this->renderPassReferences = std::move(aliveRenderPasses);
+    }
+
+    struct RenderPassResources
+    {
+        std::unordered_set<std::string> Reads;
+        std::unordered_set<std::string> Writes;
+    };
+
+    static RenderPassResources GetRenderPassResources(const Pipeline& pipeline)
+    {
+        RenderPassResources resources;
+        for (const auto& bufferDependency : pipeline.GetBufferDependencies())
+        {
+            if (HasBufferWriteDependency(bufferDependency.Usage))
+                resources.Writes.insert(bufferDependency.Name);
+            else
+                resources.Reads.insert(bufferDependency.Name);
+        }
+        for (const auto& imageDependency : pipeline.GetImageDependencies())
+        {
+            if (HasImageWriteDependency(imageDependency.Usage))
+                resources.Writes.insert(imageDependency.Name);
+            else
+                resources.Reads.insert(imageDependency.Name);
+        }
+        for (const auto& attachment : pipeline.GetOutputAttachments())
+        {
+            resources.Writes.insert(attachment.Name);
+            if (AttachmentStateToLoadOp(attachment.OnLoad) == vk::AttachmentLoadOp::eLoad)
+                resources.Reads.insert(attachment.Name);
+        }
+        return resources;
+    }
+
+    static bool HasResourceConflict(const RenderPassResources& first, const RenderPassResources& second)
+    {
+        for (const auto& name : first.Writes)
+        {
+            if (second.Reads.count(name) != 0 || second.Writes.count(name) != 0)
+                return true;
+        }
+        for (const auto& name : first.Reads)
+        {
+            if (second.Writes.count(name) != 0)
+                return true;
+        }
+        return false;
+    }
+
+    struct ResourceUsageState
+    {
+        std::unordered_map<std::string, BufferUsage::Bits> LastBufferUsages;
+        std::unordered_map<std::string, ImageUsage::Bits> LastImageUsages;
+    };
+
+    // counts transitions for which PipelineBarrierTable will record a barrier if pass is executed next
+    static size_t CountRenderPassBarriers(const Pipeline& pipeline, const ResourceUsageState& state)
+    {
+        size_t barrierCount = 0;
+        auto countImageBarrier = [&state, &barrierCount](const std::string& name, ImageUsage::Bits usage)
+        {
+            auto lastUsage = state.LastImageUsages.find(name);
+            if (lastUsage != state.LastImageUsages.end() && (lastUsage->second != usage || HasImageWriteDependency(lastUsage->second)))
+                barrierCount++;
+        };
+
+        for (const auto& bufferDependency : pipeline.GetBufferDependencies())
+        {
+            auto lastUsage = state.LastBufferUsages.find(bufferDependency.Name);
+            if (lastUsage != state.LastBufferUsages.end() && HasBufferWriteDependency(lastUsage->second))
+                barrierCount++;
+        }
+        for (const auto& imageDependency : pipeline.GetImageDependencies())
+            countImageBarrier(imageDependency.Name, imageDependency.Usage);
+        for (const auto& attachment : pipeline.GetOutputAttachments())
+            countImageBarrier(attachment.Name, AttachmentStateToImageUsage(attachment.OnLoad));
+
+        return barrierCount;
+    }
+
+    static void UpdateResourceUsageState(const Pipeline& pipeline, ResourceUsageState& state)
+    {
+        for (const auto& bufferDependency : pipeline.GetBufferDependencies())
+            state.LastBufferUsages[bufferDependency.Name] = bufferDependency.Usage;
+        for (const auto& imageDependency : pipeline.GetImageDependencies())
+            state.LastImageUsages[imageDependency.Name] = imageDependency.Usage;
+        for (const auto& attachment : pipeline.GetOutputAttachments())
+            state.LastImageUsages[attachment.Name] = AttachmentStateToImageUsage(attachment.OnLoad);
+    }
+
+    void RenderGraphBuilder::ScheduleRenderPasses(const PipelineHashMap& pipelines, RenderGraphStatistics& statistics)
+    {
+        const size_t renderPassCount = this->renderPassReferences.size();
+
+        std::vector<RenderPassResources> renderPassResources;
+        renderPassResources.reserve(renderPassCount);
+        for (const auto& renderPassReference : this->renderPassReferences)
+            renderPassResources.push_back(GetRenderPassResources(pipelines.at(renderPassReference.Name)));
+
+        // edge i -> j if passes access same resource and one of them writes it. Pinned passes depend on everything around them
+        std::vector<std::vector<bool>> dependencies(renderPassCount, std::vector<bool>(renderPassCount, false));
+        std::vector<size_t> dependencyCounts(renderPassCount, 0);
+        for (size_t i = 0; i < renderPassCount; i++)
+        {
+            bool isPinned = this->pinnedRenderPasses.count(this->renderPassReferences[i].Name) != 0;
+            for (size_t j = i + 1; j < renderPassCount; j++)
+            {
+                bool isOtherPinned = this->pinnedRenderPasses.count(this->renderPassReferences[j].Name) != 0;
+                if (isPinned || isOtherPinned || HasResourceConflict(renderPassResources[i], renderPassResources[j]))
+                {
+                    dependencies[i][j] = true;
+                    dependencyCounts[j]++;
+                }
+            }
+        }
+
+        ResourceUsageState unscheduledState;
+        for (const auto& renderPassReference : this->renderPassReferences)
+        {
+            auto& pipeline = pipelines.at(renderPassReference.Name);
+            statistics.UnscheduledBarrierCount += CountRenderPassBarriers(pipeline, unscheduledState);
+            UpdateResourceUsageState(pipeline, unscheduledState);
+        }
+
+        // input attachments are only read within merged group, so their reader must directly follow the writer
+        auto readsInputAttachmentOf = [this, &pipelines](size_t readerIndex, size_t writerIndex)
+        {
+            auto& outputAttachments = pipelines.at(this->renderPassReferences[writerIndex].Name).GetOutputAttachments();
+            for (const auto& imageDependency : pipelines.at(this->renderPassReferences[readerIndex].Name).GetImageDependencies())
+            {
+                if (imageDependency.Usage != ImageUsage::INPUT_ATTACHMENT)
+                    continue;
+                if (std::any_of(outputAttachments.begin(), outputAttachments.end(), [&imageDependency](const auto& attachment) { return attachment.Name == imageDependency.Name; }))
+                    return true;
+            }
+            return false;
+        };
+
+        // topological sort, preferring input attachment readers of previous pass, then passes which need fewer barriers and do not depend on previous pass
+        ResourceUsageState scheduledState;
+        std::vector<size_t> schedule;
+        std::vector<bool> isScheduled(renderPassCount, false);
+        schedule.reserve(renderPassCount);
+        while (schedule.size() < renderPassCount)
+        {
+            size_t bestIndex = renderPassCount, bestBarrierCount = 0;
+            bool bestDependsOnPrevious = false;
+            for (size_t i = 0; i < renderPassCount; i++)
+            {
+                if (isScheduled[i] || dependencyCounts[i] != 0) continue;
+
+                size_t barrierCount = CountRenderPassBarriers(pipelines.at(this->renderPassReferences[i].Name), scheduledState);
+                bool dependsOnPrevious = !schedule.empty() && dependencies[schedule.back()][i];
+                if (!schedule.empty() && readsInputAttachmentOf(i, schedule.back()))
+                {
+                    bestIndex = i;
+                    bestBarrierCount = barrierCount;
+                    break;
+                }
+                if (bestIndex == renderPassCount || barrierCount < bestBarrierCount ||
+                    (barrierCount == bestBarrierCount && !dependsOnPrevious && bestDependsOnPrevious))
+                {
+                    bestIndex = i;
+                    bestBarrierCount = barrierCount;
+                    bestDependsOnPrevious = dependsOnPrevious;
+                }
+            }
+            assert(bestIndex != renderPassCount);
+
+            isScheduled[bestIndex] = true;
+            schedule.push_back(bestIndex);
+            statistics.ScheduledBarrierCount += bestBarrierCount;
+            UpdateResourceUsageState(pipelines.at(this->renderPassReferences[bestIndex].Name), scheduledState);
+            for (size_t j = bestIndex + 1; j < renderPassCount; j++)
+            {
+                if (dependencies[bestIndex][j]) dependencyCounts[j]--;
+            }
+        }
+
+        std::vector<RenderPassReference> scheduledRenderPasses;
+        scheduledRenderPasses.reserve(renderPassCount);
+        for (size_t index : schedule)
+            scheduledRenderPasses.push_back(std::move(this->renderPassReferences[index]));
+        this->renderPassReferences = std::move(scheduledRenderPasses);
+
+        if ((bool)this->infoCallback)
+        {
+            this->infoCallback("render graph scheduling: " +
+                std::to_string(statistics.UnscheduledBarrierCount) + " barriers in insertion order, " +
+                std::to_string(statistics.ScheduledBarrierCount) + " barriers after reordering"
+            );
+        }
+    }
+
+    bool RenderGraphBuilder::CanMergeRenderPass(const std::vector<size_t>& renderPassGroup, size_t renderPassIndex, const PipelineHashMap& pipelines, const AttachmentHashMap& attachments)
+    {
+        auto isMergeable = [this, &pipelines, &attachments](size_t index)
+        {
+            auto& renderPassName = this->renderPassReferences[index].Name;
+            auto& pipeline = pipelines.at(renderPassName);
+            auto& outputAttachments = pipeline.GetOutputAttachments();
+
+            if (this->pinnedRenderPasses.count(renderPassName) != 0 || outputAttachments.empty())
+                return false;
+            if (dynamic_cast<GraphicShader*>(pipeline.Shader.get()) == nullptr)
+                return false;
+
+            return std::all_of(outputAttachments.begin(), outputAttachments.end(), [&attachments](const Pipeline::OutputAttachment& attachment)
+            {
+                return attachment.Layer == Pipeline::OutputAttachment::ALL_LAYERS && attachments.at(attachment.Name).GetLayerCount() == 1;
+            });
+        };
+
+        if (!isMergeable(renderPassGroup.front()) || !isMergeable(renderPassIndex))
+            return false;
+
+        auto& pipeline = pipelines.at(this->renderPassReferences[renderPassIndex].Name);
+        auto& groupRenderArea = attachments.at(pipelines.at(this->renderPassReferences[renderPassGroup.front()].Name).GetOutputAttachments().front().Name);
+        for (const auto& attachment : pipeline.GetOutputAttachments())
+        {
+            auto& image = attachments.at(attachment.Name);
+            if (image.GetWidth() != groupRenderArea.GetWidth() || image.GetHeight() != groupRenderArea.GetHeight())
+                return false;
+        }
+
+        RenderPassResources groupResources;
+        std::unordered_set<std::string> groupAttachments;
+        for (size_t index : renderPassGroup)
+        {
+            auto& groupPipeline = pipelines.at(this->renderPassReferences[index].Name);
+            auto resources = GetRenderPassResources(groupPipeline);
+            groupResources.Reads.insert(resources.Reads.begin(), resources.Reads.end());
+            groupResources.Writes.insert(resources.Writes.begin(), resources.Writes.end());
+            for (const auto& attachment : groupPipeline.GetOutputAttachments())
+                groupAttachments.insert(attachment.Name);
+        }
+
+        auto isOutputAttachment = [&pipeline](const std::string& name)
+        {
+            auto& outputAttachments = pipeline.GetOutputAttachments();
+            return std::any_of(outputAttachments.begin(), outputAttachments.end(), [&name](const auto& attachment) { return attachment.Name == name; });
+        };
+
+        // only same pixel reads of group attachments are allowed, everything else needs a real barrier between passes
+        for (const auto& imageDependency : pipeline.GetImageDependencies())
+        {
+            if (imageDependency.Usage == ImageUsage::INPUT_ATTACHMENT)
+            {
+                if (groupAttachments.count(imageDependency.Name) == 0 || isOutputAttachment(imageDependency.Name))
+                    return false;
+            }
+            else if (groupResources.Writes.count(imageDependency.Name) != 0)
+                return false;
+
+            if (HasImageWriteDependency(imageDependency.Usage) && groupResources.Reads.count(imageDependency.Name) != 0)
+                return false;
+        }
+        for (const auto& bufferDependency : pipeline.GetBufferDependencies())
+        {
+            if (groupResources.Writes.count(bufferDependency.Name) != 0)
+                return false;
+            if (HasBufferWriteDependency(bufferDependency.Usage) && groupResources.Reads.count(bufferDependency.Name) != 0)
+                return false;
+        }
+        for (const auto& attachment : pipeline.GetOutputAttachments())
+        {
+            bool isGroupAttachment = groupAttachments.count(attachment.Name) != 0;
+            if (isGroupAttachment && AttachmentStateToLoadOp(attachment.OnLoad) != vk::AttachmentLoadOp::eLoad)
+                return false;
+            if (!isGroupAttachment && groupResources.Reads.count(attachment.Name) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    std::vector<std::vector<size_t>> RenderGraphBuilder::GroupRenderPasses(const PipelineHashMap& pipelines, const AttachmentHashMap& attachments, RenderGraphStatistics& statistics)
+    {
+        std::vector<std::vector<size_t>> renderPassGroups;
+        for (size_t i = 0; i < this->renderPassReferences.size(); i++)
+        {
+            if (!renderPassGroups.empty() && this->CanMergeRenderPass(renderPassGroups.back(), i, pipelines, attachments))
+            {
+                renderPassGroups.back().push_back(i);
+                statistics.MergedPassCount++;
+            }
+            else
+            {
+                renderPassGroups.push_back({ i });
+            }
+        }
+
+        // input attachment is a subpass attachment, it can only be read if previous pass of the same group wrote it
+        for (const auto& renderPassGroup : renderPassGroups)
+        {
+            std::unordered_set<std::string> writtenAttachments;
+            for (size_t index : renderPassGroup)
+            {
+                auto& renderPassName = this->renderPassReferences[index].Name;
+                auto& pipeline = pipelines.at(renderPassName);
+                for (const auto& imageDependency : pipeline.GetImageDependencies())
+                {
+                    if (imageDependency.Usage == ImageUsage::INPUT_ATTACHMENT && writtenAttachments.count(imageDependency.Name) == 0)
+                    {
+                        throw std::runtime_error("render graph: pass " + renderPassName + " reads input attachment " + imageDependency.Name +
+                            " which is not written by previous pass merged with it, sample the image instead");
+                    }
+                }
+                for (const auto& attachment : pipeline.GetOutputAttachments())
+                    writtenAttachments.insert(attachment.Name);
+            }
+        }
+        return renderPassGroups;
+    }
+
+    void RenderGraphBuilder::SetupAsyncComputeRenderPasses(const PipelineHashMap& pipelines, RenderGraphStatistics& statistics)
+    {
+        this->asyncComputeRenderPasses.clear();
+        if (!GetCurrentVulkanContext().HasAsyncComputeQueue())
+            return;
+
+        for (const auto& renderPassReference : this->renderPassReferences)
+        {
+            // pinned passes must stay ordered with everything around them
+            if (this->pinnedRenderPasses.count(renderPassReference.Name) != 0)
+                continue;
+            if (dynamic_cast<ComputeShader*>(pipelines.at(renderPassReference.Name).Shader.get()) != nullptr)
+                this->asyncComputeRenderPasses.insert(renderPassReference.Name);
+        }
+        statistics.AsyncComputePassCount = this->asyncComputeRenderPasses.size();
+    }
+
+    RenderGraphBuilder::QueueTransferHashMap RenderGraphBuilder::ResolveQueueTransfers(const PipelineHashMap& pipelines)
+    {
+        QueueTransferHashMap queueTransfers;
+        if (this->asyncComputeRenderPasses.empty())
+            return queueTransfers;
+
+        // first sweep finds last users in a frame, which are previous users for the next frame as graph is repeated
+        std::unordered_map<std::string, RenderPassName> lastUsers;
+        for (size_t sweep = 0; sweep < 2; sweep++)
+        {
+            for (const auto& renderPassReference : this->renderPassReferences)
+            {
+                auto resources = GetRenderPassResources(pipelines.at(renderPassReference.Name));
+                bool isAsyncCompute = this->asyncComputeRenderPasses.count(renderPassReference.Name) != 0;
+
+                auto registerUsage = [&](const std::string& resourceName)
+                {
+                    auto lastUser = lastUsers.find(resourceName);
+                    if (sweep == 1 && lastUser != lastUsers.end() && (this->asyncComputeRenderPasses.count(lastUser->second) != 0) != isAsyncCompute)
+                        queueTransfers[renderPassReference.Name][resourceName] = lastUser->second;
+                    lastUsers[resourceName] = renderPassReference.Name;
+                };
+                for (const auto& resourceName : resources.Reads)
+                    registerUsage(resourceName);
+                for (const auto& resourceName : resources.Writes)
+                    registerUsage(resourceName);
+            }
+        }
+        return queueTransfers;
+    }
+
+    std::vector<AsyncComputeBatch> RenderGraphBuilder::CreateAsyncComputeBatches(std::vector<RenderGraphNode>& nodes, const ResourceTransitions& transitions, const QueueTransferHashMap& queueTransfers)
+    {
+        using BufferTransitionHashMap = std::unordered_map<std::string, BufferTransition>;
+        using ImageTransitionHashMap = std::unordered_map<std::string, ImageTransition>;
+
+        std::vector<AsyncComputeBatch> batches;
+        if (this->asyncComputeRenderPasses.empty())
+            return batches;
+
+        // every render pass is a separate node, merged subpasses included
+        assert(nodes.size() == this->renderPassReferences.size());
+        std::unordered_map<RenderPassName, size_t> renderPassIndices;
+        for (size_t i = 0; i < this->renderPassReferences.size(); i++)
+        {
+            auto& renderPassName = this->renderPassReferences[i].Name;
+            renderPassIndices[renderPassName] = i;
+            if (this->asyncComputeRenderPasses.count(renderPassName) == 0)
+                continue;
+
+            if (batches.empty() || batches.back().LastNodeIndex != i)
+                batches.push_back(AsyncComputeBatch{ i, i + 1 });
+            else
+                batches.back().LastNodeIndex = i + 1;
+        }
+
+        auto& vulkan = GetCurrentVulkanContext();
+        auto createReleaseCallback = [](const QueueTransferInfo& queueTransfer, const BufferTransitionHashMap& buffers, const ImageTransitionHashMap& images) -> AsyncComputeBatch::ReleaseCallback
+        {
+            if (queueTransfer.SourceQueueFamily == queueTransfer.DistanceQueueFamily)
+                return [](CommandBuffer&, const ResolveInfo&) { };
+
+            return [barrierTable = PipelineBarrierTable(buffers, images, queueTransfer)](CommandBuffer& commandBuffer, const ResolveInfo& resolveInfo) mutable
+            {
+                barrierTable.Emit(commandBuffer, resolveInfo);
+            };
+        };
+
+        for (auto& batch : batches)
+        {
+            QueueTransferInfo graphicsRelease{ { }, vulkan.GetQueueFamilyIndex(), vulkan.GetComputeQueueFamilyIndex(), false, true };
+            QueueTransferInfo computeRelease{ { }, vulkan.GetComputeQueueFamilyIndex(), vulkan.GetQueueFamilyIndex(), true, true };
+            BufferTransitionHashMap graphicsReleaseBuffers, computeReleaseBuffers;
+            ImageTransitionHashMap graphicsReleaseImages, computeReleaseImages;
+
+            // release is recorded with the same transition as acquire on the other queue
+            auto addRelease = [&transitions](const RenderPassName& acquireRenderPassName, const std::string& resourceName, QueueTransferInfo& release, BufferTransitionHashMap& buffers, ImageTransitionHashMap& images)
+            {
+                release.Resources.insert(resourceName);
+                auto& bufferTransitions = transitions.Buffers.Transitions.at(acquireRenderPassName);
+                auto& imageTransitions = transitions.Images.Transitions.at(acquireRenderPassName);
+                if (bufferTransitions.count(resourceName) != 0)
+                    buffers.emplace(resourceName, bufferTransitions.at(resourceName));
+                if (imageTransitions.count(resourceName) != 0)
+                    images.emplace(resourceName, imageTransitions.at(resourceName));
+            };
+
+            for (size_t i = batch.FirstNodeIndex; i < batch.LastNodeIndex; i++)
+            {
+                auto& renderPassName = this->renderPassReferences[i].Name;
+                if (queueTransfers.count(renderPassName) == 0) continue;
+
+                for (const auto& [resourceName, previousRenderPassName] : queueTransfers.at(renderPassName))
+                    addRelease(renderPassName, resourceName, graphicsRelease, graphicsReleaseBuffers, graphicsReleaseImages);
+            }
+
+            for (const auto& [renderPassName, renderPassQueueTransfers] : queueTransfers)
+            {
+                size_t renderPassIndex = renderPassIndices.at(renderPassName);
+                if (this->asyncComputeRenderPasses.count(renderPassName) != 0)
+                    continue;
+
+                for (const auto& [resourceName, previousRenderPassName] : renderPassQueueTransfers)
+                {
+                    size_t previousRenderPassIndex = renderPassIndices.at(previousRenderPassName);
+                    if (previousRenderPassIndex < batch.FirstNodeIndex || previousRenderPassIndex >= batch.LastNodeIndex)
+                        continue;
+
+                    addRelease(renderPassName, resourceName, computeRelease, computeReleaseBuffers, computeReleaseImages);
+
+                    // graphics waits at stages where batch results are accessed first, passes of the next frame included
+                    auto& bufferTransitions = transitions.Buffers.Transitions.at(renderPassName);
+                    auto& imageTransitions = transitions.Images.Transitions.at(renderPassName);
+                    if (bufferTransitions.count(resourceName) != 0)
+                        batch.GraphicsWaitStages |= BufferUsageToPipelineStage(bufferTransitions.at(resourceName).FinalUsage);
+                    if (imageTransitions.count(resourceName) != 0)
+                        batch.GraphicsWaitStages |= ImageUsageToPipelineStage(imageTransitions.at(resourceName).FinalUsage);
+
+                    // semaphore can not be waited inside of render pass, so the first subpass waits for the whole group
+                    if (renderPassIndex >= batch.LastNodeIndex)
+                        nodes[renderPassIndex - nodes[renderPassIndex].PassNative.SubpassIndex].WaitsForAsyncCompute = true;
+                }
+            }
+
+            if (!batch.GraphicsWaitStages)
+                batch.GraphicsWaitStages = vk::PipelineStageFlagBits::eAllCommands;
+
+            batch.GraphicsQueueRelease = createReleaseCallback(graphicsRelease, graphicsReleaseBuffers, graphicsReleaseImages);
+            batch.ComputeQueueRelease = createReleaseCallback(computeRelease, computeReleaseBuffers, computeReleaseImages);
+        }
+        return batches;
+    }
+
     ImageTransition RenderGraphBuilder::GetOutputImageFinalTransition(const std::string& outputName, const ResourceTransitions& resourceTransitions)
     {
         const auto& firstRenderPassName = resourceTransitions.Images.FirstUsages.at(outputName);
@@ -893,25 +2330,69 @@ namespace VulkanAbstractionLayer
 
     std::unique_ptr<RenderGraph> RenderGraphBuilder::Build()
     {
+        RenderGraphStatistics statistics;
         PipelineHashMap pipelines = this->CreatePipelines();
+        this->CullRenderPasses(pipelines, statistics);
+        this->ScheduleRenderPasses(pipelines, statistics);
+        this->SetupAsyncComputeRenderPasses(pipelines, statistics);
         ResourceTransitions resourceTransitions = this->ResolveResourceTransitions(pipelines);
         if (!this->outputName.empty()) this->SetupOutputImage(resourceTransitions, this->outputName);
-        AttachmentHashMap attachments = this->AllocateAttachments(pipelines, resourceTransitions);
+        std::vector<VmaAllocation> attachmentMemory;
+        AttachmentHashMap attachments = this->AllocateAttachments(pipelines, resourceTransitions, attachmentMemory, statistics);
+        this->CreateFrameDescriptors(pipelines);
+
+        if ((bool)this->infoCallback)
+        {
+            this->infoCallback("render graph attachments: " +
+                std::to_string(statistics.AllocatedAttachmentMemory / 1024) + " KB allocated, " +
+                std::to_string(statistics.NaiveAttachmentMemory / 1024) + " KB without aliasing, " +
+                std::to_string(statistics.AliasedAttachmentCount) + " attachments aliased, " +
+                std::to_string(statistics.CulledPassCount) + " passes culled"
+            );
+        }
 
         std::vector<RenderGraphNode> nodes;
+        std::vector<RenderPassCompatibility> compatibilities;
+        auto queueTransfers = this->ResolveQueueTransfers(pipelines);
+        auto renderPassGroups = this->GroupRenderPasses(pipelines, attachments, statistics);
 
-        for (auto& renderPassReference : this->renderPassReferences)
+        for (const auto& renderPassGroup : renderPassGroups)
         {
-            auto renderPass = this->BuildRenderPass(renderPassReference, pipelines, attachments, resourceTransitions);
+            auto renderPasses = this->BuildRenderPassGroup(renderPassGroup, pipelines, attachments, resourceTransitions, this->frameDescriptors.SetLayout, compatibilities);
 
-            nodes.push_back(RenderGraphNode{
-                renderPassReference.Name,
-                renderPass,
-                std::move(renderPassReference.Pass),
-                this->GetRenderPassAttachmentNames(renderPassReference.Name, pipelines),
-                this->CreatePipelineBarrierCallback(renderPassReference.Name, pipelines.at(renderPassReference.Name), resourceTransitions),
-                this->GetRenderPassDescriptorBinding(renderPassReference.Name, pipelines),
-            });
+            for (size_t subpassIndex = 0; subpassIndex < renderPassGroup.size(); subpassIndex++)
+            {
+                auto& renderPassReference = this->renderPassReferences[renderPassGroup[subpassIndex]];
+                nodes.push_back(RenderGraphNode{
+                    renderPassReference.Name,
+                    renderPasses[subpassIndex],
+                    std::move(renderPassReference.Pass),
+                    this->GetRenderPassAttachmentNames(renderPassReference.Name, pipelines),
+                    this->CreatePipelineBarrierCallback(renderPassGroup, subpassIndex, pipelines, resourceTransitions, queueTransfers),
+                    this->GetRenderPassDescriptorBinding(renderPassReference.Name, pipelines),
+                    // async compute passes are recorded into their own command buffer
+                    this->parallelRenderPasses.count(renderPassReference.Name) != 0 && this->asyncComputeRenderPasses.count(renderPassReference.Name) == 0,
+                });
+            }
+        }
+
+        if ((bool)this->infoCallback)
+            this->infoCallback("render graph: " + std::to_string(statistics.MergedPassCount) + " passes merged as subpasses");
+
+        this->CompileRenderPassPipelines(nodes, pipelines, compatibilities);
+
+        if ((bool)this->infoCallback)
+        {
+            auto& descriptorCache = GetCurrentVulkanContext().GetDescriptorCache();
+            this->infoCallback("descriptor set layouts: " + std::to_string(descriptorCache.GetLayoutCount()) + " cached, " +
+                std::to_string(descriptorCache.GetLayoutHitCount()) + " hits, " + std::to_string(descriptorCache.GetLayoutMissCount()) + " misses");
+        }
+
+        auto asyncComputeBatches = this->CreateAsyncComputeBatches(nodes, resourceTransitions, queueTransfers);
+        if ((bool)this->infoCallback && !asyncComputeBatches.empty())
+        {
+            this->infoCallback("render graph: " + std::to_string(statistics.AsyncComputePassCount) + " passes submitted to async compute queue in " +
+                std::to_string(asyncComputeBatches.size()) + " batches");
         }
 
         auto OnCreate = this->CreateCreateCallback(pipelines, resourceTransitions, attachments);
@@ -923,9 +2404,13 @@ namespace VulkanAbstractionLayer
         return std::make_unique<RenderGraph>(
             std::move(nodes), 
             std::move(attachments), 
+            std::move(attachmentMemory),
             std::move(this->outputName), 
             std::move(OnPresent),
-            std::move(OnCreate)
+            std::move(OnCreate),
+            std::move(statistics),
+            std::move(asyncComputeBatches),
+            std::move(this->frameDescriptors)
         );
     }
 }
\ No newline at end of file
@@ -33,10 +33,12 @@
 #include <array>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "RenderGraph.h"
 #include "Shader.h"
 #include "DescriptorBinding.h"
+#include "PipelineStateCache.h"
 
 namespace VulkanAbstractionLayer
 {
@@ -44,6 +46,7 @@ namespace VulkanAbstractionLayer
     {
         ImageUsage::Bits InitialUsage;
         ImageUsage::Bits FinalUsage;
+        ImageUsage::Bits AliasedUsage = ImageUsage::UNKNOWN; // last usage of other attachment sharing the same memory
     };
 
     struct BufferTransition
@@ -81,29 +84,69 @@ namespace VulkanAbstractionLayer
             ResourceTypeTransitions<std::string, ImageTransition> Images;
         };
 
+        struct RenderPassCompatibility
+        {
+            PipelineStateKey Key;
+            uint32_t ColorAttachmentCount = 0;
+        };
+
         using AttachmentHashMap = std::unordered_map<std::string, Image>;
         using PipelineHashMap = std::unordered_map<RenderPassName, Pipeline>;
         using PipelineBarrierCallback = std::function<void(CommandBuffer&, const ResolveInfo&)>;
         using PresentCallback = std::function<void(CommandBuffer&, const Image&, const Image&)>;
         using CreateCallback = std::function<void(CommandBuffer&)>;
+        using InfoCallback = std::function<void(const std::string&)>;
+        using QueueTransferHashMap = std::unordered_map<RenderPassName, std::unordered_map<std::string, RenderPassName>>;
 
         std::vector<RenderPassReference> renderPassReferences;
+        std::unordered_set<std::string> externalResources;
+        std::unordered_set<std::string> pinnedRenderPasses;
+        std::unordered_set<std::string> parallelRenderPasses;
+        std::unordered_set<std::string> asyncComputeRenderPasses;
         std::string outputName;
+        InfoCallback infoCallback;
+        bool lazilyAllocatedAttachments = false;
+        FrameDescriptors frameDescriptors;
         
-        PassNative BuildRenderPass(const RenderPassReference& renderPassReference, const PipelineHashMap& pipelines, const AttachmentHashMap& attachments, const ResourceTransitions& resourceTransitions);
-        PipelineBarrierCallback CreatePipelineBarrierCallback(const std::string& renderPassName, const Pipeline& pipeline, const ResourceTransitions& resourceTransitions);
+        std::vector<PassNative> BuildRenderPassGroup(const std::vector<size_t>& renderPassGroup, const PipelineHashMap& pipelines, const AttachmentHashMap& attachments, const ResourceTransitions& resourceTransitions, vk::DescriptorSetLayout frameSetLayout, std::vector<RenderPassCompatibility>& compatibilities);
+        void CompileRenderPassPipelines(std::vector<RenderGraphNode>& nodes, const PipelineHashMap& pipelines, const std::vector<RenderPassCompatibility>& compatibilities);
+        PipelineBarrierCallback CreatePipelineBarrierCallback(const std::vector<size_t>& renderPassGroup, size_t subpassIndex, const PipelineHashMap& pipelines, const ResourceTransitions& resourceTransitions, const QueueTransferHashMap& queueTransfers);
         PresentCallback CreatePresentCallback(const std::string& outputName, const ResourceTransitions& transitions);
         CreateCallback CreateCreateCallback(const PipelineHashMap& pipelines, const ResourceTransitions& transitions, const AttachmentHashMap& attachments);
         ResourceTransitions ResolveResourceTransitions(const PipelineHashMap& pipelines);
-        AttachmentHashMap AllocateAttachments(const PipelineHashMap& pipelines, const ResourceTransitions& transitions);
+        AttachmentHashMap AllocateAttachments(const PipelineHashMap& pipelines, ResourceTransitions& transitions, std::vector<VmaAllocation>& attachmentMemory, RenderGraphStatistics& statistics);
+        bool IsTransientAttachment(const std::string& attachmentName, const PipelineHashMap& pipelines, const ResourceTransitions& transitions);
+        bool IsAttachmentLoaded(const std::string& attachmentName, size_t renderPassIndex, const PipelineHashMap& pipelines);
+        bool IsAttachmentStored(const std::string& attachmentName, size_t renderPassIndex, const PipelineHashMap& pipelines);
         void SetupOutputImage(ResourceTransitions& transitions, const std::string& outputImage);
         PipelineHashMap CreatePipelines();
+        void CullRenderPasses(PipelineHashMap& pipelines, RenderGraphStatistics& statistics);
+        void ScheduleRenderPasses(const PipelineHashMap& pipelines, RenderGraphStatistics& statistics);
+        bool CanMergeRenderPass(const std::vector<size_t>& renderPassGroup, size_t renderPassIndex, const PipelineHashMap& pipelines, const AttachmentHashMap& attachments);
+        std::vector<std::vector<size_t>> GroupRenderPasses(const PipelineHashMap& pipelines, const AttachmentHashMap& attachments, RenderGraphStatistics& statistics);
+        void SetupAsyncComputeRenderPasses(const PipelineHashMap& pipelines, RenderGraphStatistics& statistics);
+        QueueTransferHashMap ResolveQueueTransfers(const PipelineHashMap& pipelines);
+        std::vector<AsyncComputeBatch> CreateAsyncComputeBatches(std::vector<RenderGraphNode>& nodes, const ResourceTransitions& transitions, const QueueTransferHashMap& queueTransfers);
         ImageTransition GetOutputImageFinalTransition(const std::string& outputName, const ResourceTransitions& resourceTransitions);
         std::vector<std::string> GetRenderPassAttachmentNames(const std::string& renderPassName, const PipelineHashMap& pipelines);
         DescriptorBinding GetRenderPassDescriptorBinding(const std::string& renderPassName, const PipelineHashMap& pipelines);
+        void CreateFrameDescriptors(const PipelineHashMap& pipelines);
     public:
         RenderGraphBuilder& AddRenderPass(const std::string& name, std::unique_ptr<RenderPass> renderPass);
         RenderGraphBuilder& SetOutputName(const std::string& name);
+        // resource is used outside of the graph: passes writing it are not culled, attachment content is kept between frames
+        RenderGraphBuilder& AddExternalResource(const std::string& name);
+        // pinned pass is never culled or reordered, use it for passes with side effects outside of the graph
+        RenderGraphBuilder& PinRenderPass(const std::string& name);
+        // records OnRender of the pass into secondary command buffer on worker thread. Other callbacks of consecutive
+        // parallel passes run on calling thread in graph order before any of them is recorded, so OnRender must not depend on
+        // callbacks of later passes. Commands recorded by BeforeRender are still executed in graph order, right before pass barriers
+        RenderGraphBuilder& EnableParallelRecording(const std::string& name);
+        RenderGraphBuilder& SetInfoCallback(InfoCallback callback);
+        RenderGraphBuilder& SetLazilyAllocatedAttachments(bool enabled);
+        // bindings of frame set, see DescriptorSetIndex::FRAME. Bound resources are not tracked by graph barriers,
+        // so they must be ready before graph is executed. Resolve callback runs every frame before bindings are resolved
+        RenderGraphBuilder& SetFrameDescriptors(DescriptorBinding bindings, std::function<void(ResolveInfo&)> onResolve = { });
         std::unique_ptr<RenderGraph> Build();
     };
 }
\ No newline at end of file
@@ -31,6 +31,11 @@
 
 namespace VulkanAbstractionLayer
 {
+    const Image& RenderPassState::GetAttachment(ResourceHandle handle)
+    {
+        return this->Graph.GetAttachmentByName(handle);
+    }
+
     const Image& RenderPassState::GetAttachment(const std::string& name)
     {
         return this->Graph.GetAttachmentByName(name);
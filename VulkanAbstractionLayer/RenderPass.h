@@ -38,13 +38,21 @@ namespace VulkanAbstractionLayer
     struct PassNative
     {
         vk::RenderPass RenderPassHandle;
-        vk::DescriptorSet DescriptorSet;
+        vk::DescriptorSetLayout DescriptorSetLayout;
+        vk::DescriptorSet DescriptorSet; // set of current virtual frame
+        vk::DescriptorSet FrameDescriptorSet; // render graph frame globals of current virtual frame
+        vk::DescriptorSetLayout MaterialSetLayout; // material sets bound by pass must be allocated with this layout
+        std::vector<vk::DescriptorSet> DescriptorSets; // one per virtual frame
         vk::Framebuffer Framebuffer;
         vk::Pipeline Pipeline;
         vk::PipelineLayout PipelineLayout;
+        vk::PushConstantRange PushConstantRange;
+        uint32_t DynamicOffsetCount = 0;
         vk::PipelineBindPoint PipelineType = { };
         vk::Rect2D RenderArea = { };
         std::vector<vk::ClearValue> ClearValues;
+        uint32_t SubpassIndex = 0;
+        uint32_t SubpassCount = 1;
     };
 
     struct RenderPassState
@@ -53,6 +61,7 @@ namespace VulkanAbstractionLayer
         CommandBuffer& Commands;
         const PassNative& Pass;
 
+        const Image& GetAttachment(ResourceHandle handle);
         const Image& GetAttachment(const std::string& name);
     };
 
@@ -0,0 +1,89 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "ResourceHandle.h"
+
+#include <cassert>
+
+namespace VulkanAbstractionLayer
+{
+    ResourceHandle ResourceRegistry::Intern(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->handles.find(name);
+        if (it != this->handles.end())
+            return it->second;
+
+        auto handle = (ResourceHandle)this->names.size();
+        this->handles.emplace(name, handle);
+        this->names.push_back(name);
+        return handle;
+    }
+
+    ResourceHandle ResourceRegistry::Find(const std::string& name) const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->handles.find(name);
+        return it != this->handles.end() ? it->second : InvalidResourceHandle;
+    }
+
+    ResourceHandle ResourceRegistry::Get(const std::string& name) const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->handles.at(name);
+    }
+
+    const std::string& ResourceRegistry::GetName(ResourceHandle handle) const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        assert(handle < this->names.size());
+        return this->names[handle];
+    }
+
+    size_t ResourceRegistry::GetHandleCount() const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->names.size();
+    }
+
+    ResourceRegistry& GetResourceRegistry()
+    {
+        static ResourceRegistry registry;
+        return registry;
+    }
+
+    ResourceHandle InternResourceName(const std::string& name)
+    {
+        return GetResourceRegistry().Intern(name);
+    }
+
+    const std::string& GetResourceName(ResourceHandle handle)
+    {
+        return GetResourceRegistry().GetName(handle);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+namespace VulkanAbstractionLayer
+{
+    using ResourceHandle = uint32_t;
+    constexpr ResourceHandle InvalidResourceHandle = ResourceHandle(-1);
+
+    // maps resource and render pass names to compact indices. Registry is global and never pruned, names are interned
+    // when graphs are built and bindings are declared. Passes recorded on worker threads can query it while other
+    // threads intern names, so every access is locked. Names are kept in deque, returned references stay valid
+    class ResourceRegistry
+    {
+        std::unordered_map<std::string, ResourceHandle> handles;
+        std::deque<std::string> names;
+        mutable std::mutex mutex;
+
+    public:
+        ResourceHandle Intern(const std::string& name);
+        ResourceHandle Find(const std::string& name) const;
+        ResourceHandle Get(const std::string& name) const; // throws std::out_of_range for unknown names
+        const std::string& GetName(ResourceHandle handle) const;
+        size_t GetHandleCount() const;
+    };
+
+    ResourceRegistry& GetResourceRegistry();
+    ResourceHandle InternResourceName(const std::string& name);
+    const std::string& GetResourceName(ResourceHandle handle);
+}
\ No newline at end of file
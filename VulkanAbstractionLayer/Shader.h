@@ -41,13 +41,24 @@ namespace VulkanAbstractionLayer
 {
     class VulkanContext;
 
+    inline uint64_t HashShaderBytecode(ArrayView<const uint32_t> bytecode)
+    {
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        for (uint32_t word : bytecode)
+            hash = (hash ^ word) * 1099511628211ull;
+        return hash;
+    }
+
     class Shader
     {
     public:
         virtual ~Shader() = default;
 
         virtual ArrayView<const TypeSPIRV> GetInputAttributes() const = 0;
-        virtual ArrayView<const ShaderUniforms> GetShaderUniforms() const = 0;
+        virtual ArrayView<const ShaderUniforms> GetShaderUniforms() const = 0; // uniforms of pass set
+        virtual ArrayView<const ShaderUniforms> GetSetUniforms(uint32_t setIndex) const = 0;
+        virtual ArrayView<const ShaderPushConstants> GetPushConstants() const = 0;
         virtual const vk::ShaderModule& GetNativeShader(ShaderType type) const = 0;
+        virtual uint64_t GetBytecodeHash(ShaderType type) const = 0;
     };
 }
\ No newline at end of file
@@ -320,6 +320,25 @@ namespace VulkanAbstractionLayer
         if (result.DescriptorSets.empty()) 
             result.DescriptorSets.emplace_back(); // insert empty descriptor set
 
+        uint32_t pushConstantBlockCount = 0;
+        spvResult = spvReflectEnumeratePushConstantBlocks(&reflectedShader, &pushConstantBlockCount, nullptr);
+        assert(spvResult == SPV_REFLECT_RESULT_SUCCESS);
+        std::vector<SpvReflectBlockVariable*> pushConstantBlocks(pushConstantBlockCount);
+        spvResult = spvReflectEnumeratePushConstantBlocks(&reflectedShader, &pushConstantBlockCount, pushConstantBlocks.data());
+        assert(spvResult == SPV_REFLECT_RESULT_SUCCESS);
+
+        for (const auto& pushConstantBlock : pushConstantBlocks)
+        {
+            // member offsets are relative to the start of push constant memory
+            uint32_t blockEnd = pushConstantBlock->member_count == 0 ? pushConstantBlock->offset + pushConstantBlock->size : 0;
+            for (uint32_t i = 0; i < pushConstantBlock->member_count; i++)
+            {
+                const auto& member = pushConstantBlock->members[i];
+                blockEnd = std::max(blockEnd, member.offset + member.size);
+            }
+            result.PushConstantByteSize = std::max(result.PushConstantByteSize, (blockEnd + 3) & ~3u);
+        }
+
         spvReflectDestroyShaderModule(&reflectedShader);
 
         return result;
@@ -44,6 +44,7 @@ namespace VulkanAbstractionLayer
         BytecodeSPIRV Bytecode;
         Attributes InputAttributes;
         Uniforms DescriptorSets;
+        uint32_t PushConstantByteSize = 0;
     };
 
     class ShaderLoader
@@ -264,6 +264,12 @@ namespace VulkanAbstractionLayer
         ShaderType ShaderStage;
     };
 
+    struct ShaderPushConstants
+    {
+        uint32_t ByteSize; // from the start of push constant block, zero if stage does not use push constants
+        ShaderType ShaderStage;
+    };
+
     inline bool operator==(const TypeSPIRV& t1, const TypeSPIRV& t2) { return t1.LayoutFormat == t2.LayoutFormat && t1.ComponentCount == t2.ComponentCount && t1.ByteSize == t2.ByteSize; }
     inline bool operator!=(const TypeSPIRV& t1, const TypeSPIRV& t2) { return !(t1 == t2); }
 
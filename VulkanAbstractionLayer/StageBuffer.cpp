@@ -27,35 +27,129 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "StageBuffer.h"
+#include "VulkanContext.h"
+
+#include <algorithm>
+#include <numeric>
 
 namespace VulkanAbstractionLayer
 {
-	StageBuffer::StageBuffer(size_t byteSize)
-		: buffer(byteSize, BufferUsage::TRANSFER_SOURCE, MemoryUsage::CPU_TO_GPU), currentOffset(0)
+	StageBuffer::StageBuffer(size_t byteSize, size_t virtualFrameCount)
+		: buffer(byteSize, BufferUsage::TRANSFER_SOURCE, MemoryUsage::CPU_TO_GPU)
 	{
+		const auto& limits = GetCurrentVulkanContext().GetPhysicalDeviceProperties().limits;
+		// 16 bytes covers 4 byte offsets required by buffer to image copies and texel blocks of compressed formats
+		constexpr vk::DeviceSize MinCopyOffsetAlignment = 16;
+		this->alignment = (uint32_t)std::max({ MinCopyOffsetAlignment, limits.optimalBufferCopyOffsetAlignment, limits.nonCoherentAtomSize });
+		this->flushAlignment = (uint32_t)limits.nonCoherentAtomSize;
+		assert(byteSize % this->alignment == 0);
+
 		(void)this->buffer.MapMemory();
+		this->frameAllocatedBytes.resize(virtualFrameCount, 0);
+		this->frameOverflowBuffers.resize(virtualFrameCount);
 	}
 
 	StageBuffer::Allocation StageBuffer::Submit(const uint8_t* data, uint32_t byteSize)
 	{
-		assert(this->currentOffset + byteSize <= this->buffer.GetByteSize());
+		return this->Submit(data, byteSize, this->alignment);
+	}
 
-		if (data != nullptr)
+	StageBuffer::Allocation StageBuffer::Submit(const uint8_t* data, uint32_t byteSize, uint32_t alignment)
+	{
+		assert(alignment != 0);
+		// texel size of some formats is not power of two (e.g. 12 bytes of R32G32B32), so offset must be multiple of both
+		uint64_t offsetAlignment = std::lcm((uint64_t)alignment, (uint64_t)this->alignment);
+
+		uint64_t capacity = this->buffer.GetByteSize();
+		uint64_t currentOffset = this->allocatedBytes % capacity;
+		uint64_t offset = (currentOffset + offsetAlignment - 1) / offsetAlignment * offsetAlignment;
+		// allocation is never split between the end and the start of the ring
+		if (offset + byteSize > capacity) offset = capacity;
+		uint64_t padding = offset - currentOffset;
+
+		if (this->GetUsedByteSize() + padding + byteSize > capacity)
 		{
-			this->buffer.CopyData(data, byteSize, this->currentOffset);
+			auto& overflowBuffer = this->overflowBuffers.emplace_back(
+				std::make_unique<Buffer>(byteSize, BufferUsage::TRANSFER_SOURCE, MemoryUsage::CPU_TO_GPU)
+			);
+			this->overflowByteSize += byteSize;
+
+			if (data != nullptr)
+			{
+				overflowBuffer->CopyData(data, byteSize, 0);
+			}
+			return Allocation{ byteSize, 0, overflowBuffer.get() };
 		}
 
-		this->currentOffset += byteSize;
-		return Allocation{ byteSize, this->currentOffset - byteSize };
+		if (offset == capacity) offset = 0;
+		this->allocatedBytes += padding + byteSize;
+
+		if (data != nullptr)
+		{
+			this->buffer.CopyData(data, byteSize, offset);
+		}
+		return Allocation{ byteSize, (uint32_t)offset, std::addressof(this->buffer) };
 	}
 
 	void StageBuffer::Reset()
 	{
-		this->currentOffset = 0;
+		this->Flush();
+		this->releasedBytes = this->allocatedBytes;
+		this->overflowBuffers.clear();
+		for (auto& overflowBuffers : this->frameOverflowBuffers)
+			overflowBuffers.clear();
+		this->overflowByteSize = 0;
+	}
+
+	void StageBuffer::StartFrame(size_t frameIndex)
+	{
+		// frame fence is already waited, so everything submitted before and with this frame was read
+		this->releasedBytes = std::max(this->releasedBytes, this->frameAllocatedBytes[frameIndex]);
+		for (const auto& overflowBuffer : this->frameOverflowBuffers[frameIndex])
+			this->overflowByteSize -= overflowBuffer->GetByteSize();
+		this->frameOverflowBuffers[frameIndex].clear();
+	}
+
+	void StageBuffer::EndFrame(size_t frameIndex)
+	{
+		this->frameAllocatedBytes[frameIndex] = this->allocatedBytes;
+		auto& frameOverflowBuffers = this->frameOverflowBuffers[frameIndex];
+		for (auto& overflowBuffer : this->overflowBuffers)
+			frameOverflowBuffers.push_back(std::move(overflowBuffer));
+		this->overflowBuffers.clear();
 	}
 
 	void StageBuffer::Flush()
 	{
-		this->buffer.FlushMemory(this->currentOffset, 0);
+		uint64_t capacity = this->buffer.GetByteSize();
+		uint64_t unflushedBytes = this->allocatedBytes - this->flushedBytes;
+		this->flushedBytes = this->allocatedBytes;
+		if (unflushedBytes == 0) return;
+
+		if (unflushedBytes >= capacity)
+		{
+			this->buffer.FlushMemory();
+			return;
+		}
+
+		uint64_t begin = (this->allocatedBytes - unflushedBytes) % capacity;
+		uint64_t end = begin + unflushedBytes;
+		if (end <= capacity)
+		{
+			this->FlushRange(begin, end);
+		}
+		else
+		{
+			this->FlushRange(begin, capacity);
+			this->FlushRange(0, end - capacity);
+		}
+	}
+
+	void StageBuffer::FlushRange(uint64_t begin, uint64_t end)
+	{
+		// flushed range must be aligned to atom size, except when it ends at the end of the buffer
+		uint64_t alignedBegin = begin & ~uint64_t(this->flushAlignment - 1);
+		uint64_t alignedEnd = std::min((end + this->flushAlignment - 1) & ~uint64_t(this->flushAlignment - 1), (uint64_t)this->buffer.GetByteSize());
+		this->buffer.FlushMemory(alignedEnd - alignedBegin, alignedBegin);
 	}
 }
\ No newline at end of file
@@ -31,28 +31,55 @@
 #include "Buffer.h"
 #include "ArrayUtils.h"
 
+#include <vector>
+#include <memory>
+
 namespace VulkanAbstractionLayer
 {
+	// ring shared by all virtual frames. Regions are reclaimed once fence of the frame which submitted them is waited,
+	// requests which do not fit into free part of the ring are served by dedicated buffers living for one frame
 	class StageBuffer
 	{
 		Buffer buffer;
-		uint32_t currentOffset;
+		// monotonic byte counters, ring offset is counter modulo buffer size. Allocated bytes include padding skipped on wrap
+		uint64_t allocatedBytes = 0;
+		uint64_t releasedBytes = 0;
+		uint64_t flushedBytes = 0;
+		std::vector<uint64_t> frameAllocatedBytes; // per virtual frame, allocated bytes when frame was submitted
+		std::vector<std::vector<std::unique_ptr<Buffer>>> frameOverflowBuffers; // per virtual frame
+		std::vector<std::unique_ptr<Buffer>> overflowBuffers; // allocated since last submitted frame
+		size_t overflowByteSize = 0;
+		uint32_t alignment = 1; // default offset alignment of allocations, see StageBuffer constructor
+		uint32_t flushAlignment = 1;
+
+		void FlushRange(uint64_t begin, uint64_t end);
 
 	public:
 		struct Allocation
 		{
 			uint32_t Size;
 			uint32_t Offset;
+			const Buffer* Source; // ring buffer or dedicated overflow buffer, see GetBuffer
 		};
 
-		StageBuffer(size_t byteSize);
+		StageBuffer() = default;
+		StageBuffer(size_t byteSize, size_t virtualFrameCount);
 
 		Allocation Submit(const uint8_t* data, uint32_t byteSize);
+		// offset is multiple of both alignment and default copy alignment, so alignment can be texel size of any format
+		Allocation Submit(const uint8_t* data, uint32_t byteSize, uint32_t alignment);
 		void Flush();
+		// releases everything submitted so far, GPU must not read any staged data, e.g. after immediate submission
 		void Reset();
+		void StartFrame(size_t frameIndex);
+		void EndFrame(size_t frameIndex);
 		Buffer& GetBuffer() { return this->buffer; }
 		const Buffer& GetBuffer() const { return this->buffer; }
-		uint32_t GetCurrentOffset() const { return this->currentOffset; }
+		const Buffer& GetBuffer(const Allocation& allocation) const { return *allocation.Source; }
+		uint32_t GetCurrentOffset() const { return uint32_t(this->allocatedBytes % this->buffer.GetByteSize()); }
+		size_t GetUsedByteSize() const { return size_t(this->allocatedBytes - this->releasedBytes); }
+		size_t GetOverflowByteSize() const { return this->overflowByteSize; }
+		uint32_t GetAlignment() const { return this->alignment; }
 
 		template<typename T>
 		Allocation Submit(ArrayView<const T> view)
@@ -66,6 +93,18 @@ namespace VulkanAbstractionLayer
 			return this->Submit((const uint8_t*)view.data(), uint32_t(view.size() * sizeof(T)));
 		}
 
+		template<typename T>
+		Allocation Submit(ArrayView<const T> view, uint32_t alignment)
+		{
+			return this->Submit((const uint8_t*)view.data(), uint32_t(view.size() * sizeof(T)), alignment);
+		}
+
+		template<typename T>
+		Allocation Submit(ArrayView<T> view, uint32_t alignment)
+		{
+			return this->Submit((const uint8_t*)view.data(), uint32_t(view.size() * sizeof(T)), alignment);
+		}
+
 		template<typename T>
 		Allocation Submit(const T* value)
 		{
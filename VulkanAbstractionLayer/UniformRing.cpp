@@ -0,0 +1,76 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "UniformRing.h"
+#include "VulkanContext.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace VulkanAbstractionLayer
+{
+    UniformRing::UniformRing(size_t byteSize)
+        : buffer(byteSize, BufferUsage::UNIFORM_BUFFER | BufferUsage::STORAGE_BUFFER, MemoryUsage::CPU_TO_GPU)
+    {
+        const auto& limits = GetCurrentVulkanContext().GetPhysicalDeviceProperties().limits;
+        // same ring is used for both uniform and storage buffers
+        this->alignment = (uint32_t)std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+        (void)this->buffer.MapMemory();
+    }
+
+    UniformRing::Allocation UniformRing::Submit(const uint8_t* data, uint32_t byteSize)
+    {
+        // alignment is always power of two
+        uint32_t offset = (this->currentOffset + this->alignment - 1) & ~(this->alignment - 1);
+        // descriptors reference this buffer with dynamic offsets, so data can not be moved to other buffer mid-frame
+        if ((size_t)offset + byteSize > this->buffer.GetByteSize())
+        {
+            throw std::length_error("uniform ring: " + std::to_string(offset + byteSize) + " bytes requested in one frame, but ring has only " +
+                std::to_string(this->buffer.GetByteSize()) + " bytes, increase ContextInitializeOptions::MaxUniformRingSize");
+        }
+
+        if (data != nullptr)
+        {
+            this->buffer.CopyData(data, byteSize, offset);
+        }
+
+        this->currentOffset = offset + byteSize;
+        return Allocation{ byteSize, offset };
+    }
+
+    void UniformRing::Reset()
+    {
+        this->currentOffset = 0;
+    }
+
+    void UniformRing::Flush()
+    {
+        this->buffer.FlushMemory(this->currentOffset, 0);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,277 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "UploadBatch.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace VulkanAbstractionLayer
+{
+    UploadBatch::BufferUpload& UploadBatch::GetBufferUpload(const Buffer& distance, BufferUsage::Bits finalUsage)
+    {
+        for (auto& upload : this->bufferUploads)
+        {
+            if (upload.Distance != std::addressof(distance)) continue;
+            assert(upload.FinalUsage == finalUsage);
+            return upload;
+        }
+        return this->bufferUploads.emplace_back(BufferUpload{ std::addressof(distance), finalUsage });
+    }
+
+    UploadBatch::ImageUpload& UploadBatch::GetImageUpload(const Image& distance, ImageUsage::Bits initialUsage, ImageUsage::Bits finalUsage)
+    {
+        for (auto& upload : this->imageUploads)
+        {
+            if (upload.Distance != std::addressof(distance)) continue;
+            // image is already transfered by previous copy of this batch
+            assert(upload.FinalUsage == finalUsage);
+            assert(initialUsage == upload.InitialUsage || initialUsage == ImageUsage::TRANSFER_DISTINATION);
+            return upload;
+        }
+        return this->imageUploads.emplace_back(ImageUpload{ std::addressof(distance), initialUsage, finalUsage });
+    }
+
+    void UploadBatch::CopyBuffer(const BufferInfo& source, const BufferInfo& distance, size_t byteSize, BufferUsage::Bits finalUsage)
+    {
+        assert(source.Resource.get().GetByteSize() >= source.Offset + byteSize);
+        assert(distance.Resource.get().GetByteSize() >= distance.Offset + byteSize);
+
+        vk::BufferCopy bufferCopyInfo;
+        bufferCopyInfo
+            .setDstOffset(distance.Offset)
+            .setSize(byteSize)
+            .setSrcOffset(source.Offset);
+
+        auto& upload = this->GetBufferUpload(distance.Resource.get(), finalUsage);
+        upload.Regions.emplace_back(std::addressof(source.Resource.get()), bufferCopyInfo);
+    }
+
+    void UploadBatch::CopyBufferToImage(const BufferInfo& source, const ImageInfo& distance, ImageUsage::Bits finalUsage)
+    {
+        auto distanceLayers = GetDefaultImageSubresourceLayers(distance.Resource.get(), distance.MipLevel, distance.Layer);
+
+        vk::BufferImageCopy bufferToImageCopyInfo;
+        bufferToImageCopyInfo
+            .setBufferOffset(source.Offset)
+            .setBufferImageHeight(0)
+            .setBufferRowLength(0)
+            .setImageSubresource(distanceLayers)
+            .setImageOffset(vk::Offset3D{ 0, 0, 0 })
+            .setImageExtent(vk::Extent3D{
+                distance.Resource.get().GetMipLevelWidth(distance.MipLevel),
+                distance.Resource.get().GetMipLevelHeight(distance.MipLevel),
+                1
+            });
+
+        auto& upload = this->GetImageUpload(distance.Resource.get(), distance.Usage, finalUsage);
+        upload.Regions.emplace_back(std::addressof(source.Resource.get()), bufferToImageCopyInfo);
+    }
+
+    void UploadBatch::RecordBarriers(CommandBuffer& commandBuffer, bool beforeCopies, OwnershipTransfer* ownershipTransfer)
+    {
+        vk::PipelineStageFlags pipelineSourceFlags = { };
+        vk::PipelineStageFlags pipelineDistanceFlags = { };
+        this->bufferBarriers.clear();
+        this->imageBarriers.clear();
+
+        // barriers after copies release ownership, barriers before them are recorded on source queue only
+        bool releasesOwnership = ownershipTransfer != nullptr && !beforeCopies;
+        uint32_t sourceQueueFamily = releasesOwnership ? ownershipTransfer->SourceQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+        uint32_t distanceQueueFamily = releasesOwnership ? ownershipTransfer->DistanceQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+
+        for (const auto& upload : this->bufferUploads)
+        {
+            // source queue can not wait for previous reads of other queue, so released buffers must not be in use
+            if (ownershipTransfer != nullptr && beforeCopies) break;
+            if (upload.FinalUsage == BufferUsage::UNKNOWN && !releasesOwnership) continue;
+            // before copies previous reads of the buffer are waited, after them new data is made visible
+            auto oldUsage = beforeCopies ? upload.FinalUsage : BufferUsage::TRANSFER_DESTINATION;
+            auto newUsage = beforeCopies ? BufferUsage::TRANSFER_DESTINATION : upload.FinalUsage;
+            pipelineSourceFlags |= BufferUsageToPipelineStage(oldUsage);
+            pipelineDistanceFlags |= BufferUsageToPipelineStage(newUsage);
+
+            vk::BufferMemoryBarrier bufferBarrier;
+            bufferBarrier
+                .setBuffer(upload.Distance->GetNativeHandle())
+                .setSrcAccessMask(BufferUsageToAccessFlags(oldUsage))
+                .setDstAccessMask(BufferUsageToAccessFlags(newUsage))
+                .setSrcQueueFamilyIndex(sourceQueueFamily)
+                .setDstQueueFamilyIndex(distanceQueueFamily)
+                .setSize(VK_WHOLE_SIZE)
+                .setOffset(0);
+            this->bufferBarriers.push_back(bufferBarrier);
+        }
+
+        for (const auto& upload : this->imageUploads)
+        {
+            auto oldUsage = beforeCopies ? upload.InitialUsage : ImageUsage::TRANSFER_DISTINATION;
+            auto newUsage = beforeCopies ? ImageUsage::TRANSFER_DISTINATION : upload.FinalUsage;
+            if (oldUsage == newUsage && !releasesOwnership) continue;
+            assert(ownershipTransfer == nullptr || !beforeCopies || oldUsage == ImageUsage::UNKNOWN);
+            pipelineSourceFlags |= ImageUsageToPipelineStage(oldUsage);
+            pipelineDistanceFlags |= ImageUsageToPipelineStage(newUsage);
+
+            vk::ImageMemoryBarrier imageBarrier;
+            imageBarrier
+                .setImage(upload.Distance->GetNativeHandle())
+                .setOldLayout(ImageUsageToImageLayout(oldUsage))
+                .setNewLayout(ImageUsageToImageLayout(newUsage))
+                .setSrcAccessMask(ImageUsageToAccessFlags(oldUsage))
+                .setDstAccessMask(ImageUsageToAccessFlags(newUsage))
+                .setSrcQueueFamilyIndex(sourceQueueFamily)
+                .setDstQueueFamilyIndex(distanceQueueFamily)
+                .setSubresourceRange(GetDefaultImageSubresourceRange(*upload.Distance));
+            this->imageBarriers.push_back(imageBarrier);
+        }
+
+        if (releasesOwnership)
+        {
+            // acquire barriers repeat release ones, but only make data visible on distance queue
+            ownershipTransfer->DistanceStages = pipelineDistanceFlags;
+            ownershipTransfer->BufferBarriers = this->bufferBarriers;
+            ownershipTransfer->ImageBarriers = this->imageBarriers;
+            for (auto& bufferBarrier : ownershipTransfer->BufferBarriers)
+                bufferBarrier.setSrcAccessMask({ });
+            for (auto& imageBarrier : ownershipTransfer->ImageBarriers)
+                imageBarrier.setSrcAccessMask({ });
+
+            for (auto& bufferBarrier : this->bufferBarriers)
+                bufferBarrier.setDstAccessMask({ });
+            for (auto& imageBarrier : this->imageBarriers)
+                imageBarrier.setDstAccessMask({ });
+            pipelineDistanceFlags = vk::PipelineStageFlagBits::eBottomOfPipe;
+        }
+
+        if (this->bufferBarriers.empty() && this->imageBarriers.empty())
+            return;
+
+        commandBuffer.GetNativeHandle().pipelineBarrier(
+            pipelineSourceFlags,
+            pipelineDistanceFlags,
+            { }, // dependency flags
+            { }, // memory barriers
+            this->bufferBarriers,
+            this->imageBarriers
+        );
+    }
+
+    template<typename Region>
+    static void SortRegionsBySource(std::vector<std::pair<const Buffer*, Region>>& regions)
+    {
+        // regions of one destination usually come from the same stage buffer, so there is only one run
+        std::stable_sort(regions.begin(), regions.end(), [](const auto& region1, const auto& region2)
+        {
+            return std::less<const Buffer*>{ }(region1.first, region2.first);
+        });
+    }
+
+    void UploadBatch::RecordCopies(CommandBuffer& commandBuffer)
+    {
+        for (auto& upload : this->bufferUploads)
+        {
+            SortRegionsBySource(upload.Regions);
+            for (size_t first = 0; first < upload.Regions.size();)
+            {
+                const Buffer* source = upload.Regions[first].first;
+                this->bufferRegions.clear();
+                size_t last = first;
+                for (; last < upload.Regions.size() && upload.Regions[last].first == source; last++)
+                    this->bufferRegions.push_back(upload.Regions[last].second);
+
+                commandBuffer.GetNativeHandle().copyBuffer(source->GetNativeHandle(), upload.Distance->GetNativeHandle(), this->bufferRegions);
+                first = last;
+            }
+        }
+
+        for (auto& upload : this->imageUploads)
+        {
+            SortRegionsBySource(upload.Regions);
+            for (size_t first = 0; first < upload.Regions.size();)
+            {
+                const Buffer* source = upload.Regions[first].first;
+                this->imageRegions.clear();
+                size_t last = first;
+                for (; last < upload.Regions.size() && upload.Regions[last].first == source; last++)
+                    this->imageRegions.push_back(upload.Regions[last].second);
+
+                commandBuffer.GetNativeHandle().copyBufferToImage(
+                    source->GetNativeHandle(),
+                    upload.Distance->GetNativeHandle(),
+                    vk::ImageLayout::eTransferDstOptimal,
+                    this->imageRegions
+                );
+                first = last;
+            }
+        }
+    }
+
+    void UploadBatch::Record(CommandBuffer& commandBuffer)
+    {
+        if (this->IsEmpty()) return;
+
+        this->RecordBarriers(commandBuffer, true, nullptr);
+        this->RecordCopies(commandBuffer);
+        this->RecordBarriers(commandBuffer, false, nullptr);
+
+        this->bufferUploads.clear();
+        this->imageUploads.clear();
+    }
+
+    void UploadBatch::Record(CommandBuffer& commandBuffer, OwnershipTransfer& ownershipTransfer)
+    {
+        if (ownershipTransfer.SourceQueueFamily == ownershipTransfer.DistanceQueueFamily)
+        {
+            this->Record(commandBuffer);
+            return;
+        }
+        if (this->IsEmpty()) return;
+
+        this->RecordBarriers(commandBuffer, true, std::addressof(ownershipTransfer));
+        this->RecordCopies(commandBuffer);
+        this->RecordBarriers(commandBuffer, false, std::addressof(ownershipTransfer));
+
+        this->bufferUploads.clear();
+        this->imageUploads.clear();
+    }
+
+    void UploadBatch::RecordAcquire(CommandBuffer& commandBuffer, const OwnershipTransfer& ownershipTransfer)
+    {
+        if (ownershipTransfer.BufferBarriers.empty() && ownershipTransfer.ImageBarriers.empty())
+            return;
+
+        commandBuffer.GetNativeHandle().pipelineBarrier(
+            vk::PipelineStageFlagBits::eTopOfPipe,
+            ownershipTransfer.DistanceStages,
+            { }, // dependency flags
+            { }, // memory barriers
+            ownershipTransfer.BufferBarriers,
+            ownershipTransfer.ImageBarriers
+        );
+    }
+}
\ No newline at end of file
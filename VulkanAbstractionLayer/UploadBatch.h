@@ -0,0 +1,94 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "CommandBuffer.h"
+
+#include <vector>
+#include <utility>
+
+namespace VulkanAbstractionLayer
+{
+    // collects staged copies and records them grouped by destination: one copy command per destination and
+    // source buffer, with a single pipeline barrier before all copies and a single one after them
+    class UploadBatch
+    {
+    public:
+        // barriers acquiring destinations on distance queue family after they were released by source one
+        struct OwnershipTransfer
+        {
+            uint32_t SourceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+            uint32_t DistanceQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+            vk::PipelineStageFlags DistanceStages;
+            std::vector<vk::BufferMemoryBarrier> BufferBarriers;
+            std::vector<vk::ImageMemoryBarrier> ImageBarriers;
+        };
+
+    private:
+        struct BufferUpload
+        {
+            const Buffer* Distance;
+            BufferUsage::Bits FinalUsage;
+            std::vector<std::pair<const Buffer*, vk::BufferCopy>> Regions;
+        };
+
+        struct ImageUpload
+        {
+            const Image* Distance;
+            ImageUsage::Bits InitialUsage;
+            ImageUsage::Bits FinalUsage;
+            std::vector<std::pair<const Buffer*, vk::BufferImageCopy>> Regions;
+        };
+
+        std::vector<BufferUpload> bufferUploads;
+        std::vector<ImageUpload> imageUploads;
+        // kept between records to not reallocate
+        std::vector<vk::BufferCopy> bufferRegions;
+        std::vector<vk::BufferImageCopy> imageRegions;
+        std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+        std::vector<vk::ImageMemoryBarrier> imageBarriers;
+
+        BufferUpload& GetBufferUpload(const Buffer& distance, BufferUsage::Bits finalUsage);
+        ImageUpload& GetImageUpload(const Image& distance, ImageUsage::Bits initialUsage, ImageUsage::Bits finalUsage);
+        void RecordBarriers(CommandBuffer& commandBuffer, bool beforeCopies, OwnershipTransfer* ownershipTransfer);
+        void RecordCopies(CommandBuffer& commandBuffer);
+    public:
+        // final usage is the one buffer is read with after upload, unknown usage emits no barriers for the buffer
+        void CopyBuffer(const BufferInfo& source, const BufferInfo& distance, size_t byteSize, BufferUsage::Bits finalUsage = BufferUsage::UNKNOWN);
+        // image is left in transfer destination usage if final usage is not provided, e.g. to generate mip levels after
+        void CopyBufferToImage(const BufferInfo& source, const ImageInfo& distance, ImageUsage::Bits finalUsage = ImageUsage::TRANSFER_DISTINATION);
+        void Record(CommandBuffer& commandBuffer);
+        // records copies on queue of source family and releases destinations to distance family instead of moving them
+        // to final usage. Destination images must not be in use before upload, as only transfer stages can be waited
+        void Record(CommandBuffer& commandBuffer, OwnershipTransfer& ownershipTransfer);
+        // must be recorded on distance queue after copies are finished, e.g. by waiting semaphore signaled by source queue
+        static void RecordAcquire(CommandBuffer& commandBuffer, const OwnershipTransfer& ownershipTransfer);
+        bool IsEmpty() const { return this->bufferUploads.empty() && this->imageUploads.empty(); }
+    };
+}
\ No newline at end of file
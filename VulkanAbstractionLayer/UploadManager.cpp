@@ -0,0 +1,238 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "UploadManager.h"
+#include "VulkanContext.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace VulkanAbstractionLayer
+{
+    void UploadManager::Init(vk::Queue queue, uint32_t queueFamilyIndex, uint32_t graphicsQueueFamilyIndex, bool isTimelineSemaphoreSupported)
+    {
+        auto& vulkan = GetCurrentVulkanContext();
+        this->queue = queue;
+        this->queueFamilyIndex = queueFamilyIndex;
+        this->graphicsQueueFamilyIndex = graphicsQueueFamilyIndex;
+
+        const auto& limits = vulkan.GetPhysicalDeviceProperties().limits;
+        // same requirements as for context stage buffer, see StageBuffer constructor
+        constexpr vk::DeviceSize MinCopyOffsetAlignment = 16;
+        this->stagingAlignment = (uint32_t)std::max({ MinCopyOffsetAlignment, limits.optimalBufferCopyOffsetAlignment, limits.nonCoherentAtomSize });
+
+        vk::CommandPoolCreateInfo commandPoolCreateInfo;
+        commandPoolCreateInfo
+            .setQueueFamilyIndex(queueFamilyIndex)
+            .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient);
+        this->commandPool = vulkan.GetDevice().createCommandPool(commandPoolCreateInfo);
+
+        if (isTimelineSemaphoreSupported)
+        {
+            vk::SemaphoreTypeCreateInfo semaphoreTypeCreateInfo;
+            semaphoreTypeCreateInfo
+                .setSemaphoreType(vk::SemaphoreType::eTimeline)
+                .setInitialValue(0);
+
+            vk::SemaphoreCreateInfo semaphoreCreateInfo;
+            semaphoreCreateInfo.setPNext(&semaphoreTypeCreateInfo);
+            this->timelineSemaphore = vulkan.GetDevice().createSemaphore(semaphoreCreateInfo);
+        }
+        else
+        {
+            this->submitFence = vulkan.GetDevice().createFence(vk::FenceCreateInfo{ });
+        }
+    }
+
+    void UploadManager::Destroy()
+    {
+        auto& device = GetCurrentVulkanContext().GetDevice();
+
+        // command buffers are freed with pool
+        if ((bool)this->commandPool) device.destroyCommandPool(this->commandPool);
+        if ((bool)this->timelineSemaphore) device.destroySemaphore(this->timelineSemaphore);
+        if ((bool)this->submitFence) device.destroyFence(this->submitFence);
+        this->commandPool = vk::CommandPool{ };
+        this->timelineSemaphore = vk::Semaphore{ };
+        this->submitFence = vk::Fence{ };
+        this->queue = vk::Queue{ };
+        this->batch = UploadBatch{ };
+        this->stagingBuffers.clear();
+        this->pendingUploads.clear();
+        this->freeCommandBuffers.clear();
+        this->stagingOffset = 0;
+        this->submittedHandle = 0;
+        this->completedHandle = 0;
+    }
+
+    BufferInfo UploadManager::Stage(const uint8_t* data, size_t byteSize)
+    {
+        // staging alignment is always power of two
+        size_t offset = (this->stagingOffset + this->stagingAlignment - 1) & ~size_t(this->stagingAlignment - 1);
+        if (this->stagingBuffers.empty() || offset + byteSize > this->stagingBuffers.back()->GetByteSize())
+        {
+            auto& stagingBuffer = this->stagingBuffers.emplace_back(
+                std::make_unique<Buffer>(std::max(byteSize, MinStagingChunkSize), BufferUsage::TRANSFER_SOURCE, MemoryUsage::CPU_TO_GPU)
+            );
+            (void)stagingBuffer->MapMemory();
+            offset = 0;
+        }
+
+        auto& stagingBuffer = *this->stagingBuffers.back();
+        if (data != nullptr)
+        {
+            stagingBuffer.CopyData(data, byteSize, offset);
+        }
+
+        this->stagingOffset = offset + byteSize;
+        return BufferInfo{ stagingBuffer, (uint32_t)offset };
+    }
+
+    UploadHandle UploadManager::Submit()
+    {
+        if (this->batch.IsEmpty()) return this->submittedHandle;
+        this->ReleaseCompletedUploads();
+
+        auto& vulkan = GetCurrentVulkanContext();
+        PendingUpload upload;
+        upload.Handle = ++this->submittedHandle;
+
+        if (!this->freeCommandBuffers.empty())
+        {
+            upload.Commands = this->freeCommandBuffers.back();
+            this->freeCommandBuffers.pop_back();
+        }
+        else
+        {
+            vk::CommandBufferAllocateInfo commandBufferAllocateInfo;
+            commandBufferAllocateInfo
+                .setCommandPool(this->commandPool)
+                .setCommandBufferCount(1)
+                .setLevel(vk::CommandBufferLevel::ePrimary);
+            upload.Commands = vulkan.GetDevice().allocateCommandBuffers(commandBufferAllocateInfo).front();
+        }
+
+        CommandBuffer commandBuffer{ upload.Commands };
+        commandBuffer.Begin();
+        upload.Acquire.SourceQueueFamily = this->queueFamilyIndex;
+        upload.Acquire.DistanceQueueFamily = this->graphicsQueueFamilyIndex;
+        this->batch.Record(commandBuffer, upload.Acquire);
+        commandBuffer.End();
+
+        for (auto& stagingBuffer : this->stagingBuffers)
+            stagingBuffer->FlushMemory();
+        upload.StagingBuffers = std::move(this->stagingBuffers);
+        this->stagingBuffers.clear();
+        this->stagingOffset = 0;
+
+        vk::SubmitInfo submitInfo;
+        submitInfo.setCommandBuffers(upload.Commands);
+
+        if ((bool)this->timelineSemaphore)
+        {
+            vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo;
+            timelineSubmitInfo.setSignalSemaphoreValues(upload.Handle);
+            submitInfo
+                .setSignalSemaphores(this->timelineSemaphore)
+                .setPNext(&timelineSubmitInfo);
+            this->queue.submit(submitInfo);
+        }
+        else
+        {
+            this->queue.submit(submitInfo, this->submitFence);
+            auto waitResult = vulkan.GetDevice().waitForFences(this->submitFence, false, UINT64_MAX);
+            assert(waitResult == vk::Result::eSuccess);
+            vulkan.GetDevice().resetFences(this->submitFence);
+            this->completedHandle = upload.Handle;
+        }
+
+        this->pendingUploads.push_back(std::move(upload));
+        return this->submittedHandle;
+    }
+
+    bool UploadManager::IsComplete(UploadHandle handle)
+    {
+        if (handle <= this->completedHandle) return true;
+        if (!(bool)this->timelineSemaphore) return false;
+
+        this->completedHandle = GetCurrentVulkanContext().GetDevice().getSemaphoreCounterValue(this->timelineSemaphore);
+        return handle <= this->completedHandle;
+    }
+
+    void UploadManager::Wait(UploadHandle handle)
+    {
+        if (this->IsComplete(handle)) return;
+        assert((bool)this->timelineSemaphore);
+
+        vk::SemaphoreWaitInfo semaphoreWaitInfo;
+        semaphoreWaitInfo
+            .setSemaphores(this->timelineSemaphore)
+            .setValues(handle);
+        auto waitResult = GetCurrentVulkanContext().GetDevice().waitSemaphores(semaphoreWaitInfo, UINT64_MAX);
+        assert(waitResult == vk::Result::eSuccess);
+        this->completedHandle = handle;
+    }
+
+    void UploadManager::Acquire(CommandBuffer& commandBuffer, UploadHandle handle)
+    {
+        for (auto& upload : this->pendingUploads)
+        {
+            if (upload.Handle > handle) break;
+            if (upload.IsAcquired) continue;
+
+            UploadBatch::RecordAcquire(commandBuffer, upload.Acquire);
+            upload.IsAcquired = true;
+        }
+
+        // uploads to graphics queue are ordered by their own barriers, other queues are waited by the next submission
+        if (this->HasOwnershipTransfer() && !this->IsComplete(handle))
+            GetCurrentVulkanContext().WaitSemaphoreOnNextSubmit(this->timelineSemaphore, vk::PipelineStageFlagBits::eAllCommands, handle);
+
+        this->ReleaseCompletedUploads();
+    }
+
+    void UploadManager::ReleaseCompletedUploads()
+    {
+        (void)this->IsComplete(this->submittedHandle);
+
+        // staging memory and command buffer are reused as soon as upload is finished, acquire barriers are kept until recorded
+        for (auto& upload : this->pendingUploads)
+        {
+            if (upload.Handle > this->completedHandle) break;
+            if ((bool)upload.Commands) this->freeCommandBuffers.push_back(upload.Commands);
+            upload.Commands = vk::CommandBuffer{ };
+            upload.StagingBuffers.clear();
+        }
+
+        auto acquiredUploads = std::remove_if(this->pendingUploads.begin(), this->pendingUploads.end(), [this](const PendingUpload& upload)
+        {
+            return upload.IsAcquired && upload.Handle <= this->completedHandle;
+        });
+        this->pendingUploads.erase(acquiredUploads, this->pendingUploads.end());
+    }
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "UploadBatch.h"
+
+#include <vector>
+#include <memory>
+
+namespace VulkanAbstractionLayer
+{
+    // value of upload manager timeline semaphore, signaled when upload is finished
+    using UploadHandle = uint64_t;
+
+    // submits staged copies to transfer queue without waiting for them. Each submission signals the next value of timeline
+    // semaphore, destinations are acquired by graphics queue when frame starts, see VulkanContext::StartFrame
+    class UploadManager
+    {
+        struct PendingUpload
+        {
+            UploadHandle Handle = 0;
+            vk::CommandBuffer Commands;
+            std::vector<std::unique_ptr<Buffer>> StagingBuffers;
+            UploadBatch::OwnershipTransfer Acquire;
+            bool IsAcquired = false;
+        };
+
+        vk::Queue queue;
+        uint32_t queueFamilyIndex = 0;
+        uint32_t graphicsQueueFamilyIndex = 0;
+        vk::CommandPool commandPool;
+        vk::Semaphore timelineSemaphore;
+        vk::Fence submitFence; // every submission is waited on CPU if timeline semaphores are not supported
+        UploadHandle submittedHandle = 0;
+        UploadHandle completedHandle = 0;
+        UploadBatch batch;
+        // staging chunks of batch which is not submitted yet, the last one is suballocated
+        std::vector<std::unique_ptr<Buffer>> stagingBuffers;
+        size_t stagingOffset = 0;
+        uint32_t stagingAlignment = 1;
+        std::vector<PendingUpload> pendingUploads; // in submission order
+        std::vector<vk::CommandBuffer> freeCommandBuffers;
+
+        void ReleaseCompletedUploads();
+    public:
+        constexpr static size_t MinStagingChunkSize = 4 * 1024 * 1024;
+
+        void Init(vk::Queue queue, uint32_t queueFamilyIndex, uint32_t graphicsQueueFamilyIndex, bool isTimelineSemaphoreSupported);
+        void Destroy();
+
+        // staging memory is released when upload which reads it is finished
+        BufferInfo Stage(const uint8_t* data, size_t byteSize);
+        // copies recorded here are submitted by the next Submit call
+        UploadBatch& GetBatch() { return this->batch; }
+        UploadHandle Submit();
+        bool IsComplete(UploadHandle handle);
+        void Wait(UploadHandle handle);
+        // records acquire barriers of all uploads up to handle, next graphics submission waits for them on GPU
+        void Acquire(CommandBuffer& commandBuffer, UploadHandle handle);
+        UploadHandle GetSubmittedHandle() const { return this->submittedHandle; }
+        bool HasOwnershipTransfer() const { return this->queueFamilyIndex != this->graphicsQueueFamilyIndex; }
+
+        template<typename T>
+        BufferInfo Stage(ArrayView<const T> view)
+        {
+            return this->Stage((const uint8_t*)view.data(), view.size() * sizeof(T));
+        }
+
+        template<typename T>
+        BufferInfo Stage(ArrayView<T> view)
+        {
+            return this->Stage((const uint8_t*)view.data(), view.size() * sizeof(T));
+        }
+    };
+}
\ No newline at end of file
@@ -29,9 +29,21 @@
 #include "VirtualFrame.h"
 #include "VulkanContext.h"
 
+#include <algorithm>
+
 namespace VulkanAbstractionLayer
 {
-    void VirtualFrameProvider::Init(size_t frameCount, size_t stageBufferSize)
+    static void SetTimelineWaitValues(vk::SubmitInfo& submitInfo, vk::TimelineSemaphoreSubmitInfo& timelineSubmitInfo, const std::vector<uint64_t>& waitValues)
+    {
+        // binary semaphores ignore their values, so timeline info is chained only if some timeline semaphore is waited
+        bool hasTimelineSemaphores = std::any_of(waitValues.begin(), waitValues.end(), [](uint64_t value) { return value != 0; });
+        if (!hasTimelineSemaphores) return;
+
+        timelineSubmitInfo.setWaitSemaphoreValues(waitValues);
+        submitInfo.setPNext(&timelineSubmitInfo);
+    }
+
+    void VirtualFrameProvider::Init(size_t frameCount, size_t stageBufferSize, size_t uniformRingSize)
     {
         auto& vulkanContext = GetCurrentVulkanContext();
         this->virtualFrames.reserve(frameCount);
@@ -43,6 +55,7 @@ namespace VulkanAbstractionLayer
             .setLevel(vk::CommandBufferLevel::ePrimary);
         
         auto commandBuffers = vulkanContext.GetDevice().allocateCommandBuffers(commandBufferAllocateInfo);
+        this->stageBuffer = StageBuffer(stageBufferSize, frameCount);
 
         for (size_t i = 0; i < frameCount; i++)
         {
@@ -50,8 +63,9 @@ namespace VulkanAbstractionLayer
 
             this->virtualFrames.push_back(VirtualFrame{
                 CommandBuffer{ commandBuffers[i] },
-                StageBuffer(stageBufferSize),
+                UniformRing(uniformRingSize),
                 fence,
+                { commandBuffers[i] },
             });
         }
     }
@@ -64,6 +78,7 @@ namespace VulkanAbstractionLayer
             if((bool)virtualFrame.CommandQueueFence) vulkanContext.GetDevice().destroyFence(virtualFrame.CommandQueueFence);
         }
         this->virtualFrames.clear();
+        this->stageBuffer = StageBuffer{ };
     }
 
     void VirtualFrameProvider::StartFrame()
@@ -79,7 +94,10 @@ namespace VulkanAbstractionLayer
         vk::Result waitFenceResult = vulkanContext.GetDevice().waitForFences(frame.CommandQueueFence, false, UINT64_MAX);
         assert(waitFenceResult == vk::Result::eSuccess);
         vulkanContext.GetDevice().resetFences(frame.CommandQueueFence);
+        this->stageBuffer.StartFrame(this->currentFrame);
 
+        frame.CommandBufferIndex = 0;
+        frame.Commands = CommandBuffer{ frame.CommandBuffers.front() };
         frame.Commands.Begin();
 
         this->isFrameRunning = true;
@@ -119,19 +137,27 @@ namespace VulkanAbstractionLayer
 
         frame.Commands.End();
 
-        frame.StagingBuffer.Flush();
-        frame.StagingBuffer.Reset();
+        this->stageBuffer.Flush();
+        this->stageBuffer.EndFrame(this->currentFrame);
+        frame.UniformBuffer.Flush();
+        frame.UniformBuffer.Reset();
 
-        std::array waitDstStageMask = { (vk::PipelineStageFlags)vk::PipelineStageFlagBits::eTransfer };
+        this->AddWaitSemaphore(vulkanContext.GetImageAvailableSemaphore(), vk::PipelineStageFlagBits::eTransfer);
 
         vk::SubmitInfo submitInfo;
         submitInfo
-            .setWaitSemaphores(vulkanContext.GetImageAvailableSemaphore())
-            .setWaitDstStageMask(waitDstStageMask)
+            .setWaitSemaphores(frame.WaitSemaphores)
+            .setWaitDstStageMask(frame.WaitStages)
             .setSignalSemaphores(vulkanContext.GetRenderingFinishedSemaphore())
             .setCommandBuffers(frame.Commands.GetNativeHandle());
 
+        vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo;
+        SetTimelineWaitValues(submitInfo, timelineSubmitInfo, frame.WaitValues);
+
         GetCurrentVulkanContext().GetGraphicsQueue().submit(std::array{ submitInfo }, frame.CommandQueueFence);
+        frame.WaitSemaphores.clear();
+        frame.WaitStages.clear();
+        frame.WaitValues.clear();
 
         vk::PresentInfoKHR presentInfo;
         presentInfo
@@ -146,6 +172,59 @@ namespace VulkanAbstractionLayer
         this->isFrameRunning = false;
     }
 
+    void VirtualFrameProvider::SubmitCurrentCommands(ArrayView<const vk::Semaphore> signalSemaphores)
+    {
+        auto& frame = this->GetCurrentFrame();
+        auto& vulkanContext = GetCurrentVulkanContext();
+
+        frame.Commands.End();
+        this->stageBuffer.Flush();
+        frame.UniformBuffer.Flush();
+
+        vk::SubmitInfo submitInfo;
+        submitInfo
+            .setWaitSemaphores(frame.WaitSemaphores)
+            .setWaitDstStageMask(frame.WaitStages)
+            .setSignalSemaphoreCount((uint32_t)signalSemaphores.size())
+            .setPSignalSemaphores(signalSemaphores.data())
+            .setCommandBuffers(frame.Commands.GetNativeHandle());
+
+        vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo;
+        SetTimelineWaitValues(submitInfo, timelineSubmitInfo, frame.WaitValues);
+
+        // frame fence is signaled only by the last submission in EndFrame
+        vulkanContext.GetGraphicsQueue().submit(std::array{ submitInfo });
+        frame.WaitSemaphores.clear();
+        frame.WaitStages.clear();
+        frame.WaitValues.clear();
+
+        frame.CommandBufferIndex++;
+        if (frame.CommandBufferIndex == frame.CommandBuffers.size())
+        {
+            vk::CommandBufferAllocateInfo commandBufferAllocateInfo;
+            commandBufferAllocateInfo
+                .setCommandPool(vulkanContext.GetCommandPool())
+                .setCommandBufferCount(1)
+                .setLevel(vk::CommandBufferLevel::ePrimary);
+            frame.CommandBuffers.push_back(vulkanContext.GetDevice().allocateCommandBuffers(commandBufferAllocateInfo).front());
+        }
+        frame.Commands = CommandBuffer{ frame.CommandBuffers[frame.CommandBufferIndex] };
+        frame.Commands.Begin();
+    }
+
+    void VirtualFrameProvider::AddWaitSemaphore(const vk::Semaphore& semaphore, vk::PipelineStageFlags waitStage, uint64_t waitValue)
+    {
+        auto& frame = this->GetCurrentFrame();
+        frame.WaitSemaphores.push_back(semaphore);
+        frame.WaitStages.push_back(waitStage);
+        frame.WaitValues.push_back(waitValue);
+    }
+
+    StageBuffer& VirtualFrameProvider::GetStageBuffer()
+    {
+        return this->stageBuffer;
+    }
+
     VirtualFrame& VirtualFrameProvider::GetCurrentFrame()
     {
         return this->virtualFrames[this->currentFrame];
@@ -176,6 +255,11 @@ namespace VulkanAbstractionLayer
         return this->virtualFrames.size();
     }
 
+    size_t VirtualFrameProvider::GetCurrentFrameIndex() const
+    {
+        return this->currentFrame;
+    }
+
     uint32_t VirtualFrameProvider::GetPresentImageIndex() const
     {
         return this->presentImageIndex;
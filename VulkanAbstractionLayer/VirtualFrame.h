@@ -29,6 +29,7 @@
 #pragma once
 
 #include "StageBuffer.h"
+#include "UniformRing.h"
 #include "CommandBuffer.h"
 #include <vulkan/vulkan.hpp>
 
@@ -39,21 +40,31 @@ namespace VulkanAbstractionLayer
     struct VirtualFrame
     {
         CommandBuffer Commands{ vk::CommandBuffer{ } };
-        StageBuffer StagingBuffer;
+        UniformRing UniformBuffer;
         vk::Fence CommandQueueFence;
+        // frame can be submitted in several parts, each part is recorded into its own command buffer
+        std::vector<vk::CommandBuffer> CommandBuffers;
+        size_t CommandBufferIndex = 0;
+        std::vector<vk::Semaphore> WaitSemaphores;
+        std::vector<vk::PipelineStageFlags> WaitStages;
+        std::vector<uint64_t> WaitValues; // non-zero only for timeline semaphores
     };
 
     class VirtualFrameProvider
     {
         std::vector<VirtualFrame> virtualFrames;
+        StageBuffer stageBuffer; // shared by all frames
         uint32_t presentImageIndex = 0;
         bool isFrameRunning = false;
         size_t currentFrame = 0;
     public:
-        void Init(size_t frameCount, size_t stageBufferSize);
+        void Init(size_t frameCount, size_t stageBufferSize, size_t uniformRingSize);
         void Destroy();
 
         void StartFrame();
+        void SubmitCurrentCommands(ArrayView<const vk::Semaphore> signalSemaphores);
+        void AddWaitSemaphore(const vk::Semaphore& semaphore, vk::PipelineStageFlags waitStage, uint64_t waitValue = 0);
+        StageBuffer& GetStageBuffer();
         VirtualFrame& GetCurrentFrame();
         VirtualFrame& GetNextFrame();
         const VirtualFrame& GetCurrentFrame() const;
@@ -61,6 +72,7 @@ namespace VulkanAbstractionLayer
         uint32_t GetPresentImageIndex() const;
         bool IsFrameRunning() const;
         size_t GetFrameCount() const;
+        size_t GetCurrentFrameIndex() const;
         void EndFrame();
     };
 }
\ No newline at end of file
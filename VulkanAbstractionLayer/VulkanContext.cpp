@@ -35,6 +35,7 @@
 #include <cstring>
 #include <optional>
 #include <iostream>
+#include <fstream>
 
 namespace VulkanAbstractionLayer
 {
@@ -54,6 +55,50 @@ namespace VulkanAbstractionLayer
         return VK_FALSE;
     }
 
+    // written before driver data, as drivers may silently accept cache from other driver version
+    struct PipelineCacheFileHeader
+    {
+        uint32_t Magic;
+        uint32_t VendorID;
+        uint32_t DeviceID;
+        uint32_t DriverVersion;
+        uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t DataSize;
+    };
+
+    constexpr uint32_t PipelineCacheFileMagic = 0x4C415643; // "CVAL"
+
+    static PipelineCacheFileHeader CreatePipelineCacheFileHeader(const vk::PhysicalDeviceProperties& properties, size_t dataSize)
+    {
+        PipelineCacheFileHeader header{ };
+        header.Magic = PipelineCacheFileMagic;
+        header.VendorID = properties.vendorID;
+        header.DeviceID = properties.deviceID;
+        header.DriverVersion = properties.driverVersion;
+        std::memcpy(header.PipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+        header.DataSize = (uint64_t)dataSize;
+        return header;
+    }
+
+    static std::vector<uint8_t> LoadPipelineCacheData(const std::string& filepath, const vk::PhysicalDeviceProperties& properties)
+    {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file.is_open()) return { };
+
+        PipelineCacheFileHeader header{ };
+        file.read((char*)&header, sizeof(header));
+        if (!file.good()) return { };
+
+        auto expectedHeader = CreatePipelineCacheFileHeader(properties, header.DataSize);
+        if (std::memcmp(&header, &expectedHeader, sizeof(header)) != 0)
+            return { };
+
+        std::vector<uint8_t> data(header.DataSize);
+        file.read((char*)data.data(), data.size());
+        if ((size_t)file.gcount() != data.size()) return { };
+        return data;
+    }
+
     bool CheckVulkanPresentationSupport(const vk::Instance& instance, const vk::PhysicalDevice& physicalDevice, uint32_t familyQueueIndex);
 
     constexpr vk::PhysicalDeviceType DeviceTypeMapping[] = {
@@ -129,6 +174,45 @@ namespace VulkanAbstractionLayer
         return { };
     }
 
+    std::optional<std::pair<uint32_t, uint32_t>> DetermineAsyncComputeQueue(const vk::PhysicalDevice device, uint32_t graphicsQueueFamilyIndex)
+    {
+        auto queueFamilyProperties = device.getQueueFamilyProperties();
+        // dedicated compute family is executed independently from graphics work by most hardware
+        for (uint32_t index = 0; index < (uint32_t)queueFamilyProperties.size(); index++)
+        {
+            const auto& property = queueFamilyProperties[index];
+            if ((property.queueCount > 0) &&
+                (property.queueFlags & vk::QueueFlagBits::eCompute) &&
+                !(property.queueFlags & vk::QueueFlagBits::eGraphics))
+            {
+                return std::pair{ index, 0u };
+            }
+        }
+        // otherwise use second queue of graphics family if it exists
+        if (queueFamilyProperties[graphicsQueueFamilyIndex].queueCount > 1)
+            return std::pair{ graphicsQueueFamilyIndex, 1u };
+
+        return { };
+    }
+
+    std::optional<uint32_t> DetermineTransferQueueFamilyIndex(const vk::PhysicalDevice device)
+    {
+        auto queueFamilyProperties = device.getQueueFamilyProperties();
+        // transfer-only family is usually backed by DMA engine, copies there do not occupy graphics queue
+        for (uint32_t index = 0; index < (uint32_t)queueFamilyProperties.size(); index++)
+        {
+            const auto& property = queueFamilyProperties[index];
+            if ((property.queueCount > 0) &&
+                (property.queueFlags & vk::QueueFlagBits::eTransfer) &&
+                !(property.queueFlags & vk::QueueFlagBits::eGraphics) &&
+                !(property.queueFlags & vk::QueueFlagBits::eCompute))
+            {
+                return index;
+            }
+        }
+        return { };
+    }
+
     VulkanContext::VulkanContext(const VulkanContextCreateOptions& options)
     {
         vk::ApplicationInfo applicationInfo;
@@ -162,9 +246,18 @@ namespace VulkanAbstractionLayer
         this->device.waitIdle();
 
         this->virtualFrames.Destroy();
+        // pipeline layouts reference set layouts of descriptor cache and bindless heap
+        this->pipelineStateCache.Destroy();
         this->descriptorCache.Destroy();
+        this->bindlessHeap.Destroy();
+        this->uploadManager.Destroy();
        
         if ((bool)this->commandPool) this->device.destroyCommandPool(this->commandPool);
+        if ((bool)this->pipelineCache)
+        {
+            this->SavePipelineCache();
+            this->device.destroyPipelineCache(this->pipelineCache);
+        }
 
         this->swapchainImages.clear();
 
@@ -180,8 +273,13 @@ namespace VulkanAbstractionLayer
         if ((bool)this->debugUtilsMessenger) this->instance.destroyDebugUtilsMessengerEXT(this->debugUtilsMessenger, nullptr, this->dynamicLoader);
         if ((bool)this->surface) this->instance.destroySurfaceKHR(this->surface);
         if ((bool)this->instance) this->instance.destroy();
+        this->pipelineCacheFilepath.clear();
         this->presentImageCount = { };
         this->queueFamilyIndex = { };
+        this->computeQueueFamilyIndex = { };
+        this->asyncComputeEnabled = false;
+        this->transferQueueFamilyIndex = { };
+        this->transferQueueEnabled = false;
         this->apiVersion = { };
     }
 
@@ -267,10 +365,31 @@ namespace VulkanAbstractionLayer
 
         // logical device and device queue
 
-        vk::DeviceQueueCreateInfo deviceQueueCreateInfo;
-        std::array queuePriorities = { 1.0f };
-        deviceQueueCreateInfo.setQueueFamilyIndex(this->queueFamilyIndex);
-        deviceQueueCreateInfo.setQueuePriorities(queuePriorities);
+        std::optional<std::pair<uint32_t, uint32_t>> asyncComputeQueue;
+        if (options.EnableAsyncComputeQueue)
+        {
+            asyncComputeQueue = DetermineAsyncComputeQueue(this->physicalDevice, this->queueFamilyIndex);
+            if (!asyncComputeQueue.has_value())
+                options.InfoCallback("async compute queue is not supported by physical device, compute work is submitted to graphics queue");
+        }
+
+        std::array queuePriorities = { 1.0f, 1.0f };
+        std::vector<vk::DeviceQueueCreateInfo> deviceQueueCreateInfos;
+        deviceQueueCreateInfos.push_back(vk::DeviceQueueCreateInfo{ { }, this->queueFamilyIndex, 1, queuePriorities.data() });
+        if (asyncComputeQueue.has_value() && asyncComputeQueue->first == this->queueFamilyIndex)
+            deviceQueueCreateInfos.front().setQueueCount(2);
+        else if (asyncComputeQueue.has_value())
+            deviceQueueCreateInfos.push_back(vk::DeviceQueueCreateInfo{ { }, asyncComputeQueue->first, 1, queuePriorities.data() });
+
+        std::optional<uint32_t> transferQueueFamily;
+        if (options.EnableTransferQueue)
+        {
+            transferQueueFamily = DetermineTransferQueueFamilyIndex(this->physicalDevice);
+            if (transferQueueFamily.has_value())
+                deviceQueueCreateInfos.push_back(vk::DeviceQueueCreateInfo{ { }, transferQueueFamily.value(), 1, queuePriorities.data() });
+            else
+                options.InfoCallback("dedicated transfer queue is not supported by physical device, uploads are submitted to graphics queue");
+        }
 
         auto deviceExtensions = options.DeviceExtensions;
         deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
@@ -279,6 +398,7 @@ namespace VulkanAbstractionLayer
 
         vk::PhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures;
         descriptorIndexingFeatures.descriptorBindingPartiallyBound                    = true;
+        descriptorIndexingFeatures.runtimeDescriptorArray                             = true;
         descriptorIndexingFeatures.shaderInputAttachmentArrayDynamicIndexing          = true;
         descriptorIndexingFeatures.shaderUniformTexelBufferArrayDynamicIndexing       = true;
         descriptorIndexingFeatures.shaderStorageTexelBufferArrayDynamicIndexing       = true;
@@ -296,18 +416,42 @@ namespace VulkanAbstractionLayer
         descriptorIndexingFeatures.descriptorBindingUniformTexelBufferUpdateAfterBind = true;
         descriptorIndexingFeatures.descriptorBindingStorageTexelBufferUpdateAfterBind = true;
 
+        // timeline semaphores are core and mandatory since vulkan 1.2, uploads are waited on CPU for older versions
+        bool isTimelineSemaphoreSupported = this->apiVersion >= VK_MAKE_VERSION(1, 2, 0);
+        vk::PhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures;
+        timelineSemaphoreFeatures.timelineSemaphore = true;
+        timelineSemaphoreFeatures.pNext = &descriptorIndexingFeatures;
+
         vk::PhysicalDeviceMultiviewFeatures multiviewFeatures;
         multiviewFeatures.multiview = true;
-        multiviewFeatures.pNext = &descriptorIndexingFeatures;
+        multiviewFeatures.pNext = isTimelineSemaphoreSupported ? (void*)&timelineSemaphoreFeatures : (void*)&descriptorIndexingFeatures;
 
         vk::DeviceCreateInfo deviceCreateInfo;
         deviceCreateInfo
-            .setQueueCreateInfos(deviceQueueCreateInfo)
+            .setQueueCreateInfos(deviceQueueCreateInfos)
             .setPEnabledExtensionNames(deviceExtensions)
             .setPNext(&multiviewFeatures);
 
         this->device = this->physicalDevice.createDevice(deviceCreateInfo);
         this->deviceQueue = this->device.getQueue(this->queueFamilyIndex, 0);
+        this->computeQueue = this->deviceQueue;
+        this->computeQueueFamilyIndex = this->queueFamilyIndex;
+        if (asyncComputeQueue.has_value())
+        {
+            this->computeQueue = this->device.getQueue(asyncComputeQueue->first, asyncComputeQueue->second);
+            this->computeQueueFamilyIndex = asyncComputeQueue->first;
+            this->asyncComputeEnabled = true;
+            options.InfoCallback("created async compute queue in queue family " + std::to_string(this->computeQueueFamilyIndex));
+        }
+        this->transferQueue = this->deviceQueue;
+        this->transferQueueFamilyIndex = this->queueFamilyIndex;
+        if (transferQueueFamily.has_value())
+        {
+            this->transferQueue = this->device.getQueue(transferQueueFamily.value(), 0);
+            this->transferQueueFamilyIndex = transferQueueFamily.value();
+            this->transferQueueEnabled = true;
+            options.InfoCallback("created transfer queue in queue family " + std::to_string(this->transferQueueFamilyIndex));
+        }
 
         options.InfoCallback("created logical device and device queues");
 
@@ -356,12 +500,43 @@ namespace VulkanAbstractionLayer
 
         options.InfoCallback("created command buffer pool");
 
+        this->pipelineCacheFilepath = options.PipelineCacheFilepath;
+        std::vector<uint8_t> pipelineCacheData;
+        if (!this->pipelineCacheFilepath.empty())
+            pipelineCacheData = LoadPipelineCacheData(this->pipelineCacheFilepath, this->physicalDeviceProperties);
+
+        vk::PipelineCacheCreateInfo pipelineCacheCreateInfo;
+        pipelineCacheCreateInfo
+            .setInitialDataSize(pipelineCacheData.size())
+            .setPInitialData(pipelineCacheData.data());
+        this->pipelineCache = this->device.createPipelineCache(pipelineCacheCreateInfo);
+
+        if (!pipelineCacheData.empty())
+            options.InfoCallback("loaded pipeline cache from " + this->pipelineCacheFilepath);
+        else
+            options.InfoCallback("created empty pipeline cache");
+
         this->descriptorCache.Init();
-        this->virtualFrames.Init(options.VirtualFrameCount, options.MaxStageBufferSize);
+        this->bindlessHeap.Init(options.VirtualFrameCount, options.BindlessImageCount, options.BindlessSamplerCount, options.BindlessBufferCount);
+        this->virtualFrames.Init(options.VirtualFrameCount, options.MaxStageBufferSize, options.MaxUniformRingSize);
+        this->uploadManager.Init(this->transferQueue, this->transferQueueFamilyIndex, this->queueFamilyIndex, isTimelineSemaphoreSupported);
 
         options.InfoCallback("initialization finished");
     }
 
+    void VulkanContext::SavePipelineCache()
+    {
+        if (this->pipelineCacheFilepath.empty() || !(bool)this->pipelineCache)
+            return;
+
+        auto pipelineCacheData = this->device.getPipelineCacheData(this->pipelineCache);
+        auto header = CreatePipelineCacheFileHeader(this->physicalDeviceProperties, pipelineCacheData.size());
+
+        std::ofstream file(this->pipelineCacheFilepath, std::ios::binary);
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)pipelineCacheData.data(), pipelineCacheData.size());
+    }
+
     void VulkanContext::RecreateSwapchain(uint32_t surfaceWidth, uint32_t surfaceHeight)
     {
         this->device.waitIdle();
@@ -432,6 +607,8 @@ namespace VulkanAbstractionLayer
     void VulkanContext::StartFrame()
     {
         this->virtualFrames.StartFrame();
+        this->bindlessHeap.StartFrame(this->virtualFrames.GetCurrentFrameIndex());
+        this->uploadManager.Acquire(this->GetCurrentCommandBuffer(), this->uploadManager.GetSubmittedHandle());
     }
 
     const Image& VulkanContext::AcquireCurrentSwapchainImage(ImageUsage::Bits usage)
@@ -444,9 +621,24 @@ namespace VulkanAbstractionLayer
         return this->virtualFrames.GetCurrentFrame().Commands;
     }
 
+    void VulkanContext::SubmitCurrentCommandBuffer(ArrayView<const vk::Semaphore> signalSemaphores)
+    {
+        this->virtualFrames.SubmitCurrentCommands(signalSemaphores);
+    }
+
+    void VulkanContext::WaitSemaphoreOnNextSubmit(const vk::Semaphore& semaphore, vk::PipelineStageFlags waitStage, uint64_t waitValue)
+    {
+        this->virtualFrames.AddWaitSemaphore(semaphore, waitStage, waitValue);
+    }
+
     StageBuffer& VulkanContext::GetCurrentStageBuffer()
     {
-        return this->virtualFrames.GetCurrentFrame().StagingBuffer;
+        return this->virtualFrames.GetStageBuffer();
+    }
+
+    UniformRing& VulkanContext::GetCurrentUniformRing()
+    {
+        return this->virtualFrames.GetCurrentFrame().UniformBuffer;
     }
 
     CommandBuffer& VulkanContext::GetImmediateCommandBuffer()
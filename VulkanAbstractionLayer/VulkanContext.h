@@ -30,10 +30,14 @@
 
 #include <vulkan/vulkan.hpp>
 #include <vector>
+#include <string>
 #include <functional>
 
 #include "VirtualFrame.h"
 #include "DescriptorCache.h"
+#include "BindlessHeap.h"
+#include "PipelineStateCache.h"
+#include "UploadManager.h"
 #include "Image.h"
 #include "CommandBuffer.h"
 
@@ -74,7 +78,14 @@ namespace VulkanAbstractionLayer
         std::function<void(const std::string&)> InfoCallback = DefaultVulkanContextCallback;
         std::vector<const char*> DeviceExtensions;
         size_t VirtualFrameCount = 3;
-        size_t MaxStageBufferSize = 64 * 1024 * 1024;
+        size_t MaxStageBufferSize = 64 * 1024 * 1024; // ring shared by virtual frames, larger uploads get dedicated buffers
+        size_t MaxUniformRingSize = 16 * 1024 * 1024;
+        bool EnableAsyncComputeQueue = false;
+        bool EnableTransferQueue = false; // uploads are submitted to graphics queue if disabled or not supported
+        std::string PipelineCacheFilepath; // pipeline cache is kept only in memory if empty
+        uint32_t BindlessImageCount = 4096;
+        uint32_t BindlessSamplerCount = 64;
+        uint32_t BindlessBufferCount = 4096;
     };
 
     class VulkanContext
@@ -89,10 +100,14 @@ namespace VulkanAbstractionLayer
         vk::PhysicalDeviceProperties physicalDeviceProperties;
         vk::Device device;
         vk::Queue deviceQueue;
+        vk::Queue computeQueue;
+        vk::Queue transferQueue;
         vk::Semaphore imageAvailableSemaphore;
         vk::Semaphore renderingFinishedSemaphore;
         vk::Fence immediateFence;
         vk::CommandPool commandPool;
+        vk::PipelineCache pipelineCache;
+        std::string pipelineCacheFilepath;
         CommandBuffer immediateCommandBuffer{ { } };
         vk::SwapchainKHR swapchain;
         vk::DebugUtilsMessengerEXT debugUtilsMessenger;
@@ -102,7 +117,14 @@ namespace VulkanAbstractionLayer
         std::vector<ImageUsage::Bits> swapchainImageUsages;
         VirtualFrameProvider virtualFrames;
         DescriptorCache descriptorCache;
+        BindlessHeap bindlessHeap;
+        PipelineStateCache pipelineStateCache;
+        UploadManager uploadManager;
         uint32_t queueFamilyIndex = { };
+        uint32_t computeQueueFamilyIndex = { };
+        bool asyncComputeEnabled = false;
+        uint32_t transferQueueFamilyIndex = { };
+        bool transferQueueEnabled = false;
         uint32_t apiVersion = { };
         bool renderingEnabled = true;
 
@@ -119,15 +141,26 @@ namespace VulkanAbstractionLayer
         const Format GetSurfaceFormat() const { return FromNative(this->surfaceFormat.format); }
         const vk::Extent2D& GetSurfaceExtent() const { return this->surfaceExtent; }
         const vk::PhysicalDevice& GetPhysicalDevice() const { return this->physicalDevice; }
+        const vk::PhysicalDeviceProperties& GetPhysicalDeviceProperties() const { return this->physicalDeviceProperties; }
         const vk::Device& GetDevice() const { return this->device; }
         const vk::Queue& GetPresentQueue() const { return this->deviceQueue; }
         const vk::Queue& GetGraphicsQueue() const { return this->deviceQueue; }
+        const vk::Queue& GetComputeQueue() const { return this->computeQueue; }
+        const vk::Queue& GetTransferQueue() const { return this->transferQueue; }
         const vk::Semaphore& GetRenderingFinishedSemaphore() const { return this->renderingFinishedSemaphore; }
         const vk::Semaphore& GetImageAvailableSemaphore() const { return this->imageAvailableSemaphore; }
         const vk::SwapchainKHR& GetSwapchain() const { return this->swapchain; }
         const vk::CommandPool& GetCommandPool() const { return this->commandPool; }
+        const vk::PipelineCache& GetPipelineCache() const { return this->pipelineCache; }
         DescriptorCache& GetDescriptorCache() { return this->descriptorCache; }
+        BindlessHeap& GetBindlessHeap() { return this->bindlessHeap; }
+        PipelineStateCache& GetPipelineStateCache() { return this->pipelineStateCache; }
+        UploadManager& GetUploadManager() { return this->uploadManager; }
         uint32_t GetQueueFamilyIndex() const { return this->queueFamilyIndex; }
+        uint32_t GetComputeQueueFamilyIndex() const { return this->computeQueueFamilyIndex; }
+        bool HasAsyncComputeQueue() const { return this->asyncComputeEnabled; }
+        uint32_t GetTransferQueueFamilyIndex() const { return this->transferQueueFamilyIndex; }
+        bool HasTransferQueue() const { return this->transferQueueEnabled; }
         uint32_t GetPresentImageCount() const { return this->presentImageCount; }
         uint32_t GetAPIVersion() const { return this->apiVersion; }
         const VmaAllocator& GetAllocator() const { return this->allocator; }
@@ -136,13 +169,18 @@ namespace VulkanAbstractionLayer
 
         bool IsRenderingEnabled() const { return this->renderingEnabled; }
         void InitializeContext(const WindowSurface& surface, const ContextInitializeOptions& options);
+        void SavePipelineCache();
         void RecreateSwapchain(uint32_t surfaceWidth, uint32_t surfaceHeight);
         void StartFrame();
         bool IsFrameRunning() const;
         const Image& AcquireCurrentSwapchainImage(ImageUsage::Bits usage);
         CommandBuffer& GetCurrentCommandBuffer();
+        void SubmitCurrentCommandBuffer(ArrayView<const vk::Semaphore> signalSemaphores);
+        void WaitSemaphoreOnNextSubmit(const vk::Semaphore& semaphore, vk::PipelineStageFlags waitStage, uint64_t waitValue = 0);
         StageBuffer& GetCurrentStageBuffer();
+        UniformRing& GetCurrentUniformRing();
         size_t GetVirtualFrameCount() const { return this->virtualFrames.GetFrameCount(); }
+        size_t GetCurrentVirtualFrameIndex() const { return this->virtualFrames.GetCurrentFrameIndex(); }
         void SubmitCommandsImmediate(const CommandBuffer& commands);
         CommandBuffer& GetImmediateCommandBuffer();
         void EndFrame();
@@ -37,6 +37,9 @@
 #include "VulkanMemoryAllocator.h"
 #include "VulkanContext.h"
 
+#include <atomic>
+#include <cassert>
+
 namespace VulkanAbstractionLayer
 {
     VmaMemoryUsage MemoryUsageToNative(MemoryUsage usage)
@@ -85,6 +88,27 @@ namespace VulkanAbstractionLayer
         return allocation;
     }
 
+    VmaAllocation AllocateMemory(const vk::MemoryRequirements& memoryRequirements, MemoryUsage usage)
+    {
+        VmaAllocation allocation = { };
+        VmaAllocationCreateInfo allocationInfo = { };
+        allocationInfo.usage = MemoryUsageToNative(usage);
+        VkResult result = vmaAllocateMemory(GetCurrentVulkanContext().GetAllocator(), (const VkMemoryRequirements*)&memoryRequirements, &allocationInfo, &allocation, nullptr);
+        assert(result == VK_SUCCESS);
+        return allocation;
+    }
+
+    void DeallocateMemory(VmaAllocation allocation)
+    {
+        vmaFreeMemory(GetCurrentVulkanContext().GetAllocator(), allocation);
+    }
+
+    void BindImageMemory(const vk::Image& image, VmaAllocation allocation)
+    {
+        VkResult result = vmaBindImageMemory(GetCurrentVulkanContext().GetAllocator(), allocation, image);
+        assert(result == VK_SUCCESS);
+    }
+
     uint8_t* MapMemory(VmaAllocation allocation)
     {
         void* memory = nullptr;
@@ -101,4 +125,10 @@ namespace VulkanAbstractionLayer
     {
         vmaFlushAllocation(GetCurrentVulkanContext().GetAllocator(), allocation, offset, byteSize);
     }
+
+    uint64_t NextResourceGeneration()
+    {
+        static std::atomic<uint64_t> generation{ 0 };
+        return ++generation;
+    }
 }
@@ -42,6 +42,7 @@ namespace vk
     class Buffer;
     struct ImageCreateInfo;
     struct BufferCreateInfo;
+    struct MemoryRequirements;
 }
 
 namespace VulkanAbstractionLayer
@@ -63,7 +64,12 @@ namespace VulkanAbstractionLayer
     void DeallocateBuffer(const vk::Buffer& buffer, VmaAllocation allocation);
     VmaAllocation AllocateImage(const vk::ImageCreateInfo& imageCreateInfo, MemoryUsage usage, vk::Image* image);
     VmaAllocation AllocateBuffer(const vk::BufferCreateInfo& bufferCreateInfo, MemoryUsage usage, vk::Buffer* buffer);
+    VmaAllocation AllocateMemory(const vk::MemoryRequirements& memoryRequirements, MemoryUsage usage);
+    void DeallocateMemory(VmaAllocation allocation);
+    void BindImageMemory(const vk::Image& image, VmaAllocation allocation);
     uint8_t* MapMemory(VmaAllocation allocation);
     void UnmapMemory(VmaAllocation allocation);
     void FlushMemory(VmaAllocation allocation, size_t byteSize, size_t offset);
+    // unique for each created resource, unlike native handles which can be reused after resource is destroyed
+    uint64_t NextResourceGeneration();
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+// Copyright(c) 2021, #Momo
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and /or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "WorkerPool.h"
+
+namespace VulkanAbstractionLayer
+{
+    WorkerPool::WorkerPool(size_t threadCount)
+    {
+        this->workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++)
+            this->workers.emplace_back([this]() { this->WorkerLoop(); });
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->isStopping = true;
+        }
+        this->taskAvailable.notify_all();
+
+        for (auto& worker : this->workers)
+            worker.join();
+    }
+
+    void WorkerPool::Submit(Task task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->tasks.push_back(std::move(task));
+            this->pendingTaskCount++;
+        }
+        this->taskAvailable.notify_one();
+    }
+
+    void WorkerPool::WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->tasksFinished.wait(lock, [this]() { return this->pendingTaskCount == 0; });
+    }
+
+    void WorkerPool::WorkerLoop()
+    {
+        while (true)
+        {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->taskAvailable.wait(lock, [this]() { return this->isStopping || !this->tasks.empty(); });
+                if (this->tasks.empty()) return; // pool is stopping and no work is left
+
+                task = std::move(this->tasks.front());
+                this->tasks.pop_front();
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->pendingTaskCount--;
+            }
+            this->tasksFinished.notify_all();
+        }
+    }
+}
\ No newline at end of file
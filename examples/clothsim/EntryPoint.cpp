@@ -88,7 +88,7 @@ public:
             auto& stageBuffer = GetCurrentVulkanContext().GetCurrentStageBuffer();
             auto uniformAllocation = stageBuffer.Submit(&uniformData);
             state.Commands.CopyBuffer(
-                BufferInfo{ stageBuffer.GetBuffer(), uniformAllocation.Offset },
+                BufferInfo{ stageBuffer.GetBuffer(uniformAllocation), uniformAllocation.Offset },
                 BufferInfo{ uniformBuffer, 0 },
                 uniformAllocation.Size
             );
@@ -98,7 +98,7 @@ public:
             auto& stageBuffer = GetCurrentVulkanContext().GetCurrentStageBuffer();
             auto uniformAllocation = stageBuffer.Submit(MakeView(uniformData));
             state.Commands.CopyBuffer(
-                BufferInfo{ stageBuffer.GetBuffer(), uniformAllocation.Offset },
+                BufferInfo{ stageBuffer.GetBuffer(uniformAllocation), uniformAllocation.Offset },
                 BufferInfo{ uniformBuffer, 0 },
                 uniformAllocation.Size
             );
@@ -390,7 +390,7 @@ void LoadImageData(Image& image, uint32_t width, uint32_t height, Format format,
     auto allocation = stagingBuffer.Submit(data);
     commandBuffer.Begin();
     commandBuffer.CopyBufferToImage(
-        BufferInfo{ stagingBuffer.GetBuffer(), allocation.Offset },
+        BufferInfo{ stagingBuffer.GetBuffer(allocation), allocation.Offset },
         ImageInfo{ image, ImageUsage::UNKNOWN, 0, 0 }
     );
     commandBuffer.TransferLayout(image, ImageUsage::TRANSFER_DISTINATION, layout);
@@ -416,7 +416,7 @@ void LoadBufferData(Buffer& buffer, BufferUsage::Value usage, ArrayView<T> data)
     auto allocation = stagingBuffer.Submit(data);
     commandBuffer.Begin();
     commandBuffer.CopyBuffer(
-        BufferInfo{ stagingBuffer.GetBuffer(), allocation.Offset },
+        BufferInfo{ stagingBuffer.GetBuffer(allocation), allocation.Offset },
         BufferInfo{ buffer, 0 },
         allocation.Size
     );
@@ -454,6 +454,8 @@ int main()
     deviceOptions.PreferredDeviceType = DeviceType::DISCRETE_GPU;
     deviceOptions.ErrorCallback = VulkanErrorCallback;
     deviceOptions.InfoCallback = VulkanInfoCallback;
+    deviceOptions.PipelineCacheFilepath = "pipeline_cache.bin";
+    deviceOptions.EnableAsyncComputeQueue = true;
 
     Vulkan.InitializeContext(window.CreateWindowSurface(Vulkan), deviceOptions);
 
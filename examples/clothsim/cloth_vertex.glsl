@@ -8,13 +8,13 @@ out gl_PerVertex
 layout(location = 0) out vec3 vPosition;
 layout(location = 1) out vec3 vNormal;
 
-layout(set = 0, binding = 0) uniform uCameraBuffer
+layout(set = 2, binding = 0) uniform uCameraBuffer
 {
     mat4 uViewProjection;
     vec3 uCameraPosition;
 };
 
-layout(set = 0, binding = 1) uniform sampler2D uPositionImage;
+layout(set = 2, binding = 1) uniform sampler2D uPositionImage;
 
 layout(push_constant) uniform uColorPushConstants
 {
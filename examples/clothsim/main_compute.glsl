@@ -2,8 +2,8 @@
 
 layout (local_size_x = 16, local_size_y = 16) in;
 
-layout(set = 0, binding = 0, rgba32f) uniform image2D uPositionImage;
-layout(set = 0, binding = 1, rgba32f) uniform image2D uVelocityImage;
+layout(set = 2, binding = 0, rgba32f) uniform image2D uPositionImage;
+layout(set = 2, binding = 1, rgba32f) uniform image2D uVelocityImage;
 
 layout(push_constant) uniform uComputeShaderInfo
 {
@@ -12,7 +12,7 @@ layout(push_constant) uniform uComputeShaderInfo
 };
 
 #define BALL_COUNT 2
-layout(set = 0, binding = 2) uniform uBallBuffer
+layout(set = 2, binding = 2) uniform uBallBuffer
 {
     vec4 uBallPosition_BallRadius[BALL_COUNT];
 };
@@ -10,7 +10,7 @@ layout(push_constant) uniform uColorPushConstants
     vec4 uColor_QuadsPerRow;
 };
 
-layout(set = 0, binding = 0) uniform uCameraBuffer
+layout(set = 2, binding = 0) uniform uCameraBuffer
 {
     mat4 uViewProjection;
     vec3 uCameraPosition;
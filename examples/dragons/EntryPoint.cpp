@@ -89,7 +89,7 @@ void LoadCubemap(Image& image, const std::string& filepath)
         auto textureAllocation = stageBuffer.Submit(face.data(), face.size());
 
         commandBuffer.CopyBufferToImage(
-            BufferInfo{ stageBuffer.GetBuffer(), textureAllocation.Offset },
+            BufferInfo{ stageBuffer.GetBuffer(textureAllocation), textureAllocation.Offset },
             ImageInfo{ image, ImageUsage::UNKNOWN, 0, layer }
         );
     }
@@ -126,7 +126,7 @@ void LoadImage(Image& image, const std::string& filepath)
     auto textureAllocation = stageBuffer.Submit(imageData.ByteData.data(), imageData.ByteData.size());
 
     commandBuffer.CopyBufferToImage(
-        BufferInfo{ stageBuffer.GetBuffer(), textureAllocation.Offset },
+        BufferInfo{ stageBuffer.GetBuffer(textureAllocation), textureAllocation.Offset },
         ImageInfo{ image, ImageUsage::UNKNOWN, 0, 0 }
     );
 
@@ -158,17 +158,17 @@ Mesh CreateMesh(ArrayView<ModelData::Vertex> vertices, ArrayView<ModelData::Inde
     result.VertexBuffer.Init(vertexAllocation.Size, BufferUsage::VERTEX_BUFFER | BufferUsage::TRANSFER_DESTINATION, MemoryUsage::GPU_ONLY);
 
     commandBuffer.CopyBuffer(
-        BufferInfo{ stageBuffer.GetBuffer(), instanceAllocation.Offset }, 
+        BufferInfo{ stageBuffer.GetBuffer(instanceAllocation), instanceAllocation.Offset }, 
         BufferInfo{ result.InstanceBuffer, 0 }, 
         instanceAllocation.Size
     );
     commandBuffer.CopyBuffer(
-        BufferInfo{ stageBuffer.GetBuffer(), indexAllocation.Offset },
+        BufferInfo{ stageBuffer.GetBuffer(indexAllocation), indexAllocation.Offset },
         BufferInfo{ result.IndexBuffer, 0 },
         indexAllocation.Size
     );
     commandBuffer.CopyBuffer(
-        BufferInfo{ stageBuffer.GetBuffer(), vertexAllocation.Offset }, 
+        BufferInfo{ stageBuffer.GetBuffer(vertexAllocation), vertexAllocation.Offset }, 
         BufferInfo{ result.VertexBuffer, 0 }, 
         vertexAllocation.Size
     );
@@ -188,7 +188,7 @@ Mesh CreateMesh(ArrayView<ModelData::Vertex> vertices, ArrayView<ModelData::Inde
         auto textureAllocation = stageBuffer.Submit(texture.ByteData.data(), texture.ByteData.size());
 
         commandBuffer.CopyBufferToImage(
-            BufferInfo{ stageBuffer.GetBuffer(), textureAllocation.Offset }, 
+            BufferInfo{ stageBuffer.GetBuffer(textureAllocation), textureAllocation.Offset }, 
             ImageInfo{ image, ImageUsage::UNKNOWN, 0, 0 }
         );
         commandBuffer.GenerateMipLevels(image, ImageUsage::TRANSFER_DISTINATION, BlitFilter::LINEAR);
@@ -357,7 +357,7 @@ public:
             auto& stageBuffer = GetCurrentVulkanContext().GetCurrentStageBuffer();
             auto uniformAllocation = stageBuffer.Submit(&uniformData);
             state.Commands.CopyBuffer(
-                BufferInfo{ stageBuffer.GetBuffer(), uniformAllocation.Offset }, 
+                BufferInfo{ stageBuffer.GetBuffer(uniformAllocation), uniformAllocation.Offset }, 
                 BufferInfo{ uniformBuffer, 0 }, 
                 uniformAllocation.Size
             );
@@ -368,7 +368,7 @@ public:
             auto& stageBuffer = GetCurrentVulkanContext().GetCurrentStageBuffer();
             auto uniformAllocation = stageBuffer.Submit(MakeView(uniformData));
             state.Commands.CopyBuffer(
-                BufferInfo{ stageBuffer.GetBuffer(), uniformAllocation.Offset },
+                BufferInfo{ stageBuffer.GetBuffer(uniformAllocation), uniformAllocation.Offset },
                 BufferInfo{ uniformBuffer, 0 },
                 uniformAllocation.Size
             );
@@ -648,6 +648,7 @@ int main()
     deviceOptions.PreferredDeviceType = DeviceType::DISCRETE_GPU;
     deviceOptions.ErrorCallback = VulkanErrorCallback;
     deviceOptions.InfoCallback = VulkanInfoCallback;
+    deviceOptions.PipelineCacheFilepath = "pipeline_cache.bin";
 
     Vulkan.InitializeContext(window.CreateWindowSurface(Vulkan), deviceOptions);
 
@@ -23,31 +23,31 @@ struct Fragment
     float Roughness;
 };
 
-layout(set = 0, binding = 0) uniform uCameraBuffer
+layout(set = 2, binding = 0) uniform uCameraBuffer
 {
     mat4 uViewProjection;
     vec3 uCameraPosition;
 };
 
-layout(set = 0, binding = 2) uniform uLightBuffer
+layout(set = 2, binding = 2) uniform uLightBuffer
 {
     mat4 uLightProjection;
     vec4 uLightColor_uAmbientIntensity;
     vec3 uLightDirection;
 };
 
-layout(set = 0, binding = 3) uniform uMaterialBuffer
+layout(set = 2, binding = 3) uniform uMaterialBuffer
 {
     Material uMaterials[256];
 };
 
-layout(set = 0, binding = 4) uniform sampler uImageSampler;
-layout(set = 0, binding = 5) uniform texture2D uTextures[4096];
+layout(set = 2, binding = 4) uniform sampler uImageSampler;
+layout(set = 2, binding = 5) uniform texture2D uTextures[4096];
 
-layout(set = 0, binding = 6) uniform sampler2D uShadowTexture;
-layout(set = 0, binding = 7) uniform sampler2D uBRDFLUT;
-layout(set = 0, binding = 8) uniform samplerCube uSkybox;
-layout(set = 0, binding = 9) uniform samplerCube uSkyboxIrradiance;
+layout(set = 2, binding = 6) uniform sampler2D uShadowTexture;
+layout(set = 2, binding = 7) uniform sampler2D uBRDFLUT;
+layout(set = 2, binding = 8) uniform samplerCube uSkybox;
+layout(set = 2, binding = 9) uniform samplerCube uSkyboxIrradiance;
 
 #define PI 3.1415926535
 #define GAMMA 2.2
@@ -13,12 +13,12 @@ out gl_PerVertex
     vec4 gl_Position;
 };
 
-layout(set = 0, binding = 1) uniform uModelBuffer
+layout(set = 2, binding = 1) uniform uModelBuffer
 {
     mat3 uModel;
 };
 
-layout(set = 0, binding = 2) uniform uLightBuffer
+layout(set = 2, binding = 2) uniform uLightBuffer
 {
     mat4 uLightProjection;
     vec4 uLightColorPadding;
@@ -49,7 +49,7 @@ const vec3 SkyboxVertices[] = vec3[](
     vec3( 1.0, -1.0,  1.0)
 );
 
-layout(set = 0, binding = 0) uniform uCameraBuffer
+layout(set = 2, binding = 0) uniform uCameraBuffer
 {
     mat4 uViewProjection;
     vec3 uCameraPosition;
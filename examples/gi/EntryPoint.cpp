@@ -11,6 +11,7 @@
 #include "VulkanAbstractionLayer/ImageLoader.h"
 #include "VulkanAbstractionLayer/ImGuiRenderPass.h"
 #include "VulkanAbstractionLayer/GraphicShader.h"
+#include "VulkanAbstractionLayer/UploadBatch.h"
 
 using namespace VulkanAbstractionLayer;
 
@@ -152,6 +153,7 @@ struct SharedResources
     Image SkyboxIrradiance;
     Image BRDFLUT;
     std::shared_ptr<Shader> MainShader;
+    std::vector<vk::DescriptorSet> MaterialSets; // indexed as materials in MaterialUniformBuffer
 };
 
 void LoadImage(CommandBuffer& commandBuffer, Image& image, const ImageData& imageData, ImageOptions::Value options)
@@ -166,32 +168,38 @@ void LoadImage(CommandBuffer& commandBuffer, Image& image, const ImageData& imag
         MemoryUsage::GPU_ONLY,
         options
     );
+    bool generateMipLevels = (options & ImageOptions::MIPMAPS) && imageData.MipLevels.empty();
+    auto finalUsage = generateMipLevels ? ImageUsage::TRANSFER_DISTINATION : ImageUsage::SHADER_READ;
+
+    // the whole mip chain is copied by a single command
+    UploadBatch upload;
     auto allocation = stageBuffer.Submit(MakeView(imageData.ByteData));
-    commandBuffer.CopyBufferToImage(
-        BufferInfo{ stageBuffer.GetBuffer(), allocation.Offset }, 
-        ImageInfo{ image, ImageUsage::UNKNOWN, 0, 0 }
+    upload.CopyBufferToImage(
+        BufferInfo{ stageBuffer.GetBuffer(allocation), allocation.Offset }, 
+        ImageInfo{ image, ImageUsage::UNKNOWN, 0, 0 },
+        finalUsage
     );
     if (options & ImageOptions::MIPMAPS)
     {
-        if (imageData.MipLevels.empty())
-        {
-            commandBuffer.GenerateMipLevels(image, ImageUsage::TRANSFER_DISTINATION, BlitFilter::LINEAR);
-        }
-        else
+        uint32_t mipLevel = 1;
+        for (const auto& mipData : imageData.MipLevels)
         {
-            uint32_t mipLevel = 1;
-            for (const auto& mipData : imageData.MipLevels)
-            {
-                auto allocation = stageBuffer.Submit(MakeView(mipData));
-                commandBuffer.CopyBufferToImage(
-                    BufferInfo{ stageBuffer.GetBuffer(), allocation.Offset },
-                    ImageInfo{ image, ImageUsage::TRANSFER_DISTINATION, mipLevel, 0 }
-                );
-                mipLevel++;
-            }
+            auto allocation = stageBuffer.Submit(MakeView(mipData));
+            upload.CopyBufferToImage(
+                BufferInfo{ stageBuffer.GetBuffer(allocation), allocation.Offset },
+                ImageInfo{ image, ImageUsage::TRANSFER_DISTINATION, mipLevel, 0 },
+                finalUsage
+            );
+            mipLevel++;
         }
     }
-    commandBuffer.TransferLayout(image, ImageUsage::TRANSFER_DISTINATION, ImageUsage::SHADER_READ);
+    upload.Record(commandBuffer);
+
+    if (generateMipLevels)
+    {
+        commandBuffer.GenerateMipLevels(image, ImageUsage::TRANSFER_DISTINATION, BlitFilter::LINEAR);
+        commandBuffer.TransferLayout(image, ImageUsage::TRANSFER_DISTINATION, ImageUsage::SHADER_READ);
+    }
 }
 
 void LoadImage(Image& image, const std::string& filepath, ImageOptions::Value options)
@@ -231,7 +239,7 @@ void LoadCubemap(Image& image, const std::string& filepath)
         auto textureAllocation = stageBuffer.Submit(face.data(), face.size());
 
         commandBuffer.CopyBufferToImage(
-            BufferInfo{ stageBuffer.GetBuffer(), textureAllocation.Offset },
+            BufferInfo{ stageBuffer.GetBuffer(textureAllocation), textureAllocation.Offset },
             ImageInfo{ image, ImageUsage::UNKNOWN, 0, layer }
         );
     }
@@ -252,9 +260,9 @@ void LoadModel(Mesh& mesh, const std::string& filepath)
    
     auto& commandBuffer = GetCurrentVulkanContext().GetCurrentCommandBuffer();
     auto& stageBuffer = GetCurrentVulkanContext().GetCurrentStageBuffer();
+    auto& uploadManager = GetCurrentVulkanContext().GetUploadManager();
 
-    commandBuffer.Begin();
-
+    // geometry is copied on transfer queue and acquired by graphics queue when the next frame starts
     for (const auto& shape : model.Shapes)
     {
         auto& submesh = mesh.Submeshes.emplace_back();
@@ -264,11 +272,11 @@ void LoadModel(Mesh& mesh, const std::string& filepath)
             MemoryUsage::GPU_ONLY
         );
 
-        auto vertexAllocation = stageBuffer.Submit(MakeView(shape.Vertices));
-        commandBuffer.CopyBuffer(
-            BufferInfo{ stageBuffer.GetBuffer(), vertexAllocation.Offset },
+        uploadManager.GetBatch().CopyBuffer(
+            uploadManager.Stage(MakeView(shape.Vertices)),
             BufferInfo{ submesh.VertexBuffer, 0 }, 
-            vertexAllocation.Size
+            submesh.VertexBuffer.GetByteSize(),
+            BufferUsage::VERTEX_BUFFER
         );
 
         submesh.IndexBuffer.Init(
@@ -277,20 +285,16 @@ void LoadModel(Mesh& mesh, const std::string& filepath)
             MemoryUsage::GPU_ONLY
         );
 
-        auto indexAllocation = stageBuffer.Submit(MakeView(shape.Indices));
-        commandBuffer.CopyBuffer(
-            BufferInfo{ stageBuffer.GetBuffer(), indexAllocation.Offset },
+        uploadManager.GetBatch().CopyBuffer(
+            uploadManager.Stage(MakeView(shape.Indices)),
             BufferInfo{ submesh.IndexBuffer, 0 },
-            indexAllocation.Size
+            submesh.IndexBuffer.GetByteSize(),
+            BufferUsage::INDEX_BUFFER
         );
 
         submesh.MaterialIndex = shape.MaterialIndex;
     }
-
-    stageBuffer.Flush();
-    commandBuffer.End();
-    GetCurrentVulkanContext().SubmitCommandsImmediate(commandBuffer);
-    stageBuffer.Reset();
+    uploadManager.Submit();
 
     uint32_t textureIndex = 0;
     for (const auto& material : model.Materials)
@@ -311,6 +315,34 @@ void LoadModel(Mesh& mesh, const std::string& filepath)
     }
 }
 
+void CreateMaterialSets(SharedResources& resources)
+{
+    // probe pass uses the same fragment shader, so both passes share material set layout
+    auto& descriptorCache = GetCurrentVulkanContext().GetDescriptorCache();
+    auto materialSetLayout = descriptorCache.GetDescriptorSetLayout(resources.MainShader->GetSetUniforms(DescriptorSetIndex::MATERIAL));
+
+    DescriptorBinding materialDescriptors;
+    materialDescriptors
+        .Bind(0, "MaterialAlbedo", UniformType::SAMPLED_IMAGE)
+        .Bind(1, "MaterialNormal", UniformType::SAMPLED_IMAGE)
+        .Bind(2, "MaterialMetallicRoughness", UniformType::SAMPLED_IMAGE);
+
+    for (const auto& mesh : resources.WorldMeshes)
+    {
+        for (const auto& material : mesh.Materials)
+        {
+            ResolveInfo resolve;
+            resolve.Resolve("MaterialAlbedo", mesh.Textures[material.AlbedoIndex]);
+            resolve.Resolve("MaterialNormal", mesh.Textures[material.NormalIndex]);
+            resolve.Resolve("MaterialMetallicRoughness", mesh.Textures[material.MetallicRoughnessIndex]);
+            materialDescriptors.Resolve(resolve);
+
+            auto& materialSet = resources.MaterialSets.emplace_back(descriptorCache.AllocateDescriptorSet(materialSetLayout));
+            materialDescriptors.Write(materialSet, materialSetLayout);
+        }
+    }
+}
+
 class UniformSubmitRenderPass : public RenderPass
 {
     SharedResources& sharedResources;
@@ -347,7 +379,7 @@ public:
             auto& stageBuffer = GetCurrentVulkanContext().GetCurrentStageBuffer();
             auto uniformAllocation = stageBuffer.Submit(&uniformData);
             state.Commands.CopyBuffer(
-                BufferInfo{ stageBuffer.GetBuffer(), uniformAllocation.Offset }, 
+                BufferInfo{ stageBuffer.GetBuffer(uniformAllocation), uniformAllocation.Offset }, 
                 BufferInfo{ uniformBuffer, 0 },
                 uniformAllocation.Size
             );
@@ -357,7 +389,7 @@ public:
             auto& stageBuffer = GetCurrentVulkanContext().GetCurrentStageBuffer();
             auto uniformAllocation = stageBuffer.Submit(MakeView(uniformArray));
             state.Commands.CopyBuffer(
-                BufferInfo{ stageBuffer.GetBuffer(), uniformAllocation.Offset }, 
+                BufferInfo{ stageBuffer.GetBuffer(uniformAllocation), uniformAllocation.Offset }, 
                 BufferInfo{ uniformBuffer, 0 }, 
                 uniformAllocation.Size
             );
@@ -410,9 +442,7 @@ public:
 class ReflectionProbeCalculateRenderPass : public RenderPass
 {
     SharedResources& sharedResources;
-    std::vector<ImageReference> textureArray;
     std::vector<uint32_t> materialIndexOffsets;
-    std::vector<uint32_t> textureIndexOffsets;
     Sampler TextureSampler;
 public:
 
@@ -422,15 +452,10 @@ public:
         this->TextureSampler.Init(Sampler::MinFilter::LINEAR, Sampler::MagFilter::LINEAR, Sampler::AddressMode::REPEAT, Sampler::MipFilter::LINEAR);
 
         uint32_t totalMaterials = 0;
-        uint32_t totalTextures = 0;
         for (const auto& mesh : this->sharedResources.WorldMeshes)
         {
             this->materialIndexOffsets.push_back(totalMaterials);
-            this->textureIndexOffsets.push_back(totalTextures);
-            for (const auto& texture : mesh.Textures)
-                this->textureArray.push_back(std::ref(texture));
             totalMaterials += mesh.Materials.size();
-            totalTextures += mesh.Textures.size();
         }
     }
 
@@ -456,12 +481,11 @@ public:
             .Bind(1, "ReflectionProbeUniformBuffer", UniformType::UNIFORM_BUFFER)
             .Bind(2, "MeshDataUniformBuffer", UniformType::UNIFORM_BUFFER)
             .Bind(3, "MaterialUniformBuffer", UniformType::UNIFORM_BUFFER)
-            .Bind(4, "TextureArray", UniformType::SAMPLED_IMAGE)
-            .Bind(5, this->TextureSampler, UniformType::SAMPLER)
-            .Bind(6, "BRDFLUT", this->TextureSampler, UniformType::COMBINED_IMAGE_SAMPLER)
-            .Bind(7, "ReflectionProbesCubemaps", UniformType::SAMPLED_IMAGE)
-            .Bind(8, "Skybox", UniformType::SAMPLED_IMAGE)
-            .Bind(9, "SkyboxIrradiance", UniformType::SAMPLED_IMAGE);
+            .Bind(4, this->TextureSampler, UniformType::SAMPLER)
+            .Bind(5, "BRDFLUT", this->TextureSampler, UniformType::COMBINED_IMAGE_SAMPLER)
+            .Bind(6, "ReflectionProbesCubemaps", UniformType::SAMPLED_IMAGE)
+            .Bind(7, "Skybox", UniformType::SAMPLED_IMAGE)
+            .Bind(8, "SkyboxIrradiance", UniformType::SAMPLED_IMAGE);
 
         pipeline.AddOutputAttachment("OutputProbe", ClearColor{ 0.05f, 0.0f, 0.1f, 1.0f });
         pipeline.AddOutputAttachment("OutputProbeDepth", ClearDepthStencil{ });
@@ -469,7 +493,6 @@ public:
 
     virtual void ResolveResources(ResolveState resolve) override
     {
-        resolve.Resolve("TextureArray", this->textureArray);
         resolve.Resolve("BRDFLUT", this->sharedResources.BRDFLUT);
         resolve.Resolve("Skybox", this->sharedResources.Skybox);
         resolve.Resolve("SkyboxIrradiance", this->sharedResources.SkyboxIrradiance);
@@ -488,7 +511,7 @@ public:
             Vector3 ProbeGridOffset;
             uint32_t ModelIndex;
             Vector3 ProbeGridDensity;
-            uint32_t TextureOffset;
+            uint32_t Padding;
             Vector3 ProbeGridSize;
         } pushConstants;
 
@@ -499,7 +522,7 @@ public:
             {
                 pushConstants.CameraPosition = this->sharedResources.ReflectionProbes.Positions[this->sharedResources.CurrentProbeIndex];
                 pushConstants.MaterialIndex = this->materialIndexOffsets[meshIndex] + submesh.MaterialIndex;
-                pushConstants.TextureOffset = this->textureIndexOffsets[meshIndex];
+                pushConstants.Padding = 0;
                 pushConstants.ProbeGridSize = ProbeGridSize;
                 pushConstants.ModelIndex = meshIndex;
                 pushConstants.ProbeGridDensity = ProbeGridDensity;
@@ -507,6 +530,7 @@ public:
 
                 size_t indexCount = submesh.IndexBuffer.GetByteSize() / sizeof(ModelData::Index);
                 state.Commands.PushConstants(state.Pass, &pushConstants);
+                state.Commands.BindMaterial(state.Pass, this->sharedResources.MaterialSets[pushConstants.MaterialIndex]);
                 state.Commands.BindVertexBuffers(submesh.VertexBuffer);
                 state.Commands.BindIndexBufferUInt32(submesh.IndexBuffer);
                 state.Commands.DrawIndexed((uint32_t)indexCount, 1);
@@ -519,10 +543,8 @@ public:
 class OpaqueRenderPass : public RenderPass
 {    
     SharedResources& sharedResources;
-    std::vector<ImageReference> textureArray;
     std::vector<ImageReference> reflectionProbeArray;
     std::vector<uint32_t> materialIndexOffsets;
-    std::vector<uint32_t> textureIndexOffsets;
 public:
     Sampler TextureSampler;
 
@@ -532,15 +554,10 @@ public:
         this->TextureSampler.Init(Sampler::MinFilter::LINEAR, Sampler::MagFilter::LINEAR, Sampler::AddressMode::REPEAT, Sampler::MipFilter::LINEAR);
 
         uint32_t totalMaterials = 0;
-        uint32_t totalTextures = 0;
         for (const auto& mesh : this->sharedResources.WorldMeshes)
         {
             this->materialIndexOffsets.push_back(totalMaterials);
-            this->textureIndexOffsets.push_back(totalTextures);
-            for (const auto& texture : mesh.Textures)
-                this->textureArray.push_back(std::ref(texture));
             totalMaterials += mesh.Materials.size();
-            totalTextures += mesh.Textures.size();
         }
     }
 
@@ -554,6 +571,7 @@ public:
                 VertexBinding::BindingRangeAll
             }
         };
+        pipeline.State.Blend = BlendMode::DISABLED;
 
         pipeline.DeclareAttachment("Output", Format::R8G8B8A8_UNORM);
         pipeline.DeclareAttachment("OutputDepth", Format::D32_SFLOAT_S8_UINT);
@@ -563,12 +581,11 @@ public:
             .Bind(1, "ReflectionProbeUniformBuffer", UniformType::UNIFORM_BUFFER)
             .Bind(2, "MeshDataUniformBuffer", UniformType::UNIFORM_BUFFER)
             .Bind(3, "MaterialUniformBuffer", UniformType::UNIFORM_BUFFER)
-            .Bind(4, "TextureArray", UniformType::SAMPLED_IMAGE)
-            .Bind(5, this->TextureSampler, UniformType::SAMPLER)
-            .Bind(6, "BRDFLUT", this->TextureSampler, UniformType::COMBINED_IMAGE_SAMPLER)
-            .Bind(7, "ReflectionProbesCubemaps", UniformType::SAMPLED_IMAGE)
-            .Bind(8, "Skybox", UniformType::SAMPLED_IMAGE)
-            .Bind(9, "SkyboxIrradiance", UniformType::SAMPLED_IMAGE);
+            .Bind(4, this->TextureSampler, UniformType::SAMPLER)
+            .Bind(5, "BRDFLUT", this->TextureSampler, UniformType::COMBINED_IMAGE_SAMPLER)
+            .Bind(6, "ReflectionProbesCubemaps", UniformType::SAMPLED_IMAGE)
+            .Bind(7, "Skybox", UniformType::SAMPLED_IMAGE)
+            .Bind(8, "SkyboxIrradiance", UniformType::SAMPLED_IMAGE);
 
         pipeline.AddOutputAttachment("Output", ClearColor{ 0.05f, 0.0f, 0.1f, 1.0f });
         pipeline.AddOutputAttachment("OutputDepth", ClearDepthStencil{ });
@@ -586,7 +603,7 @@ public:
             Vector3 ProbeGridOffset;
             uint32_t ModelIndex;
             Vector3 ProbeGridDensity;
-            uint32_t TextureOffset;
+            uint32_t Padding;
             Vector3 ProbeGridSize;
         } pushConstants;
 
@@ -597,7 +614,7 @@ public:
             {
                 pushConstants.CameraPosition = this->sharedResources.CameraUniform.Position;
                 pushConstants.MaterialIndex = this->materialIndexOffsets[meshIndex] + submesh.MaterialIndex;
-                pushConstants.TextureOffset = this->textureIndexOffsets[meshIndex];
+                pushConstants.Padding = 0;
                 pushConstants.ProbeGridSize = ProbeGridSize;
                 pushConstants.ModelIndex = meshIndex;
                 pushConstants.ProbeGridDensity = ProbeGridDensity;
@@ -605,6 +622,7 @@ public:
 
                 size_t indexCount = submesh.IndexBuffer.GetByteSize() / sizeof(ModelData::Index);
                 state.Commands.PushConstants(state.Pass, &pushConstants);
+                state.Commands.BindMaterial(state.Pass, this->sharedResources.MaterialSets[pushConstants.MaterialIndex]);
                 state.Commands.BindVertexBuffers(submesh.VertexBuffer);
                 state.Commands.BindIndexBufferUInt32(submesh.IndexBuffer);
                 state.Commands.DrawIndexed((uint32_t)indexCount, 1);
@@ -765,6 +783,9 @@ auto CreateRenderGraph(SharedResources& resources)
         .AddRenderPass("ReflectionProbeDebugPass", std::make_unique<ReflectionProbeDebugRenderPass>(resources))
         .AddRenderPass("SkyboxPass", std::make_unique<SkyboxRenderPass>(resources))
         .AddRenderPass("ImGuiPass", std::make_unique<ImGuiRenderPass>("Output"))
+        .EnableParallelRecording("OpaquePass")
+        .EnableParallelRecording("ReflectionProbeDebugPass")
+        .EnableParallelRecording("SkyboxPass")
         .SetOutputName("Output");
 
     return renderGraphBuilder.Build();
@@ -833,6 +854,8 @@ int main()
     deviceOptions.PreferredDeviceType = DeviceType::DISCRETE_GPU;
     deviceOptions.ErrorCallback = VulkanErrorCallback;
     deviceOptions.InfoCallback = VulkanInfoCallback;
+    deviceOptions.PipelineCacheFilepath = "pipeline_cache.bin";
+    deviceOptions.EnableTransferQueue = true;
 
     Vulkan.InitializeContext(window.CreateWindowSurface(Vulkan), deviceOptions);
 
@@ -890,6 +913,7 @@ int main()
     auto& sponzaMesh = sharedResources.WorldMeshes.emplace_back();
     sponzaMesh.Data.Transform = MakeRotationMatrix(Vector3{ 0.0f, HalfPi - 0.01f, 0.0f });
     LoadModel(sponzaMesh, "../models/Sponza/glTF/Sponza.gltf");
+    CreateMaterialSets(sharedResources);
 
     Sampler ImGuiImageSampler(Sampler::MinFilter::LINEAR, Sampler::MagFilter::LINEAR, Sampler::AddressMode::REPEAT, Sampler::MipFilter::LINEAR);
 
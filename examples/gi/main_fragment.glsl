@@ -23,18 +23,22 @@ struct Fragment
     float Roughness;
 };
 
-layout(set = 0, binding = 3) uniform uMaterialBuffer
+layout(set = 2, binding = 3) uniform uMaterialBuffer
 {
     Material uMaterials[256];
 };
 
-layout(set = 0, binding = 4) uniform texture2D uTextures[4096];
-layout(set = 0, binding = 5) uniform sampler uImageSampler;
+layout(set = 2, binding = 4) uniform sampler uImageSampler;
 
-layout(set = 0, binding = 6) uniform sampler2D uBRDFLUT;
-layout(set = 0, binding = 7) uniform textureCube uLightProbes[2048];
-layout(set = 0, binding = 8) uniform textureCube uSkybox;
-layout(set = 0, binding = 9) uniform textureCube uSkyboxIrradiance;
+layout(set = 2, binding = 5) uniform sampler2D uBRDFLUT;
+layout(set = 2, binding = 6) uniform textureCube uLightProbes[2048];
+layout(set = 2, binding = 7) uniform textureCube uSkybox;
+layout(set = 2, binding = 8) uniform textureCube uSkyboxIrradiance;
+
+// textures of current material, bound per draw
+layout(set = 3, binding = 0) uniform texture2D uAlbedoTexture;
+layout(set = 3, binding = 1) uniform texture2D uNormalTexture;
+layout(set = 3, binding = 2) uniform texture2D uMetallicRoughnessTexture;
 
 layout(push_constant) uniform uPushConstant
 {
@@ -43,7 +47,7 @@ layout(push_constant) uniform uPushConstant
      vec3 uProbeGridOffset;
      uint uModelIndex;
      vec3 uProbeGridDensity;
-     uint uTextureOffset;
+     uint uPadding;
      vec3 uProbeGridSize;
 };
 
@@ -184,9 +188,9 @@ int GetProbeIndex(vec3 position, vec3 probeGridSize, vec3 probeGridDensity)
 void main() 
 {
     Material material = uMaterials[uMaterialIndex];
-    vec4 albedoColor   = texture(sampler2D(uTextures[uTextureOffset + material.AlbedoTextureIndex], uImageSampler), vTexCoord);
-    vec4 normalColor   = texture(sampler2D(uTextures[uTextureOffset + material.NormalTextureIndex], uImageSampler), vTexCoord);
-    vec4 metallicRoughnessColor = texture(sampler2D(uTextures[uTextureOffset + material.MetallicRoughnessTextureIndex], uImageSampler), vTexCoord);
+    vec4 albedoColor   = texture(sampler2D(uAlbedoTexture, uImageSampler), vTexCoord);
+    vec4 normalColor   = texture(sampler2D(uNormalTexture, uImageSampler), vTexCoord);
+    vec4 metallicRoughnessColor = texture(sampler2D(uMetallicRoughnessTexture, uImageSampler), vTexCoord);
     
     if(albedoColor.a < 0.5)
         discard;
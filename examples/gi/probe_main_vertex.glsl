@@ -24,22 +24,22 @@ layout(push_constant) uniform uPushConstant
      vec3 uProbeGridOffset;
      uint uModelIndex;
      vec3 uProbeGridDensity;
-     uint uTextureOffset;
+     uint uPadding;
      vec3 uProbeGridSize;
 };
 
-layout(set = 0, binding = 0) uniform uCameraBuffer
+layout(set = 2, binding = 0) uniform uCameraBuffer
 {
     mat4 uViewProjection;
     vec3 uCameraPosition_Unused;
 };
 
-layout(set = 0, binding = 1) uniform uProbeViewsBuffer
+layout(set = 2, binding = 1) uniform uProbeViewsBuffer
 {
     mat4 uProbeMatrices[6];
 };
 
-layout(set = 0, binding = 2) uniform uModelBuffer
+layout(set = 2, binding = 2) uniform uModelBuffer
 {
     mat4 uModels[256];
 };
@@ -5,13 +5,13 @@ layout(location = 1) in vec3 vNormal;
 
 layout(location = 0) out vec4 oColor;
 
-layout(set = 0, binding = 0) uniform uCameraBuffer
+layout(set = 2, binding = 0) uniform uCameraBuffer
 {
     mat4 uViewProjection;
     vec3 uCameraPosition;
 };
 
-layout(set = 0, binding = 1) uniform textureCube uProbeArray[2048];
+layout(set = 2, binding = 1) uniform textureCube uProbeArray[2048];
 
 layout(push_constant) uniform uProbeContant
 {
@@ -20,7 +20,7 @@ layout(push_constant) uniform uProbeContant
     uint uProbeCubemapIndex;
 };
 
-layout(set = 0, binding = 2) uniform sampler uTextureSampler;
+layout(set = 2, binding = 2) uniform sampler uTextureSampler;
 
 void main()
 {
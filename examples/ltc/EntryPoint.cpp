@@ -52,6 +52,7 @@ struct Mesh
     std::vector<Submesh> Submeshes;
     std::vector<Material> Materials;
     std::vector<Image> Textures;
+    std::vector<uint32_t> TextureHeapIndices; // bindless heap index of each texture
 };
 
 struct CameraUniformData
@@ -78,14 +79,12 @@ struct LightUniformData
 
 struct SharedResources
 {
-    Buffer CameraUniformBuffer;
-    Buffer MeshDataUniformBuffer;
     Buffer MaterialUniformBuffer;
-    Buffer LightUniformBuffer;
     Mesh Sponza;
     Image LookupLTCMatrix;
     Image LookupLTCAmplitude;
     std::vector<Image> LightTextures;
+    Sampler LookupSampler;
     CameraUniformData CameraUniform;
     ModelUniformData ModelUniform;
     std::array<LightUniformData, MaxLightCount> LightUniformArray;
@@ -105,7 +104,7 @@ void LoadImage(CommandBuffer& commandBuffer, Image& image, const ImageData& imag
     );
     auto allocation = stageBuffer.Submit(MakeView(imageData.ByteData));
     commandBuffer.CopyBufferToImage(
-        BufferInfo{ stageBuffer.GetBuffer(), allocation.Offset }, 
+        BufferInfo{ stageBuffer.GetBuffer(allocation), allocation.Offset }, 
         ImageInfo{ image, ImageUsage::UNKNOWN, 0, 0 }
     );
     if (options & ImageOptions::MIPMAPS)
@@ -121,7 +120,7 @@ void LoadImage(CommandBuffer& commandBuffer, Image& image, const ImageData& imag
             {
                 auto allocation = stageBuffer.Submit(MakeView(mipData));
                 commandBuffer.CopyBufferToImage(
-                    BufferInfo{ stageBuffer.GetBuffer(), allocation.Offset },
+                    BufferInfo{ stageBuffer.GetBuffer(allocation), allocation.Offset },
                     ImageInfo{ image, ImageUsage::TRANSFER_DISTINATION, mipLevel, 0 }
                 );
                 mipLevel++;
@@ -166,7 +165,7 @@ void LoadModelGLTF(Mesh& mesh, const std::string& filepath)
 
         auto vertexAllocation = stageBuffer.Submit(MakeView(shape.Vertices));
         commandBuffer.CopyBuffer(
-            BufferInfo{ stageBuffer.GetBuffer(), vertexAllocation.Offset },
+            BufferInfo{ stageBuffer.GetBuffer(vertexAllocation), vertexAllocation.Offset },
             BufferInfo{ submesh.VertexBuffer, 0 }, 
             vertexAllocation.Size
         );
@@ -179,7 +178,7 @@ void LoadModelGLTF(Mesh& mesh, const std::string& filepath)
 
         auto indexAllocation = stageBuffer.Submit(MakeView(shape.Indices));
         commandBuffer.CopyBuffer(
-            BufferInfo{ stageBuffer.GetBuffer(), indexAllocation.Offset },
+            BufferInfo{ stageBuffer.GetBuffer(indexAllocation), indexAllocation.Offset },
             BufferInfo{ submesh.IndexBuffer, 0 },
             indexAllocation.Size
         );
@@ -192,6 +191,7 @@ void LoadModelGLTF(Mesh& mesh, const std::string& filepath)
     GetCurrentVulkanContext().SubmitCommandsImmediate(commandBuffer);
     stageBuffer.Reset();
 
+    auto& bindlessHeap = GetCurrentVulkanContext().GetBindlessHeap();
     uint32_t textureIndex = 0;
     for (const auto& material : model.Materials)
     {
@@ -201,8 +201,13 @@ void LoadModelGLTF(Mesh& mesh, const std::string& filepath)
         LoadImage(commandBuffer, mesh.Textures.emplace_back(), material.NormalTexture, ImageOptions::MIPMAPS);
         LoadImage(commandBuffer, mesh.Textures.emplace_back(), material.MetallicRoughness, ImageOptions::MIPMAPS);
 
+        // shader samples material textures from bindless heap, so material refers to them by heap indices
+        for (size_t i = textureIndex; i < mesh.Textures.size(); i++)
+            mesh.TextureHeapIndices.push_back(bindlessHeap.RegisterImage(mesh.Textures[i]));
+
         constexpr float AppliedRoughnessScale = 0.5f;
-        mesh.Materials.push_back(Mesh::Material{ textureIndex, textureIndex + 1, textureIndex + 2, AppliedRoughnessScale * material.RoughnessScale });
+        const auto& heapIndices = mesh.TextureHeapIndices;
+        mesh.Materials.push_back(Mesh::Material{ heapIndices[textureIndex], heapIndices[textureIndex + 1], heapIndices[textureIndex + 2], AppliedRoughnessScale * material.RoughnessScale });
         textureIndex += 3;
 
         stageBuffer.Flush();
@@ -225,46 +230,27 @@ public:
 
     virtual void SetupPipeline(PipelineState pipeline) override
     {
-        pipeline.AddDependency("CameraUniformBuffer", BufferUsage::TRANSFER_DESTINATION);
-        pipeline.AddDependency("MeshDataUniformBuffer", BufferUsage::TRANSFER_DESTINATION);
-        pipeline.AddDependency("LightUniformBuffer", BufferUsage::TRANSFER_DESTINATION);
         pipeline.AddDependency("MaterialUniformBuffer", BufferUsage::TRANSFER_DESTINATION);
     }
 
     virtual void ResolveResources(ResolveState resolve) override
     {
-        resolve.Resolve("CameraUniformBuffer", this->sharedResources.CameraUniformBuffer);
-        resolve.Resolve("MeshDataUniformBuffer", this->sharedResources.MeshDataUniformBuffer);
-        resolve.Resolve("LightUniformBuffer", this->sharedResources.LightUniformBuffer);
         resolve.Resolve("MaterialUniformBuffer", this->sharedResources.MaterialUniformBuffer);
     }
 
     virtual void OnRender(RenderPassState state) override
     {
-        auto FillUniform = [&state](const auto& uniformData, const auto& uniformBuffer) mutable
-        {
-            auto& stageBuffer = GetCurrentVulkanContext().GetCurrentStageBuffer();
-            auto uniformAllocation = stageBuffer.Submit(&uniformData);
-            state.Commands.CopyBuffer(
-                BufferInfo{ stageBuffer.GetBuffer(), uniformAllocation.Offset }, 
-                BufferInfo{ uniformBuffer, 0 },
-                uniformAllocation.Size
-            );
-        };
         auto FillUniformArray = [&state](const auto& uniformArray, const auto& uniformBuffer) mutable
         {
             auto& stageBuffer = GetCurrentVulkanContext().GetCurrentStageBuffer();
             auto uniformAllocation = stageBuffer.Submit(MakeView(uniformArray));
             state.Commands.CopyBuffer(
-                BufferInfo{ stageBuffer.GetBuffer(), uniformAllocation.Offset }, 
+                BufferInfo{ stageBuffer.GetBuffer(uniformAllocation), uniformAllocation.Offset }, 
                 BufferInfo{ uniformBuffer, 0 }, 
                 uniformAllocation.Size
             );
         };
 
-        FillUniform(this->sharedResources.CameraUniform, this->sharedResources.CameraUniformBuffer);
-        FillUniform(this->sharedResources.ModelUniform, this->sharedResources.MeshDataUniformBuffer);
-        FillUniformArray(this->sharedResources.LightUniformArray, this->sharedResources.LightUniformBuffer);
         FillUniformArray(this->sharedResources.Sponza.Materials, this->sharedResources.MaterialUniformBuffer);
     }
 };
@@ -272,8 +258,6 @@ public:
 class OpaqueRenderPass : public RenderPass
 {    
     SharedResources& sharedResources;
-    std::vector<ImageReference> textureArray;
-    std::vector<ImageReference> lightArray;
 public:
     Sampler TextureSampler;
 
@@ -281,15 +265,6 @@ public:
         : sharedResources(sharedResources)
     {
         this->TextureSampler.Init(Sampler::MinFilter::LINEAR, Sampler::MagFilter::LINEAR, Sampler::AddressMode::REPEAT, Sampler::MipFilter::LINEAR);
-
-        for (const auto& texture : this->sharedResources.Sponza.Textures)
-        {
-            this->textureArray.push_back(std::ref(texture));
-        }
-        for (const auto& light : this->sharedResources.LightTextures)
-        {
-            this->lightArray.push_back(std::ref(light));
-        }
     }
 
     virtual void SetupPipeline(PipelineState pipeline) override
@@ -306,37 +281,44 @@ public:
             }
         };
 
-        pipeline.DeclareAttachment("Output", Format::R8G8B8A8_UNORM);
+        pipeline.DeclareAttachment("HDRColor", Format::R16G16B16A16_SFLOAT);
         pipeline.DeclareAttachment("OutputDepth", Format::D32_SFLOAT_S8_UINT);
 
+        // per-frame uniforms are written to uniform ring, descriptors cover one allocation each
         pipeline.DescriptorBindings
-            .Bind(0, "CameraUniformBuffer", UniformType::UNIFORM_BUFFER)
-            .Bind(1, "MeshDataUniformBuffer", UniformType::UNIFORM_BUFFER)
+            .Bind(0, "CameraUniformBuffer", UniformType::UNIFORM_BUFFER_DYNAMIC, sizeof(CameraUniformData))
+            .Bind(1, "MeshDataUniformBuffer", UniformType::UNIFORM_BUFFER_DYNAMIC, sizeof(ModelUniformData))
             .Bind(2, "MaterialUniformBuffer", UniformType::UNIFORM_BUFFER)
-            .Bind(3, "LightUniformBuffer", UniformType::UNIFORM_BUFFER)
-            .Bind(4, "TextureArray", UniformType::SAMPLED_IMAGE)
-            .Bind(5, this->TextureSampler, UniformType::SAMPLER)
-            .Bind(6, "LookupLTCMatrix", this->TextureSampler, UniformType::COMBINED_IMAGE_SAMPLER)
-            .Bind(7, "LookupLTCAmplitude", this->TextureSampler, UniformType::COMBINED_IMAGE_SAMPLER)
-            .Bind(8, "LightArray", UniformType::SAMPLED_IMAGE);
-
-        pipeline.AddOutputAttachment("Output", ClearColor{ 0.05f, 0.0f, 0.1f, 1.0f });
+            .Bind(3, "LightUniformBuffer", UniformType::UNIFORM_BUFFER_DYNAMIC, sizeof(LightUniformData) * MaxLightCount)
+            .Bind(4, this->TextureSampler, UniformType::SAMPLER);
+
+        pipeline.AddOutputAttachment("HDRColor", ClearColor{ 0.05f, 0.0f, 0.1f, 1.0f });
         pipeline.AddOutputAttachment("OutputDepth", ClearDepthStencil{ });
     }
 
     virtual void ResolveResources(ResolveState resolve) override
     {
-        resolve.Resolve("TextureArray", this->textureArray);
-        resolve.Resolve("LookupLTCMatrix", this->sharedResources.LookupLTCMatrix);
-        resolve.Resolve("LookupLTCAmplitude", this->sharedResources.LookupLTCAmplitude);
-        resolve.Resolve("LightArray", this->lightArray);
+        // each virtual frame has its own ring, so buffers are resolved every frame
+        const auto& uniformRing = GetCurrentVulkanContext().GetCurrentUniformRing().GetBuffer();
+        resolve.Resolve("CameraUniformBuffer", uniformRing);
+        resolve.Resolve("MeshDataUniformBuffer", uniformRing);
+        resolve.Resolve("LightUniformBuffer", uniformRing);
     }
     
     virtual void OnRender(RenderPassState state) override
     {
-        auto& output = state.GetAttachment("Output");
+        auto& output = state.GetAttachment("HDRColor");
         state.Commands.SetRenderArea(output);
 
+        auto& uniformRing = GetCurrentVulkanContext().GetCurrentUniformRing();
+        auto cameraAllocation = uniformRing.Submit(&this->sharedResources.CameraUniform);
+        auto modelAllocation = uniformRing.Submit(&this->sharedResources.ModelUniform);
+        auto lightAllocation = uniformRing.Submit(MakeView(this->sharedResources.LightUniformArray));
+
+        // offsets are ordered by binding
+        std::array dynamicOffsets = { cameraAllocation.Offset, modelAllocation.Offset, lightAllocation.Offset };
+        state.Commands.BindDynamicOffsets(state.Pass, dynamicOffsets);
+
         for (const auto& submesh : this->sharedResources.Sponza.Submeshes)
         {
             size_t indexCount = submesh.IndexBuffer.GetByteSize() / sizeof(ModelData::Index);
@@ -348,12 +330,55 @@ public:
     }
 };
 
+class GammaCorrectionRenderPass : public RenderPass
+{
+public:
+    virtual void SetupPipeline(PipelineState pipeline) override
+    {
+        pipeline.Shader = std::make_unique<GraphicShader>(
+            ShaderLoader::LoadFromSourceFile("gamma_vertex.glsl", ShaderType::VERTEX, ShaderLanguage::GLSL),
+            ShaderLoader::LoadFromSourceFile("gamma_fragment.glsl", ShaderType::FRAGMENT, ShaderLanguage::GLSL)
+        );
+
+        pipeline.DeclareAttachment("Output", Format::R8G8B8A8_UNORM);
+
+        // input attachment keeps opaque and gamma passes in one render pass, HDR color never leaves tile memory
+        pipeline.DescriptorBindings
+            .Bind(0, "HDRColor", UniformType::INPUT_ATTACHMENT);
+
+        pipeline.AddOutputAttachment("Output", AttachmentState::DISCARD_COLOR);
+    }
+
+    virtual void OnRender(RenderPassState state) override
+    {
+        auto& output = state.GetAttachment("Output");
+        state.Commands.SetRenderArea(output);
+
+        constexpr uint32_t FullscreenTriangleVertexCount = 3;
+        state.Commands.Draw(FullscreenTriangleVertexCount, 1);
+    }
+};
+
 auto CreateRenderGraph(SharedResources& resources)
 {
+    // images are loaded before graph is created, so they do not need graph barriers
+    DescriptorBinding frameDescriptors;
+    frameDescriptors
+        .Bind(0, "LookupLTCMatrix", resources.LookupSampler, UniformType::COMBINED_IMAGE_SAMPLER)
+        .Bind(1, "LookupLTCAmplitude", resources.LookupSampler, UniformType::COMBINED_IMAGE_SAMPLER)
+        .Bind(2, "LightArray", UniformType::SAMPLED_IMAGE);
+
     RenderGraphBuilder renderGraphBuilder;
     renderGraphBuilder
+        .SetFrameDescriptors(std::move(frameDescriptors), [&resources](ResolveInfo& resolve)
+        {
+            resolve.Resolve("LookupLTCMatrix", resources.LookupLTCMatrix);
+            resolve.Resolve("LookupLTCAmplitude", resources.LookupLTCAmplitude);
+            resolve.Resolve("LightArray", resources.LightTextures);
+        })
         .AddRenderPass("UniformSubmitPass", std::make_unique<UniformSubmitRenderPass>(resources))
         .AddRenderPass("OpaquePass", std::make_unique<OpaqueRenderPass>(resources))
+        .AddRenderPass("GammaCorrectionPass", std::make_unique<GammaCorrectionRenderPass>())
         .AddRenderPass("ImGuiPass", std::make_unique<ImGuiRenderPass>("Output"))
         .SetOutputName("Output");
 
@@ -440,14 +465,12 @@ int main()
     deviceOptions.PreferredDeviceType = DeviceType::DISCRETE_GPU;
     deviceOptions.ErrorCallback = VulkanErrorCallback;
     deviceOptions.InfoCallback = VulkanInfoCallback;
+    deviceOptions.PipelineCacheFilepath = "pipeline_cache.bin";
 
     Vulkan.InitializeContext(window.CreateWindowSurface(Vulkan), deviceOptions);
 
     SharedResources sharedResources{
-        Buffer{ sizeof(CameraUniformData), BufferUsage::UNIFORM_BUFFER | BufferUsage::TRANSFER_DESTINATION, MemoryUsage::GPU_ONLY },
-        Buffer{ sizeof(ModelUniformData), BufferUsage::UNIFORM_BUFFER | BufferUsage::TRANSFER_DESTINATION, MemoryUsage::GPU_ONLY },
         Buffer{ sizeof(Mesh::Material) * MaxMaterialCount, BufferUsage::UNIFORM_BUFFER | BufferUsage::TRANSFER_DESTINATION, MemoryUsage::GPU_ONLY },
-        Buffer{ sizeof(LightUniformData) * MaxLightCount, BufferUsage::UNIFORM_BUFFER | BufferUsage::TRANSFER_DESTINATION, MemoryUsage::GPU_ONLY },
         { }, // sponza
         { }, // ltc matrix lookup
         { }, // ltc amplitude lookup
@@ -458,6 +481,7 @@ int main()
     LoadImage(sharedResources.LookupLTCAmplitude, "../textures/ltc_amplitude.dds", ImageOptions::DEFAULT);
     LoadImage(sharedResources.LightTextures.emplace_back(), "../textures/white_filtered.dds", ImageOptions::MIPMAPS);
     LoadImage(sharedResources.LightTextures.emplace_back(), "../textures/stained_glass_filtered.dds", ImageOptions::MIPMAPS);
+    sharedResources.LookupSampler.Init(Sampler::MinFilter::LINEAR, Sampler::MagFilter::LINEAR, Sampler::AddressMode::REPEAT, Sampler::MipFilter::LINEAR);
 
     std::unique_ptr<RenderGraph> renderGraph = CreateRenderGraph(sharedResources);
 
@@ -503,24 +527,14 @@ int main()
     
     ImGuiVulkanContext::Init(window, renderGraph->GetNodeByName("ImGuiPass").PassNative.RenderPassHandle);
 
+    // material texture indices are bindless heap indices
     std::map<size_t, ImTextureID> ImGuiRegisteredImages;
-    for (const auto& material : sharedResources.Sponza.Materials)
+    for (size_t textureIndex = 0; textureIndex < sharedResources.Sponza.Textures.size(); textureIndex++)
     {
-        if (ImGuiRegisteredImages.find(material.AlbedoIndex) == ImGuiRegisteredImages.end())
-            ImGuiRegisteredImages.emplace(
-                material.AlbedoIndex,
-                ImGuiVulkanContext::GetTextureId(sharedResources.Sponza.Textures[material.AlbedoIndex])
-            );
-        if (ImGuiRegisteredImages.find(material.NormalIndex) == ImGuiRegisteredImages.end())
-            ImGuiRegisteredImages.emplace(
-                material.NormalIndex,
-                ImGuiVulkanContext::GetTextureId(sharedResources.Sponza.Textures[material.NormalIndex])
-            );
-        if (ImGuiRegisteredImages.find(material.MetallicRoughnessIndex) == ImGuiRegisteredImages.end())
-            ImGuiRegisteredImages.emplace(
-                material.MetallicRoughnessIndex,
-                ImGuiVulkanContext::GetTextureId(sharedResources.Sponza.Textures[material.MetallicRoughnessIndex])
-            );
+        ImGuiRegisteredImages.emplace(
+            sharedResources.Sponza.TextureHeapIndices[textureIndex],
+            ImGuiVulkanContext::GetTextureId(sharedResources.Sponza.Textures[textureIndex])
+        );
     }
 
     while (!window.ShouldClose())
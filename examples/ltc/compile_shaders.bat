@@ -1,2 +1,4 @@
 glslangValidator -V -S vert main_vertex.glsl -o main_vertex.spv
-glslangValidator -V -S frag main_fragment.glsl -o main_fragment.spv
\ No newline at end of file
+glslangValidator -V -S frag main_fragment.glsl -o main_fragment.spv
+glslangValidator -V -S vert gamma_vertex.glsl -o gamma_vertex.spv
+glslangValidator -V -S frag gamma_fragment.glsl -o gamma_fragment.spv
\ No newline at end of file
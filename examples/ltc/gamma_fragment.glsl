@@ -0,0 +1,14 @@
+#version 460
+
+#define GAMMA 2.2
+
+layout(location = 0) out vec4 oColor;
+
+// written by opaque pass in the same render pass, read at the same pixel
+layout(input_attachment_index = 0, set = 2, binding = 0) uniform subpassInput uHDRColor;
+
+void main()
+{
+    vec3 color = subpassLoad(uHDRColor).rgb;
+    oColor = vec4(pow(color, vec3(1.0 / GAMMA)), 1.0);
+}
\ No newline at end of file
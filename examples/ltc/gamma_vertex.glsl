@@ -0,0 +1,13 @@
+#version 460
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+void main()
+{
+    // single triangle covering the whole screen
+    vec2 position = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(2.0 * position - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
@@ -8,7 +8,7 @@ layout(location = 2) in mat3 vNormalMatrix;
 
 layout(location = 0) out vec4 oColor;
 
-layout(set = 0, binding = 0) uniform uCameraBuffer
+layout(set = 2, binding = 0) uniform uCameraBuffer
 {
     mat4 uViewProjection;
     vec3 uCameraPosition;
@@ -22,7 +22,7 @@ struct Material
     float RoughnessScale;
 };
 
-layout(set = 0, binding = 2) uniform uMaterialArray
+layout(set = 2, binding = 2) uniform uMaterialArray
 {
     Material uMaterials[256];
 };
@@ -41,18 +41,21 @@ struct LightData
 };
 
 #define LIGHT_COUNT 4
-#define MATERIAL_TEXTURE_COUNT 512
 
-layout(set = 0, binding = 3) uniform uLightArray
+layout(set = 2, binding = 3) uniform uLightArray
 {
     LightData uLights[LIGHT_COUNT];
 };
 
-layout(set = 0, binding = 4) uniform texture2D uTextures[MATERIAL_TEXTURE_COUNT];
-layout(set = 0, binding = 5) uniform sampler uTextureSampler;
-layout(set = 0, binding = 6) uniform sampler2D uLookupLTCMatrix;
-layout(set = 0, binding = 7) uniform sampler2D uLookupLTCAmplitude;
-layout(set = 0, binding = 8) uniform texture2D uLightTextures[LIGHT_COUNT];
+layout(set = 2, binding = 4) uniform sampler uTextureSampler;
+
+// lookup tables and light textures do not change, so they are written once per frame for whole render graph
+layout(set = 0, binding = 0) uniform sampler2D uLookupLTCMatrix;
+layout(set = 0, binding = 1) uniform sampler2D uLookupLTCAmplitude;
+layout(set = 0, binding = 2) uniform texture2D uLightTextures[LIGHT_COUNT];
+
+// material textures are registered in bindless heap, see BindlessHeap
+layout(set = 1, binding = 0) uniform texture2D uImages[];
 
 struct Fragment
 {
@@ -355,9 +358,9 @@ void InitRectPoints(Rect rect, out vec3 points[4])
 void main()
 {
     Material material = uMaterials[uMaterialIndex];
-    vec4 albedoColor = texture(sampler2D(uTextures[material.AlbedoIndex], uTextureSampler), vTexCoord).rgba;
-    vec3 normalColor = texture(sampler2D(uTextures[material.NormalIndex], uTextureSampler), vTexCoord).rgb;
-    vec3 metallicRoughnessColor = texture(sampler2D(uTextures[material.MetallicRoughnessIndex], uTextureSampler), vTexCoord).rgb;
+    vec4 albedoColor = texture(sampler2D(uImages[nonuniformEXT(material.AlbedoIndex)], uTextureSampler), vTexCoord).rgba;
+    vec3 normalColor = texture(sampler2D(uImages[nonuniformEXT(material.NormalIndex)], uTextureSampler), vTexCoord).rgb;
+    vec3 metallicRoughnessColor = texture(sampler2D(uImages[nonuniformEXT(material.MetallicRoughnessIndex)], uTextureSampler), vTexCoord).rgb;
 
     if (albedoColor.a < 0.5)
         discard;
@@ -463,5 +466,6 @@ void main()
         totalColor = pow(lightColor, vec3(GAMMA));
     }
 
-    oColor = vec4(pow(totalColor, vec3(1.0 / GAMMA)), 1.0);
+    // gamma correction is applied by gamma pass
+    oColor = vec4(totalColor, 1.0);
 }
\ No newline at end of file
@@ -15,13 +15,13 @@ layout(location = 0) out vec3 vPosition;
 layout(location = 1) out vec2 vTexCoord;
 layout(location = 2) out mat3 vNormalMatrix;
 
-layout(set = 0, binding = 0) uniform uCameraBuffer
+layout(set = 2, binding = 0) uniform uCameraBuffer
 {
     mat4 uViewProjection;
     vec3 uCameraPosition;
 };
 
-layout(set = 0, binding = 1) uniform uModelBuffer
+layout(set = 2, binding = 1) uniform uModelBuffer
 {
     mat3 uModel;
 };